@@ -0,0 +1,353 @@
+#include "BinaryManipulation.h"
+#include "Formatting.h"
+#include "TextCodecs.h"
+#include "NetworkHeaders.h"
+#include "Pcap.h"
+#include "i960.h"
+#include "i960Disassembler.h"
+#include "i960Encoder.h"
+#include "i960Interpreter.h"
+#include "i960Stream.h"
+#include "Mmu.h"
+#include "CacheSimulator.h"
+#include "GuestMemory.h"
+#include "Watchpoints.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using BinaryManipulation::i960::Ordinal;
+using BinaryManipulation::i960::OpcodeExtraction;
+
+std::vector<Ordinal> makeWords(std::size_t count) {
+    std::vector<Ordinal> words(count);
+    uint64_t state = 0x0123'4567'89AB'CDEF;
+    for (auto& word : words) {
+        state = (state * 6364136223846793005ull) + 1442695040888963407ull;
+        word = static_cast<Ordinal>(state >> 32);
+    }
+    return words;
+}
+template<typename Fn>
+void report(const char* name, std::size_t count, Fn fn, const char* unit = "word") {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << (elapsed.count() / count) << " ns/" << unit << std::endl;
+}
+void benchmarkFormatting(std::ostream& sink) {
+    std::cout << "Formatting " << OpcodeExtraction::NumberOfPatterns << " fields per word" << std::endl;
+    auto words = makeWords(1 << 22);
+    report("iostream std::hex", words.size(), [&] {
+        for (auto word : words) {
+            auto [standard, extended] = OpcodeExtraction::decode(word);
+            sink << std::hex << "0x" << static_cast<unsigned>(standard) << " 0x" << extended << '\n';
+        }
+    });
+    report("toChars into a FormatBuffer", words.size(), [&] {
+        char storage[64 * 1024];
+        BinaryManipulation::FormatBuffer buffer(storage);
+        for (auto word : words) {
+            if (buffer.full(BinaryManipulation::FormattedLengthBound<OpcodeExtraction> + 1)) {
+                sink.write(buffer.view().data(), buffer.size());
+                buffer.clear();
+            }
+            buffer.write<OpcodeExtraction>(word);
+            buffer.write('\n');
+        }
+        sink.write(buffer.view().data(), buffer.size());
+    });
+}
+void benchmarkHexParsing() {
+    auto words = makeWords(1 << 22);
+    std::string text(BinaryManipulation::hexEncodedLength<Ordinal>(words.size()) + words.size(), '\n');
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        BinaryManipulation::hexEncode<Ordinal>(std::span<const Ordinal>(&words[i], 1), std::span<char>(text.data() + (i * 9), 8));
+    }
+    std::cout << "Parsing " << (text.size() >> 20) << " MiB of hex words" << std::endl;
+    std::vector<Ordinal> parsed(words.size());
+    std::vector<OpcodeExtraction::SliceType> fields(words.size());
+    report("strtoul then decode", words.size(), [&] {
+        const char* current = text.c_str();
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            char* end = nullptr;
+            fields[i] = OpcodeExtraction::decode(static_cast<Ordinal>(std::strtoul(current, &end, 16)));
+            current = end;
+        }
+    });
+    report("parseHexTokens", words.size(), [&] { BinaryManipulation::parseHexTokens<Ordinal>(text, parsed); });
+    report("parseHexFields", words.size(), [&] { BinaryManipulation::parseHexFields<OpcodeExtraction>(text, fields); });
+    if (parsed != words) {
+        std::cout << "parseHexTokens produced the wrong words!" << std::endl;
+    }
+}
+void benchmarkCaptureParsing() {
+    constexpr std::size_t PacketCount = 1 << 21;
+    auto path = std::filesystem::temp_directory_path() / "BinaryManipulatorBenchmark.pcap";
+    {
+        std::vector<uint8_t> capture;
+        BinaryManipulation::writePcapHeader(capture, BinaryManipulation::PcapLinkType::Ethernet);
+        uint8_t frame[14 + 20 + 20 + 64] { };
+        frame[12] = 0x08;
+        auto words = makeWords(PacketCount);
+        for (std::size_t i = 0; i < PacketCount; ++i) {
+            // alternate TCP and UDP with varying flags, ports, and payload sizes
+            auto tcp = (words[i] & 1) != 0;
+            auto payload = words[i] % 64;
+            auto transport = tcp ? 20u : 8u;
+            auto total = 20 + transport + payload;
+            uint8_t ip[20] { 0x45, 0, uint8_t(total >> 8), uint8_t(total), 0, 0, 0x40, 0, 64, uint8_t(tcp ? 6 : 17) };
+            std::memcpy(frame + 14, ip, sizeof(ip));
+            std::memcpy(frame + 34, &words[i], sizeof(Ordinal));
+            if (tcp) {
+                frame[34 + 12] = 0x50;
+                frame[34 + 13] = static_cast<uint8_t>(words[i] >> 8);
+            } else {
+                frame[34 + 4] = static_cast<uint8_t>((8 + payload) >> 8);
+                frame[34 + 5] = static_cast<uint8_t>(8 + payload);
+            }
+            BinaryManipulation::writePcapRecord(capture, static_cast<uint32_t>(i), 0, std::span<const uint8_t>(frame, 14 + total));
+        }
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(capture.data()), static_cast<std::streamsize>(capture.size()));
+        std::cout << "Parsing a " << (capture.size() >> 20) << " MiB capture of " << PacketCount << " packets" << std::endl;
+    }
+    std::size_t syns = 0, udpBytes = 0, packets = 0;
+    report("map and decode", PacketCount, [&] {
+        BinaryManipulation::PcapFile capture(path.c_str());
+        for (const auto& packet : capture) {
+            auto decoded = BinaryManipulation::Network::decodeEthernet(packet.data);
+            if (decoded.protocol == BinaryManipulation::Network::IPv4::ProtocolTCP) {
+                syns += (!decoded.transport.empty() && BinaryManipulation::Network::TCP::SYN::decode(decoded.transport));
+            } else if (!decoded.transport.empty()) {
+                udpBytes += BinaryManipulation::Network::UDP::Length::decode(decoded.transport);
+            }
+            ++packets;
+        }
+    }, "packet");
+    std::cout << "    " << std::dec << packets << " packets, " << syns << " SYNs, " << udpBytes << " UDP bytes" << std::endl;
+    std::filesystem::remove(path);
+}
+void benchmarkDisassembly() {
+    namespace i960 = BinaryManipulation::i960;
+    auto words = makeWords(1 << 24);
+    std::vector<i960::Instruction> block(4096);
+    std::size_t instructions = 0;
+    uint32_t checksum = 0;
+    report("decodeInstructions", words.size(), [&] {
+        std::span<const Ordinal> remaining(words);
+        while (!remaining.empty()) {
+            auto [consumed, count] = i960::decodeInstructions(remaining, block);
+            if (count == 0) {
+                break;
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                checksum += static_cast<uint32_t>(block[i].displacement) + block[i].opcode;
+            }
+            instructions += count;
+            remaining = remaining.subspan(consumed);
+        }
+    });
+    std::cout << "    " << instructions << " instructions, checksum " << checksum << std::endl;
+    i960::StreamDecoder decoder;
+    i960::InstructionBuffer buffer;
+    buffer.reserve(words.size() + 1);
+    report("StreamDecoder", words.size(), [&] { decoder.decode(words, buffer); });
+    uint32_t streamChecksum = 0;
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        streamChecksum += static_cast<uint32_t>(buffer.displacements()[i]) + buffer.opcodes()[i];
+    }
+    std::cout << "    " << buffer.size() << " instructions, checksum " << streamChecksum << std::endl;
+    for (unsigned threads : { 1u, 0u }) {
+        std::size_t bytes = 0;
+        report(threads == 1 ? "disassembleImage, one thread" : "disassembleImage, all threads", words.size(), [&] {
+            i960::disassembleImage(words, 0, [&bytes](std::string_view text) { bytes += text.size(); return true; }, threads);
+        });
+        std::cout << "    " << bytes << " bytes of text" << std::endl;
+    }
+}
+void benchmarkEncoding() {
+    namespace i960 = BinaryManipulation::i960;
+    auto words = makeWords(1 << 24);
+    std::vector<i960::Instruction> decoded(words.size());
+    auto [consumed, count] = i960::decodeInstructions(words, decoded);
+    std::vector<i960::InstructionFields> fields(count);
+    std::transform(decoded.begin(), decoded.begin() + count, fields.begin(), i960::fieldsOf);
+    std::vector<Ordinal> output(consumed);
+    i960::EmitProgress progress { };
+    report("emitInstructions", count, [&] { progress = i960::emitInstructions(fields, output); }, "instruction");
+    std::cout << "    " << progress.instructions << " instructions in " << progress.words << " words" << std::endl;
+}
+std::vector<Ordinal> makeInterpreterLoop() {
+    namespace i960 = BinaryManipulation::i960;
+    using i960::g0; using i960::g1; using i960::g2; using i960::g3; using i960::g4; using i960::g5;
+    // an endless loop of arithmetic, memory and compare and branch
+    const std::vector<i960::InstructionFields> program {
+        i960::mem("lda", g5, i960::MemoryOperand::absolute(0x800)),
+        i960::reg("addo", g1, g0, g0), // 0x4
+        i960::reg("addi", 1, g1, g1),
+        i960::reg("xor", g0, g2, g2),
+        i960::reg("shlo", 3, g2, g3),
+        i960::mem("st", g3, i960::MemoryOperand::based(g5, 0x40)),
+        i960::mem("ld", g4, i960::MemoryOperand::based(g5, 0x40)),
+        i960::reg("cmpo", g4, g3, i960::r0),
+        i960::ctrl("be", -28),
+    };
+    std::vector<Ordinal> words(i960::encodedLength(program));
+    i960::emitInstructions(program, words);
+    return words;
+}
+void benchmarkInterpreter() {
+    namespace i960 = BinaryManipulation::i960;
+    using i960::g0;
+    i960::Interpreter interpreter(16);
+    interpreter.load(makeInterpreterLoop(), 0);
+    interpreter.arithmeticControls().write(i960::IntegerOverflowMask::encode(0, true));
+    constexpr std::size_t Instructions = 50'000'000;
+    auto stop = i960::StopReason::Limit;
+    auto start = std::chrono::steady_clock::now();
+    report("interpreter", Instructions, [&] { stop = interpreter.run(Instructions); }, "instruction");
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "    " << (interpreter.executed() / elapsed.count() / 1e6) << " M instructions/s, stopped with "
+        << static_cast<int>(stop) << ", g0 = " << interpreter.reg(g0) << std::endl;
+}
+void benchmarkTranslation() {
+    using namespace BinaryManipulation;
+    using Pte = PageTableEntry32;
+    // 1024 pages mapped from 0x0040'0000 through the table at 0x2000
+    constexpr uint32_t Pages = 1024;
+    std::vector<uint8_t> memory(0x40'0000);
+    auto setEntry = [&memory](uint32_t address, uint32_t value) { std::memcpy(memory.data() + address, &value, sizeof(value)); };
+    setEntry(0x1000 + 1 * 4, Pte::Layout::encode(true, true, true, false, false, 0x2));
+    for (uint32_t page = 0; page < Pages; ++page) {
+        setEntry(0x2000 + page * 4, Pte::Layout::encode(true, true, true, false, false, 0x100 + page));
+    }
+    // runs of eight sequential word accesses starting anywhere in the mapped range
+    auto words = makeWords(1 << 19);
+    std::vector<uint32_t> trace;
+    for (auto word : words) {
+        auto start = 0x0040'0000 + (word % (Pages * TwoLevel32::PageSize - 32));
+        for (uint32_t i = 0; i < 8; ++i) {
+            trace.push_back(start + i * 4);
+        }
+    }
+    std::vector<uint32_t> physical(trace.size());
+    Mmu<TwoLevel32, Pte> single(memory, 0x1000);
+    report("translate one at a time", trace.size(), [&] {
+        for (std::size_t i = 0; i < trace.size(); ++i) {
+            physical[i] = single.translate(trace[i], AccessFlags::Read).address;
+        }
+    }, "address");
+    std::cout << "    " << single.statistics().hits << " TLB hits, " << single.statistics().misses << " misses" << std::endl;
+    Mmu<TwoLevel32, Pte> batched(memory, 0x1000);
+    auto fault = TranslationFault::None;
+    std::size_t translated = 0;
+    report("translate a trace", trace.size(), [&] { translated = batched.translate(trace, physical, AccessFlags::Read, fault); }, "address");
+    std::cout << "    " << translated << " translated, " << batched.statistics().hits << " TLB hits, " << batched.statistics().misses << " misses, "
+        << batched.statistics().runHits << " served by the previous page" << std::endl;
+}
+void benchmarkCacheSimulation() {
+    using namespace BinaryManipulation;
+    // 32k 8 way L1 and 1M 16 way L2 over a trace mixing a hot 64k region with a 64M range
+    using Hierarchy = CacheHierarchy<Cache<uint64_t, 64, 64, 8>, Cache<uint64_t, 64, 1024, 16, Replacement::PLRU>>;
+    auto words = makeWords(1 << 24);
+    std::vector<MemoryAccess<uint64_t>> trace(words.size());
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        auto word = static_cast<uint64_t>(words[i]);
+        trace[i] = { (word & 0x3) ? (word >> 4) & 0xFFFF : word & 0x3FF'FFFF, (word & 0x70) == 0 };
+    }
+    for (unsigned threads : { 1u, 0u }) {
+        auto hierarchy = std::make_unique<Hierarchy>();
+        std::chrono::duration<double> elapsed { };
+        report(threads == 1 ? "cache hierarchy, one thread" : "cache hierarchy, all threads", trace.size(), [&] {
+            auto start = std::chrono::steady_clock::now();
+            hierarchy->run(trace, threads);
+            elapsed = std::chrono::steady_clock::now() - start;
+        }, "access");
+        auto& counts = hierarchy->statistics();
+        std::cout << "    L1 " << counts.levels[0].hits << " hits, L2 " << counts.levels[1].hits << " hits, "
+            << counts.memoryReads << " memory reads, " << (elapsed.count() / trace.size() * 1e9) << " s per 10^9 accesses" << std::endl;
+    }
+}
+void benchmarkGuestMemory() {
+    using namespace BinaryManipulation;
+    constexpr uint32_t Region = 16 << 20;
+    GuestMemory<> memory;
+    auto words = makeWords(Region / sizeof(Ordinal));
+    memory.write(0, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(words.data()), Region));
+    // word accesses at random aligned and unaligned addresses in the region
+    auto addresses = makeWords(1 << 22);
+    for (auto& address : addresses) {
+        address %= Region - 8;
+    }
+    uint32_t byLanes = 0;
+    report("word loads from byte lanes", addresses.size(), [&] {
+        for (auto address : addresses) {
+            byLanes += fromQuarters<uint32_t>(memory.load<uint8_t>(address), memory.load<uint8_t>(address + 1),
+                    memory.load<uint8_t>(address + 2), memory.load<uint8_t>(address + 3));
+        }
+    }, "load");
+    uint32_t direct = 0;
+    report("word loads", addresses.size(), [&] {
+        for (auto address : addresses) {
+            direct += memory.load<uint32_t>(address);
+        }
+    }, "load");
+    std::cout << "    sums " << (byLanes == direct ? "match" : "differ") << std::endl;
+    report("block move", Region / 2, [&] { memory.move(3, Region / 2, Region / 2); }, "byte");
+}
+void benchmarkWatchpoints() {
+    using namespace BinaryManipulation;
+    namespace i960 = BinaryManipulation::i960;
+    std::size_t seen = 0;
+    WatchLog<Ordinal> log([&](std::span<const WatchHit<Ordinal>> batch) { seen += batch.size(); });
+    constexpr std::size_t Instructions = 20'000'000;
+    auto words = makeInterpreterLoop();
+    i960::Interpreter plain(16);
+    plain.load(words, 0);
+    report("interpreter unwatched", Instructions, [&] { plain.run(Instructions); }, "instruction");
+    i960::WatchedInterpreter watched(16);
+    watched.load(words, 0);
+    watched.controls().attach(log);
+    report("interpreter watched, disarmed", Instructions, [&] { watched.run(Instructions); }, "instruction");
+    // every compare in the loop rewrites the condition code with the same value
+    watched.arithmeticControls().watch().arm<i960::ConditionCode>();
+    watched.arithmeticControls().watch().arm<i960::IntegerOverflowFlag>();
+    report("interpreter watched, armed", Instructions, [&] { watched.run(Instructions); }, "instruction");
+    // a field that changes on every write, each one is a hit
+    constexpr std::size_t Writes = 20'000'000;
+    Watch<Ordinal> watch;
+    watch.attach(log);
+    Ordinal value = 0;
+    report("field encode unwatched", Writes, [&] {
+        for (std::size_t i = 0; i < Writes; ++i) {
+            value = i960::ConditionCode::encode(value, static_cast<uint8_t>(i));
+        }
+    }, "write");
+    watch.arm<i960::ConditionCode>();
+    report("field encode, every write a hit", Writes, [&] {
+        for (std::size_t i = 0; i < Writes; ++i) {
+            value = watchedEncode<i960::ConditionCode>(value, static_cast<uint8_t>(i), watch);
+        }
+    }, "write");
+    log.flush();
+    std::cout << "    " << seen << " hits delivered, value = " << value << std::endl;
+}
+int main() {
+    std::ofstream sink("/dev/null");
+    benchmarkFormatting(sink);
+    benchmarkHexParsing();
+    benchmarkCaptureParsing();
+    benchmarkDisassembly();
+    benchmarkEncoding();
+    benchmarkInterpreter();
+    benchmarkTranslation();
+    benchmarkCacheSimulation();
+    benchmarkGuestMemory();
+    benchmarkWatchpoints();
+    return 0;
+}
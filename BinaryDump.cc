@@ -0,0 +1,178 @@
+// Annotated binary dump, every 32-bit word of a file is broken down using a
+// chosen layout. Worker threads format disjoint chunks of the memory mapped
+// file while the main thread writes the already formatted ones in file order.
+// With -d the words are disassembled as i960 instructions instead.
+#include "BinaryManipulation.h"
+#include "ChunkPipeline.h"
+#include "Formatting.h"
+#include "i960.h"
+#include "i960Disassembler.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+using BinaryManipulation::i960::Ordinal;
+
+constexpr std::size_t WordsPerChunk = 1 << 16;
+
+struct Options {
+    BinaryManipulation::FieldFormat format = BinaryManipulation::FieldFormat::Hex;
+    bool annotate = false;
+    unsigned threads = 0;
+    std::size_t offsetDigits = 8;
+    bool disassemble = false;
+};
+/**
+ * Characters per output line: "offset: word fields\n"
+ */
+template<typename Layout>
+constexpr std::size_t LineLengthBound = 16 + 2 + 8 + 1 + BinaryManipulation::FormattedLengthBound<Layout> + 1;
+
+/**
+ * Returns false if a line did not fit, which means LineLengthBound is wrong
+ */
+template<typename Layout>
+bool formatChunk(const uint8_t* base, std::size_t firstWord, std::size_t count, const Options& options, std::vector<char>& output) noexcept {
+    output.resize(count * LineLengthBound<Layout>);
+    BinaryManipulation::FormatBuffer buffer(output);
+    auto fits = true;
+    for (std::size_t i = firstWord; fits && i < (firstWord + count); ++i) {
+        Ordinal word = 0;
+        std::memcpy(&word, base + (i * sizeof(Ordinal)), sizeof(word));
+        fits = buffer.writeHex(i * sizeof(Ordinal), options.offsetDigits) &&
+               buffer.write(": ") &&
+               buffer.writeHex(word, 8) &&
+               buffer.write(' ') &&
+               buffer.write<Layout>(word, options.format, options.annotate) &&
+               buffer.write('\n');
+    }
+    output.resize(buffer.size());
+    return fits;
+}
+bool writeOut(std::string_view text) noexcept {
+    if (std::fwrite(text.data(), 1, text.size(), stdout) != text.size()) {
+        std::perror("write");
+        return false;
+    }
+    return true;
+}
+template<typename Layout>
+bool dump(const uint8_t* base, std::size_t words, const Options& options) {
+    auto chunks = (words + WordsPerChunk - 1) / WordsPerChunk;
+    return BinaryManipulation::formatChunksInOrder(chunks, options.threads, [&](std::size_t chunk, std::vector<char>& output) noexcept {
+        auto first = chunk * WordsPerChunk;
+        if (!formatChunk<Layout>(base, first, std::min(WordsPerChunk, words - first), options, output)) {
+            std::fprintf(stderr, "line at word %zu is longer than expected\n", first);
+            return false;
+        }
+        return true;
+    }, writeOut);
+}
+
+bool disassemble(const uint8_t* base, std::size_t words, const Options& options) {
+    // the image is only ever read a word at a time, mappings are page aligned
+    std::span<const Ordinal> image(reinterpret_cast<const Ordinal*>(base), words);
+    return BinaryManipulation::i960::disassembleImage(image, 0, writeOut, options.threads);
+}
+
+using DumpFunction = bool(*)(const uint8_t*, std::size_t, const Options&);
+struct LayoutEntry {
+    std::string_view name;
+    DumpFunction fn;
+    std::string_view description;
+};
+constexpr LayoutEntry Layouts[] {
+    { "opcode", dump<BinaryManipulation::i960::OpcodeExtraction>, "i960 major and extended opcode" },
+    { "ac", dump<BinaryManipulation::i960::ArithmeticControls>, "i960 arithmetic controls register" },
+    { "tc", dump<BinaryManipulation::i960::TraceControls>, "i960 trace controls register" },
+    { "quarters", dump<BinaryManipulation::LittleEndianQuarters<Ordinal>>, "the four bytes of the word" },
+};
+
+void usage(const char* program) {
+    std::fprintf(stderr, "usage: %s [-l layout] [-f hex|bin|dec] [-a] [-d] [-j threads] file\n", program);
+    std::fprintf(stderr, "    -d disassembles the file as i960 code loaded at address zero\n");
+    std::fprintf(stderr, "layouts:\n");
+    for (const auto& entry : Layouts) {
+        std::fprintf(stderr, "    %-10.*s %.*s\n", static_cast<int>(entry.name.size()), entry.name.data(),
+                static_cast<int>(entry.description.size()), entry.description.data());
+    }
+}
+int main(int argc, char** argv) {
+    Options options;
+    DumpFunction fn = Layouts[0].fn;
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "l:f:adj:h")) != -1) {
+        switch (opt) {
+            case 'l': {
+                fn = nullptr;
+                for (const auto& entry : Layouts) {
+                    if (entry.name == optarg) {
+                        fn = entry.fn;
+                    }
+                }
+                if (!fn) {
+                    std::fprintf(stderr, "unknown layout %s\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            }
+            case 'f':
+                if (std::string_view(optarg) == "hex") {
+                    options.format = BinaryManipulation::FieldFormat::Hex;
+                } else if (std::string_view(optarg) == "bin") {
+                    options.format = BinaryManipulation::FieldFormat::Binary;
+                } else if (std::string_view(optarg) == "dec") {
+                    options.format = BinaryManipulation::FieldFormat::Decimal;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'a':
+                options.annotate = true;
+                break;
+            case 'd':
+                options.disassemble = true;
+                break;
+            case 'j':
+                options.threads = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != (argc - 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+    BinaryManipulation::MappedFile file(argv[optind]);
+    if (!file.valid()) {
+        std::perror(argv[optind]);
+        return 1;
+    }
+    file.adviseSequential();
+    auto size = file.size();
+    if (size > 0xFFFF'FFFFull) {
+        options.offsetDigits = 16;
+    }
+    if (options.disassemble) {
+        fn = disassemble;
+    }
+    auto ok = fn(file.bytes().data(), size / sizeof(Ordinal), options);
+    if (size % sizeof(Ordinal) != 0) {
+        std::fprintf(stderr, "ignoring %zu trailing bytes\n", size % sizeof(Ordinal));
+    }
+    if (!ok) {
+        return 1;
+    }
+    if (std::fflush(stdout) != 0) {
+        std::perror("write");
+        return 1;
+    }
+    return 0;
+}
@@ -32,6 +32,14 @@
 #include <type_traits>
 #include <cstdint>
 #include <climits>
+#include <array>
+#include <bit>
+#include <span>
+#include <algorithm>
+#include <cstring>
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 namespace BinaryManipulation {
 
 template<typename T>
@@ -80,8 +88,73 @@ constexpr T encode(T value, R input) noexcept {
     return encode<T, R, std::get<0>(description), std::get<1>(description)>(value, input);
 }
 
+/**
+ * Reverse the order of the lowest count bytes of the given value
+ */
+template<typename T>
+constexpr T reverseBytes(T value, std::size_t count = sizeof(T)) noexcept {
+    using U = std::make_unsigned_t<T>;
+    U result = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        result |= static_cast<U>(((static_cast<U>(value) >> (i * CHAR_BIT)) & 0xFF) << ((count - 1 - i) * CHAR_BIT));
+    }
+    return static_cast<T>(result);
+}
+static_assert(reverseBytes<uint32_t>(0x1234'5678) == 0x7856'3412);
+static_assert(reverseBytes<uint32_t>(0x1234'5678, 2) == 0x7856);
 
-template<typename T, typename R, T mask, T shift = static_cast<T>(0)>
+/**
+ * Read a T stored in the given byte order from (possibly unaligned) memory
+ */
+template<typename T>
+inline T loadFromBytes(const void* bytes, std::endian order = std::endian::little) noexcept {
+    T value { };
+    std::memcpy(&value, bytes, sizeof(T));
+    return (order == std::endian::native) ? value : reverseBytes<T>(value);
+}
+
+/**
+ * Where each byte of a DataType comes from when the fields making it up are
+ * put into native (little endian) order; out[i] = in[permutation[i]].
+ */
+template<typename T>
+using ByteOrderPermutationType = std::array<uint8_t, sizeof(T)>;
+
+template<typename T>
+constexpr ByteOrderPermutationType<T> makeIdentityByteOrder() noexcept {
+    ByteOrderPermutationType<T> result { };
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        result[i] = static_cast<uint8_t>(i);
+    }
+    return result;
+}
+
+/**
+ * The byte order permutation of a pattern (or description), anything which
+ * does not declare its byte order is assumed to already be little endian
+ */
+template<typename P>
+constexpr auto ByteOrderPermutation = makeIdentityByteOrder<typename P::DataType>();
+
+/**
+ * The number of bits set in the given mask
+ */
+template<typename T>
+constexpr int countSetBits(T value) noexcept {
+    return std::popcount(static_cast<std::make_unsigned_t<T>>(value));
+}
+
+template<typename T, typename R, T mask, T shift, std::endian order>
+constexpr bool isValidFieldByteOrder() noexcept {
+    if constexpr (order == std::endian::big) {
+        // byte swapping only makes sense for whole, byte aligned fields in integral types
+        return std::is_integral_v<T> && !IsBoolType<R> && (shift % CHAR_BIT) == 0 && (countSetBits(mask) % CHAR_BIT) == 0;
+    } else {
+        return true;
+    }
+}
+
+template<typename T, typename R, T mask, T shift = static_cast<T>(0), std::endian order = std::endian::little>
 class Pattern final {
 public:
     using DataType = T;
@@ -90,6 +163,12 @@ public:
 public:
     static constexpr auto Mask = mask;
     static constexpr auto Shift = shift;
+    /**
+     * The byte order the field is stored in within the DataType
+     */
+    static constexpr auto Order = order;
+    static constexpr auto FieldWidth = countSetBits(mask);
+    static_assert(isValidFieldByteOrder<T, R, mask, shift, order>(), "Big endian fields must start and end on byte boundaries!");
 public:
     constexpr Pattern() = default;
     ~Pattern() = default;
@@ -97,10 +176,18 @@ public:
     constexpr auto getMask() const noexcept { return mask; }
     constexpr auto getShift() const noexcept { return shift; }
     static constexpr auto decode(DataType input) noexcept {
-        return BinaryManipulation::decode<DataType, SliceType, _description>(input);
+        if constexpr (order == std::endian::big) {
+            return static_cast<SliceType>(reverseBytes<DataType>(BinaryManipulation::decode<DataType, DataType, _description>(input), FieldWidth / CHAR_BIT));
+        } else {
+            return BinaryManipulation::decode<DataType, SliceType, _description>(input);
+        }
     }
     static constexpr auto encode(DataType value, SliceType input) noexcept {
-        return BinaryManipulation::encode<DataType, SliceType, _description>(value, input);
+        if constexpr (order == std::endian::big) {
+            return BinaryManipulation::encode<DataType, DataType, _description>(value, reverseBytes<DataType>(static_cast<DataType>(input), FieldWidth / CHAR_BIT));
+        } else {
+            return BinaryManipulation::encode<DataType, SliceType, _description>(value, input);
+        }
     }
     static constexpr auto encode(SliceType input) noexcept {
         return encode(static_cast<DataType>(0), input);
@@ -109,6 +196,19 @@ private:
     static constexpr InteractPair _description { mask, shift };
 };
 
+template<typename T, typename R, T mask, T shift, std::endian order>
+constexpr auto ByteOrderPermutation<Pattern<T, R, mask, shift, order>> = [] {
+    auto result = makeIdentityByteOrder<T>();
+    if constexpr (order == std::endian::big) {
+        constexpr auto first = shift / CHAR_BIT;
+        constexpr auto last = first + (Pattern<T, R, mask, shift, order>::FieldWidth / CHAR_BIT) - 1;
+        for (std::size_t i = first; i <= last; ++i) {
+            result[i] = static_cast<uint8_t>(first + last - i);
+        }
+    }
+    return result;
+}();
+
 template<typename T, T mask, T shift = static_cast<T>(0)>
 using NoCastPattern = Pattern<T, T, mask, shift>;
 
@@ -121,14 +221,33 @@ using Flag = BoolPattern<T, static_cast<T>(1) << position, position>;
 template<typename T>
 constexpr T computeMaskFromLength(T length, T offset = static_cast<T>(0)) noexcept {
     constexpr auto one = static_cast<T>(1);
+    if (static_cast<std::size_t>(length) >= (sizeof(T) * CHAR_BIT)) {
+        // a full width field, shifting one out of the type is undefined
+        return static_cast<T>(~static_cast<T>(0) << offset);
+    }
     return ((one << length) - one) << offset;
 }
 static_assert(computeMaskFromLength(1) == 0b1);
 static_assert(computeMaskFromLength(12) == 0b1111'1111'1111);
 static_assert(computeMaskFromLength(12,1) == 0b1'1111'1111'1110);
+static_assert(computeMaskFromLength<uint32_t>(32) == 0xFFFF'FFFF);
+static_assert(computeMaskFromLength<uint64_t>(64, 0) == 0xFFFF'FFFF'FFFF'FFFF);
+
+/**
+ * Treat the lowest bits of value as a two's complement number of that width
+ */
+template<std::size_t bits, typename T>
+constexpr std::make_signed_t<T> signExtend(T value) noexcept {
+    static_assert(std::is_unsigned_v<T> && bits > 0 && bits <= (sizeof(T) * CHAR_BIT));
+    constexpr auto unused = (sizeof(T) * CHAR_BIT) - bits;
+    return static_cast<std::make_signed_t<T>>(static_cast<T>(value << unused)) >> unused;
+}
+static_assert(signExtend<13>(0x1FFCu) == -4);
+static_assert(signExtend<13>(0x0FFCu) == 0xFFC);
+static_assert(signExtend<32>(0xFFFF'FFFFu) == -1);
 
 template<typename T, typename R, T lsbPos, T length>
-using FieldVector = Pattern<T, R, computeMaskFromLength(length, lsbPos), lsbPos>;
+using FieldVector = Pattern<T, R, computeMaskFromLength<T>(length, lsbPos), lsbPos>;
 
 static_assert(FieldVector<uint32_t, uint32_t, 4, 12>::decode(0xABCD) == 0xABC);
 static_assert(FieldVector<uint32_t, uint32_t, 4, 12>::encode(0xD, 0xABC) == 0xABCD);
@@ -136,6 +255,68 @@ static_assert(FieldVector<uint32_t, uint32_t, 4, 12>::encode(0xD, 0xABC) == 0xAB
 template<typename T, typename R, T start, T end>
 using FieldRange = FieldVector<T, R, start, (end - start) + 1>;
 
+template<typename T, typename R, T lsbPos, T length>
+using BigEndianFieldVector = Pattern<T, R, computeMaskFromLength<T>(length, lsbPos), lsbPos, std::endian::big>;
+
+template<typename T, typename R, T start, T end>
+using BigEndianFieldRange = BigEndianFieldVector<T, R, start, (end - start) + 1>;
+
+static_assert(BigEndianFieldVector<uint32_t, uint16_t, 8, 16>::decode(0x0012'3400) == 0x3412);
+static_assert(BigEndianFieldVector<uint32_t, uint16_t, 8, 16>::encode(0x3412) == 0x0012'3400);
+
+/**
+ * Apply a byte order permutation to every element of the input, this is
+ * a single shuffle per vector when SSSE3 or AVX2 is available.
+ */
+template<typename T, ByteOrderPermutationType<T> permutation>
+void applyByteOrder(std::span<const T> input, std::span<T> output) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min(input.size(), output.size());
+    if constexpr (permutation == makeIdentityByteOrder<T>()) {
+        if (input.data() != output.data()) {
+            std::copy_n(input.data(), count, output.data());
+        }
+        return;
+    } else {
+        std::size_t i = 0;
+#if defined(__AVX2__) || defined(__SSSE3__)
+        // the control vector is the permutation repeated once per element
+        constexpr auto control = [] {
+            std::array<char, 32> result { };
+            for (std::size_t j = 0; j < result.size(); ++j) {
+                result[j] = static_cast<char>((((j % 16) / sizeof(T)) * sizeof(T)) + permutation[j % sizeof(T)]);
+            }
+            return result;
+        }();
+        auto in = reinterpret_cast<const char*>(input.data());
+        auto out = reinterpret_cast<char*>(output.data());
+#ifdef __AVX2__
+        constexpr auto PerVector = 32 / sizeof(T);
+        auto ctrl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(control.data()));
+        for (; (i + PerVector) <= count; i += PerVector) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + (i * sizeof(T))));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (i * sizeof(T))), _mm256_shuffle_epi8(v, ctrl));
+        }
+#else
+        constexpr auto PerVector = 16 / sizeof(T);
+        auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control.data()));
+        for (; (i + PerVector) <= count; i += PerVector) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (i * sizeof(T))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (i * sizeof(T))), _mm_shuffle_epi8(v, ctrl));
+        }
+#endif
+#endif
+        for (; i < count; ++i) {
+            auto value = static_cast<U>(input[i]);
+            U result = 0;
+            for (std::size_t j = 0; j < sizeof(T); ++j) {
+                result |= static_cast<U>(((value >> (permutation[j] * CHAR_BIT)) & 0xFF) << (j * CHAR_BIT));
+            }
+            output[i] = static_cast<T>(result);
+        }
+    }
+}
+
 
 
 template<typename T, typename ... Patterns>
@@ -147,7 +328,7 @@ class Description final {
 
         static_assert((std::is_same_v<typename Patterns::DataType, DataType> && ...), "All patterns must operate on the provided binary type!");
     public:
-        static constexpr decltype(auto) decode(DataType input) noexcept {
+        static constexpr auto decode(DataType input) noexcept {
             // Do not return a single element tuple as it makes everything more complicated, instead
             // return that element itself. In all other cases we must return the tuple as expected
             if constexpr (auto tup = std::make_tuple<typename Patterns::SliceType...>(Patterns::decode(input)...); NumberOfPatterns == 1) {
@@ -176,7 +357,68 @@ class Description final {
             // need to unpack the tuple
             return encode0(std::move(tuple), std::make_index_sequence<std::tuple_size_v<SliceType>> {});
         }
+        /**
+         * Byte swap every big endian field of every element so that the
+         * results can be decoded with NormalizedForm_t<Description>. Swapping
+         * is its own inverse so this also goes back the other way.
+         */
+        static void normalizeEndianness(std::span<const DataType> input, std::span<DataType> output) noexcept {
+            applyByteOrder<DataType, ByteOrderPermutation<Description>>(input, output);
+        }
+        static void normalizeEndianness(std::span<DataType> values) noexcept {
+            normalizeEndianness(values, values);
+        }
+};
+
+template<typename T, typename ... Patterns>
+constexpr auto ByteOrderPermutation<Description<T, Patterns...>> = [] {
+    auto result = makeIdentityByteOrder<T>();
+    // take the swapped bytes of every field, untouched bytes stay where they are
+    ([&result](const auto& permutation) {
+        for (std::size_t i = 0; i < permutation.size(); ++i) {
+            if (permutation[i] != i) {
+                result[i] = permutation[i];
+            }
+        }
+     }(ByteOrderPermutation<Patterns>), ...);
+    return result;
+}();
+
+/**
+ * The same layout with every field in little endian order
+ */
+template<typename P>
+struct NormalizedForm final {
+    using Type = P;
 };
+template<typename T, typename R, T mask, T shift, std::endian order>
+struct NormalizedForm<Pattern<T, R, mask, shift, order>> final {
+    using Type = Pattern<T, R, mask, shift>;
+};
+template<typename T, typename ... Patterns>
+struct NormalizedForm<Description<T, Patterns...>> final {
+    using Type = Description<T, typename NormalizedForm<Patterns>::Type...>;
+};
+template<typename P>
+using NormalizedForm_t = typename NormalizedForm<P>::Type;
+/**
+ * Get the I-th pattern of a Description
+ */
+template<typename D, std::size_t I>
+struct PatternAt final { };
+template<typename T, typename ... Patterns, std::size_t I>
+struct PatternAt<Description<T, Patterns...>, I> final {
+    using Type = std::tuple_element_t<I, std::tuple<Patterns...>>;
+};
+template<typename D, std::size_t I>
+using PatternAt_t = typename PatternAt<D, I>::Type;
+/**
+ * Is the given pattern actually a (nested) Description?
+ */
+template<typename P>
+constexpr bool IsDescription = false;
+template<typename T, typename ... Patterns>
+constexpr bool IsDescription<Description<T, Patterns...>> = true;
 template<typename T, typename ... Patterns>
 constexpr T pack(typename Patterns::SliceType&& ... inputs) noexcept {
     return Description<T, Patterns...>::encode(std::forward<typename Patterns::SliceType>(inputs)...);
@@ -300,7 +542,7 @@ constexpr decltype(auto) getHalves(T input) noexcept {
 
 template<typename T>
 constexpr T fromHalves(HalfType_t<T>&& a, HalfType_t<T>&& b) noexcept {
-    return LittleEndianHalves<T>::encode(a, b);
+    return LittleEndianHalves<T>::encode(std::move(a), std::move(b));
 }
 
 template<typename T>
@@ -0,0 +1,357 @@
+/**
+ * @file
+ * Column wise (plane) transposition of arrays of binary quantities
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_BytePlanes_h__
+#define BinaryManipulation_BytePlanes_h__
+#include "BinaryManipulation.h"
+#include <algorithm>
+#include <span>
+#if defined(__SSE2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+// All of the plane routines lay the output out as consecutive planes with a
+// stride equal to the number of elements converted (which is what is returned).
+// Plane k holds the k-th lane of every element, lanes are numbered from the
+// least significant end just like getQuarters/getHalves. This is the shuffle
+// filter used by blosc to make arrays of integers more compressible.
+
+namespace Planes {
+template<typename T>
+constexpr uint8_t byteOf(T value, std::size_t index) noexcept {
+    return static_cast<uint8_t>(static_cast<std::make_unsigned_t<T>>(value) >> (index * CHAR_BIT));
+}
+
+template<typename T>
+void toBytePlanesScalar(const T* input, uint8_t* planes, std::size_t start, std::size_t count) noexcept {
+    for (std::size_t i = start; i < count; ++i) {
+        for (std::size_t k = 0; k < sizeof(T); ++k) {
+            planes[(k * count) + i] = byteOf(input[i], k);
+        }
+    }
+}
+
+template<typename T>
+void fromBytePlanesScalar(const uint8_t* planes, T* output, std::size_t start, std::size_t count) noexcept {
+    using U = std::make_unsigned_t<T>;
+    for (std::size_t i = start; i < count; ++i) {
+        U value = 0;
+        for (std::size_t k = 0; k < sizeof(T); ++k) {
+            value |= static_cast<U>(static_cast<U>(planes[(k * count) + i]) << (k * CHAR_BIT));
+        }
+        output[i] = static_cast<T>(value);
+    }
+}
+
+#ifdef __SSSE3__
+/**
+ * Sixteen elements at a time: pshufb groups the bytes of each vector by lane
+ * and then an unpack ladder finishes the transpose.
+ */
+template<typename T>
+std::size_t toBytePlanesVector(const T* input, uint8_t* planes, std::size_t count) noexcept {
+    constexpr std::size_t ElementsPerBlock = 16;
+    auto blocks = count / ElementsPerBlock;
+    auto in = reinterpret_cast<const __m128i*>(input);
+    auto plane = [planes, count](std::size_t k, std::size_t block) noexcept {
+        return reinterpret_cast<__m128i*>(planes + (k * count) + (block * ElementsPerBlock));
+    };
+    if constexpr (sizeof(T) == 2) {
+        const auto ctrl = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+        for (std::size_t b = 0; b < blocks; ++b, in += 2) {
+            auto v0 = _mm_shuffle_epi8(_mm_loadu_si128(in + 0), ctrl);
+            auto v1 = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), ctrl);
+            _mm_storeu_si128(plane(0, b), _mm_unpacklo_epi64(v0, v1));
+            _mm_storeu_si128(plane(1, b), _mm_unpackhi_epi64(v0, v1));
+        }
+    } else if constexpr (sizeof(T) == 4) {
+        const auto ctrl = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        for (std::size_t b = 0; b < blocks; ++b, in += 4) {
+            auto v0 = _mm_shuffle_epi8(_mm_loadu_si128(in + 0), ctrl);
+            auto v1 = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), ctrl);
+            auto v2 = _mm_shuffle_epi8(_mm_loadu_si128(in + 2), ctrl);
+            auto v3 = _mm_shuffle_epi8(_mm_loadu_si128(in + 3), ctrl);
+            auto t0 = _mm_unpacklo_epi32(v0, v1);
+            auto t1 = _mm_unpacklo_epi32(v2, v3);
+            auto t2 = _mm_unpackhi_epi32(v0, v1);
+            auto t3 = _mm_unpackhi_epi32(v2, v3);
+            _mm_storeu_si128(plane(0, b), _mm_unpacklo_epi64(t0, t1));
+            _mm_storeu_si128(plane(1, b), _mm_unpackhi_epi64(t0, t1));
+            _mm_storeu_si128(plane(2, b), _mm_unpacklo_epi64(t2, t3));
+            _mm_storeu_si128(plane(3, b), _mm_unpackhi_epi64(t2, t3));
+        }
+    } else if constexpr (sizeof(T) == 8) {
+        const auto ctrl = _mm_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+        for (std::size_t b = 0; b < blocks; ++b, in += 8) {
+            __m128i v[8];
+            for (int j = 0; j < 8; ++j) {
+                v[j] = _mm_shuffle_epi8(_mm_loadu_si128(in + j), ctrl);
+            }
+            __m128i t[8];
+            for (int j = 0; j < 4; ++j) {
+                t[(2 * j) + 0] = _mm_unpacklo_epi16(v[2 * j], v[(2 * j) + 1]);
+                t[(2 * j) + 1] = _mm_unpackhi_epi16(v[2 * j], v[(2 * j) + 1]);
+            }
+            __m128i u[8];
+            for (int j = 0; j < 2; ++j) {
+                u[(4 * j) + 0] = _mm_unpacklo_epi32(t[(4 * j) + 0], t[(4 * j) + 2]);
+                u[(4 * j) + 1] = _mm_unpackhi_epi32(t[(4 * j) + 0], t[(4 * j) + 2]);
+                u[(4 * j) + 2] = _mm_unpacklo_epi32(t[(4 * j) + 1], t[(4 * j) + 3]);
+                u[(4 * j) + 3] = _mm_unpackhi_epi32(t[(4 * j) + 1], t[(4 * j) + 3]);
+            }
+            for (int j = 0; j < 4; ++j) {
+                _mm_storeu_si128(plane((2 * j) + 0, b), _mm_unpacklo_epi64(u[j], u[j + 4]));
+                _mm_storeu_si128(plane((2 * j) + 1, b), _mm_unpackhi_epi64(u[j], u[j + 4]));
+            }
+        }
+    } else {
+        return 0;
+    }
+    return blocks * ElementsPerBlock;
+}
+#endif
+
+#ifdef __SSE2__
+/**
+ * Inverse of toBytePlanesVector, interleaving the planes back together only
+ * takes an unpack ladder.
+ */
+template<typename T>
+std::size_t fromBytePlanesVector(const uint8_t* planes, T* output, std::size_t count) noexcept {
+    constexpr std::size_t ElementsPerBlock = 16;
+    auto blocks = count / ElementsPerBlock;
+    auto out = reinterpret_cast<__m128i*>(output);
+    auto plane = [planes, count](std::size_t k, std::size_t block) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + (k * count) + (block * ElementsPerBlock)));
+    };
+    if constexpr (sizeof(T) == 2) {
+        for (std::size_t b = 0; b < blocks; ++b, out += 2) {
+            auto p0 = plane(0, b);
+            auto p1 = plane(1, b);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi8(p0, p1));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(p0, p1));
+        }
+    } else if constexpr (sizeof(T) == 4) {
+        for (std::size_t b = 0; b < blocks; ++b, out += 4) {
+            auto p0 = plane(0, b);
+            auto p1 = plane(1, b);
+            auto p2 = plane(2, b);
+            auto p3 = plane(3, b);
+            auto a0 = _mm_unpacklo_epi8(p0, p1);
+            auto a1 = _mm_unpackhi_epi8(p0, p1);
+            auto b0 = _mm_unpacklo_epi8(p2, p3);
+            auto b1 = _mm_unpackhi_epi8(p2, p3);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(a0, b0));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(a0, b0));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(a1, b1));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(a1, b1));
+        }
+    } else if constexpr (sizeof(T) == 8) {
+        for (std::size_t b = 0; b < blocks; ++b, out += 8) {
+            // pairs of planes -> pairs of bytes for elements 0-7 and 8-15
+            __m128i a[8];
+            for (int j = 0; j < 4; ++j) {
+                auto lo = plane(2 * j, b);
+                auto hi = plane((2 * j) + 1, b);
+                a[(2 * j) + 0] = _mm_unpacklo_epi8(lo, hi);
+                a[(2 * j) + 1] = _mm_unpackhi_epi8(lo, hi);
+            }
+            // quads of planes -> four bytes for every four elements
+            __m128i q[8];
+            for (int j = 0; j < 2; ++j) {
+                q[(4 * j) + 0] = _mm_unpacklo_epi16(a[(4 * j) + 0], a[(4 * j) + 2]);
+                q[(4 * j) + 1] = _mm_unpackhi_epi16(a[(4 * j) + 0], a[(4 * j) + 2]);
+                q[(4 * j) + 2] = _mm_unpacklo_epi16(a[(4 * j) + 1], a[(4 * j) + 3]);
+                q[(4 * j) + 3] = _mm_unpackhi_epi16(a[(4 * j) + 1], a[(4 * j) + 3]);
+            }
+            for (int j = 0; j < 4; ++j) {
+                _mm_storeu_si128(out + (2 * j) + 0, _mm_unpacklo_epi32(q[j], q[j + 4]));
+                _mm_storeu_si128(out + (2 * j) + 1, _mm_unpackhi_epi32(q[j], q[j + 4]));
+            }
+        }
+    } else {
+        return 0;
+    }
+    return blocks * ElementsPerBlock;
+}
+#endif
+} // end namespace Planes
+
+/**
+ * Split every element into its bytes and store them as sizeof(T) planes
+ */
+template<typename T>
+std::size_t toBytePlanes(std::span<const T> input, std::span<uint8_t> planes) noexcept {
+    static_assert(std::is_integral_v<T>, "Byte planes only make sense for integral types");
+    auto count = std::min(input.size(), planes.size() / sizeof(T));
+    std::size_t start = 0;
+#ifdef __SSSE3__
+    start = Planes::toBytePlanesVector<T>(input.data(), planes.data(), count);
+#endif
+    Planes::toBytePlanesScalar<T>(input.data(), planes.data(), start, count);
+    return count;
+}
+
+/**
+ * Inverse of toBytePlanes, the number of elements is taken from the output
+ */
+template<typename T>
+std::size_t fromBytePlanes(std::span<const uint8_t> planes, std::span<T> output) noexcept {
+    static_assert(std::is_integral_v<T>, "Byte planes only make sense for integral types");
+    auto count = std::min(output.size(), planes.size() / sizeof(T));
+    std::size_t start = 0;
+#ifdef __SSE2__
+    start = Planes::fromBytePlanesVector<T>(planes.data(), output.data(), count);
+#endif
+    Planes::fromBytePlanesScalar<T>(planes.data(), output.data(), start, count);
+    return count;
+}
+
+/**
+ * Store the LittleEndianQuarters of every element as four planes. When the
+ * quarters are bytes this is the same thing as toBytePlanes.
+ */
+template<typename T>
+std::size_t toQuarterPlanes(std::span<const T> input, std::span<QuarterType_t<T>> planes) noexcept {
+    if constexpr (sizeof(QuarterType_t<T>) == 1 && sizeof(T) == 4) {
+        return toBytePlanes<T>(input, std::span<uint8_t>(reinterpret_cast<uint8_t*>(planes.data()), planes.size_bytes()));
+    } else {
+        auto count = std::min(input.size(), planes.size() / 4);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto [a, b, c, d] = getQuarters<T>(input[i]);
+            planes[i] = a;
+            planes[count + i] = b;
+            planes[(2 * count) + i] = c;
+            planes[(3 * count) + i] = d;
+        }
+        return count;
+    }
+}
+
+template<typename T>
+std::size_t fromQuarterPlanes(std::span<const QuarterType_t<T>> planes, std::type_identity_t<std::span<T>> output) noexcept {
+    using Q = QuarterType_t<T>;
+    if constexpr (sizeof(Q) == 1 && sizeof(T) == 4) {
+        return fromBytePlanes<T>(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(planes.data()), planes.size_bytes()), output);
+    } else {
+        auto count = std::min(output.size(), planes.size() / 4);
+        for (std::size_t i = 0; i < count; ++i) {
+            output[i] = fromQuarters<T>(Q(planes[i]), Q(planes[count + i]), Q(planes[(2 * count) + i]), Q(planes[(3 * count) + i]));
+        }
+        return count;
+    }
+}
+
+/**
+ * Store the LittleEndianHalves of every element as two planes
+ */
+template<typename T>
+std::size_t toHalfPlanes(std::span<const T> input, std::span<HalfType_t<T>> planes) noexcept {
+    if constexpr (sizeof(HalfType_t<T>) == 1 && sizeof(T) == 2) {
+        return toBytePlanes<T>(input, std::span<uint8_t>(reinterpret_cast<uint8_t*>(planes.data()), planes.size_bytes()));
+    } else {
+        auto count = std::min(input.size(), planes.size() / 2);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto [lower, upper] = getHalves<T>(input[i]);
+            planes[i] = lower;
+            planes[count + i] = upper;
+        }
+        return count;
+    }
+}
+
+template<typename T>
+std::size_t fromHalfPlanes(std::span<const HalfType_t<T>> planes, std::type_identity_t<std::span<T>> output) noexcept {
+    using H = HalfType_t<T>;
+    if constexpr (sizeof(H) == 1 && sizeof(T) == 2) {
+        return fromBytePlanes<T>(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(planes.data()), planes.size_bytes()), output);
+    } else {
+        auto count = std::min(output.size(), planes.size() / 2);
+        for (std::size_t i = 0; i < count; ++i) {
+            output[i] = fromHalves<T>(H(planes[i]), H(planes[count + i]));
+        }
+        return count;
+    }
+}
+
+/**
+ * The number of bytes a single nibble plane takes up, two nibbles are
+ * packed per byte (HalfOf<uint8_t>) with the even element in the lower half.
+ */
+constexpr std::size_t nibblePlaneStride(std::size_t count) noexcept {
+    return (count + 1) / 2;
+}
+
+/**
+ * Store every nibble of every element as 2 * sizeof(T) packed planes, the
+ * planes are nibblePlaneStride(count) bytes apart
+ */
+template<typename T>
+std::size_t toNibblePlanes(std::span<const T> input, std::span<uint8_t> planes) noexcept {
+    using U = std::make_unsigned_t<T>;
+    constexpr auto NumberOfPlanes = sizeof(T) * 2;
+    auto count = std::min(input.size(), (planes.size() / NumberOfPlanes) * 2);
+    auto stride = nibblePlaneStride(count);
+    auto nibbleOf = [](U value, std::size_t index) noexcept {
+        return static_cast<uint8_t>((value >> (index * HalfShiftAmount<uint8_t>)) & LowerHalfMask<uint8_t>);
+    };
+    for (std::size_t i = 0; i < count; i += 2) {
+        auto even = static_cast<U>(input[i]);
+        auto odd = (i + 1) < count ? static_cast<U>(input[i + 1]) : static_cast<U>(0);
+        for (std::size_t p = 0; p < NumberOfPlanes; ++p) {
+            planes[(p * stride) + (i / 2)] = fromHalves<uint8_t>(nibbleOf(even, p), nibbleOf(odd, p));
+        }
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t fromNibblePlanes(std::span<const uint8_t> planes, std::span<T> output) noexcept {
+    using U = std::make_unsigned_t<T>;
+    constexpr auto NumberOfPlanes = sizeof(T) * 2;
+    auto count = std::min(output.size(), (planes.size() / NumberOfPlanes) * 2);
+    auto stride = nibblePlaneStride(count);
+    for (std::size_t i = 0; i < count; i += 2) {
+        U even = 0;
+        U odd = 0;
+        for (std::size_t p = 0; p < NumberOfPlanes; ++p) {
+            auto [lower, upper] = getHalves<uint8_t>(planes[(p * stride) + (i / 2)]);
+            even |= static_cast<U>(static_cast<U>(lower) << (p * HalfShiftAmount<uint8_t>));
+            odd |= static_cast<U>(static_cast<U>(upper) << (p * HalfShiftAmount<uint8_t>));
+        }
+        output[i] = static_cast<T>(even);
+        if ((i + 1) < count) {
+            output[i + 1] = static_cast<T>(odd);
+        }
+    }
+    return count;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_BytePlanes_h__
@@ -0,0 +1,394 @@
+/**
+ * @file
+ * A trace driven multi level cache simulator built from tag, set index and line offset fields
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_CacheSimulator_h__
+#define BinaryManipulation_CacheSimulator_h__
+#include "BinaryManipulation.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <vector>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+enum class Replacement : uint8_t {
+    LRU,
+    // tree pseudo LRU, one bit per internal node of a binary tree over the ways
+    PLRU,
+};
+
+template<typename A>
+struct MemoryAccess {
+    A address;
+    bool write;
+};
+
+struct CacheStatistics {
+    std::size_t accesses;
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t writebacks;
+    constexpr CacheStatistics& operator+=(const CacheStatistics& other) noexcept {
+        accesses += other.accesses;
+        hits += other.hits;
+        misses += other.misses;
+        writebacks += other.writebacks;
+        return *this;
+    }
+    constexpr bool operator==(const CacheStatistics&) const noexcept = default;
+};
+
+/**
+ * Bit i is set when way i of a set holds tag, every way is compared
+ */
+template<std::size_t ways, typename A>
+inline uint64_t matchWays(const A* tags, A tag) noexcept {
+    uint64_t mask = 0;
+    // the ways compared a vector at a time, the rest are compared one by one
+#ifdef __AVX2__
+    constexpr std::size_t VectorWays = (sizeof(A) == 4 || sizeof(A) == 8) ? ways - (ways % (32 / sizeof(A))) : 0;
+#elif defined(__SSE2__)
+    constexpr std::size_t VectorWays = sizeof(A) == 4 ? ways - (ways % 4) : 0;
+#else
+    constexpr std::size_t VectorWays = 0;
+#endif
+#ifdef __AVX2__
+    if constexpr (sizeof(A) == 4) {
+        auto wanted = _mm256_set1_epi32(static_cast<int>(tag));
+        for (std::size_t i = 0; i < VectorWays; i += 8) {
+            auto found = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i)), wanted);
+            mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(found)))) << i;
+        }
+    } else if constexpr (sizeof(A) == 8) {
+        auto wanted = _mm256_set1_epi64x(static_cast<long long>(tag));
+        for (std::size_t i = 0; i < VectorWays; i += 4) {
+            auto found = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i)), wanted);
+            mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(found)))) << i;
+        }
+    }
+#elif defined(__SSE2__)
+    if constexpr (sizeof(A) == 4) {
+        auto wanted = _mm_set1_epi32(static_cast<int>(tag));
+        for (std::size_t i = 0; i < VectorWays; i += 4) {
+            auto found = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i)), wanted);
+            mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(found)))) << i;
+        }
+    }
+#endif
+    for (auto i = VectorWays; i < ways; ++i) {
+        mask |= static_cast<uint64_t>(tags[i] == tag) << i;
+    }
+    return mask;
+}
+/**
+ * The lowest set bit of a way mask, ways when there is none
+ */
+template<std::size_t ways>
+constexpr std::size_t firstWay(uint64_t mask) noexcept {
+    if constexpr (ways == 64) {
+        return static_cast<std::size_t>(std::countr_zero(mask));
+    } else {
+        return static_cast<std::size_t>(std::countr_zero(mask | (uint64_t { 1 } << ways)));
+    }
+}
+
+/**
+ * One level of write back, write allocate cache. The address is split into
+ * Tag, SetIndex and LineOffset fields by the geometry, each set keeps its
+ * tags contiguous so that a lookup is a single vector compare.
+ */
+template<typename A, std::size_t lineBytes, std::size_t sets, std::size_t ways, Replacement policy = Replacement::LRU>
+class Cache final {
+    public:
+        static_assert(std::is_unsigned_v<A>);
+        static_assert(std::has_single_bit(lineBytes) && std::has_single_bit(sets));
+        static_assert(ways > 0 && ways <= 64, "one dirty bit per way");
+        static_assert(policy != Replacement::PLRU || std::has_single_bit(ways), "the PLRU tree needs a power of two ways");
+        using Address = A;
+        static constexpr std::size_t LineBytes = lineBytes;
+        static constexpr std::size_t Sets = sets;
+        static constexpr std::size_t Ways = ways;
+        static constexpr std::size_t LineBits = std::countr_zero(lineBytes);
+        static constexpr std::size_t SetBits = std::countr_zero(sets);
+        static constexpr std::size_t Capacity = lineBytes * sets * ways;
+        using LineOffset = FieldVector<A, A, 0, LineBits>;
+        using SetIndex = FieldVector<A, std::size_t, LineBits, SetBits>;
+        using Tag = FieldVector<A, A, LineBits + SetBits, (sizeof(A) * CHAR_BIT) - LineBits - SetBits>;
+        // tags are narrower than an address so this never matches a line
+        static constexpr A InvalidTag = ~A { 0 };
+        struct Outcome {
+            bool hit;
+            // a dirty line was evicted and must be written to the next level
+            bool writeback;
+            A victim;
+        };
+    public:
+        Cache() : _sets(sets) { flush(); }
+        Outcome access(A address, bool write, uint64_t clock) noexcept {
+            auto& set = _sets[SetIndex::decode(address)];
+            auto way = firstWay<ways>(matchWays<ways>(set.tags.data(), Tag::decode(address)));
+            if (way != ways) {
+                touch(set, way, clock);
+                set.dirty |= static_cast<uint64_t>(write) << way;
+                return { true, false, 0 };
+            }
+            // fill an empty way before evicting anything
+            way = firstWay<ways>(matchWays<ways>(set.tags.data(), InvalidTag));
+            way = (way == ways) ? victim(set) : way;
+            Outcome outcome { false, ((set.dirty >> way) & 1) != 0, Tag::encode(SetIndex::encode(SetIndex::decode(address)), set.tags[way]) };
+            set.tags[way] = Tag::decode(address);
+            set.dirty = (set.dirty & ~(uint64_t { 1 } << way)) | (static_cast<uint64_t>(write) << way);
+            touch(set, way, clock);
+            return outcome;
+        }
+        void prefetch([[maybe_unused]] A address) const noexcept {
+#ifdef __GNUC__
+            __builtin_prefetch(&_sets[SetIndex::decode(address)]);
+#endif
+        }
+        void flush() noexcept {
+            for (auto& set : _sets) {
+                set.tags.fill(InvalidTag);
+                set.stamps.fill(0);
+                set.recency = NibbleOrder ? InitialOrder : 0;
+                set.dirty = 0;
+            }
+        }
+    private:
+        static constexpr std::size_t TreeDepth = std::bit_width(ways) - 1;
+        /**
+         * Up to 16 ways LRU keeps the ways as nibbles ordered from most to
+         * least recently used instead of a time stamp per way
+         */
+        static constexpr bool NibbleOrder = policy == Replacement::LRU && ways <= 16;
+        static constexpr uint64_t Nibbles = 0x1111'1111'1111'1111;
+        static constexpr uint64_t InitialOrder = [] {
+            uint64_t order = 0;
+            for (std::size_t way = 0; way < ways; ++way) {
+                order |= static_cast<uint64_t>(way) << (4 * way);
+            }
+            return order;
+        }();
+        /**
+         * Using a way points every node on its path away from it, the bits
+         * to clear and set are worked out ahead of time
+         */
+        static constexpr auto TreeUpdates = [] {
+            std::array<std::array<uint64_t, 2>, ways> updates { };
+            for (std::size_t way = 0; way < ways; ++way) {
+                for (auto node = way + ways; node > 1; node >>= 1) {
+                    updates[way][0] |= uint64_t { 1 } << (node >> 1);
+                    updates[way][1] |= static_cast<uint64_t>(!(node & 1)) << (node >> 1);
+                }
+            }
+            return updates;
+        }();
+        struct alignas(64) Set {
+            std::array<A, ways> tags;
+            std::array<uint64_t, (policy == Replacement::LRU && !NibbleOrder) ? ways : 0> stamps;
+            // the PLRU tree or the nibble order
+            uint64_t recency;
+            uint64_t dirty;
+        };
+        static constexpr void touch(Set& set, std::size_t way, [[maybe_unused]] uint64_t clock) noexcept {
+            if constexpr (NibbleOrder) {
+                // find the nibble holding way, then shift the more recent ones down over it
+                auto distance = set.recency ^ (Nibbles * way);
+                auto zero = ~(((distance & (Nibbles * 7)) + (Nibbles * 7)) | distance | (Nibbles * 7));
+                auto position = static_cast<std::size_t>(std::countr_zero(zero)) & ~std::size_t { 3 };
+                auto below = (uint64_t { 1 } << position) - 1;
+                set.recency = (set.recency & ~((below << 4) | 0xF)) | ((set.recency & below) << 4) | way;
+            } else if constexpr (policy == Replacement::LRU) {
+                set.stamps[way] = clock;
+            } else {
+                set.recency = (set.recency & ~TreeUpdates[way][0]) | TreeUpdates[way][1];
+            }
+        }
+        static constexpr std::size_t victim(const Set& set) noexcept {
+            if constexpr (policy == Replacement::LRU) {
+                if constexpr (NibbleOrder) {
+                    return (set.recency >> (4 * (ways - 1))) & 0xF;
+                } else {
+                    std::size_t oldest = 0;
+                    for (std::size_t i = 1; i < ways; ++i) {
+                        oldest = (set.stamps[i] < set.stamps[oldest]) ? i : oldest;
+                    }
+                    return oldest;
+                }
+            } else {
+                std::size_t node = 1;
+                for (std::size_t level = 0; level < TreeDepth; ++level) {
+                    node = (node << 1) | ((set.recency >> node) & 1);
+                }
+                return node - ways;
+            }
+        }
+    private:
+        std::vector<Set> _sets;
+};
+
+/**
+ * Caches from the one nearest the processor outwards. A miss fills the line
+ * from the next level and a dirty eviction is written to the next level,
+ * past the last level both go to memory.
+ */
+template<typename ... Levels>
+class CacheHierarchy final {
+    public:
+        static constexpr std::size_t NumberOfLevels = sizeof...(Levels);
+        static_assert(NumberOfLevels > 0);
+        using Address = typename std::tuple_element_t<0, std::tuple<Levels...>>::Address;
+        static_assert((std::is_same_v<Address, typename Levels::Address> && ...));
+        // sets only stay independent across levels when every level splits addresses at the same line size
+        static constexpr bool Shardable = ((Levels::LineBytes == std::tuple_element_t<0, std::tuple<Levels...>>::LineBytes) && ...);
+        static constexpr std::size_t MaximumShards = std::min({ Levels::Sets... });
+        struct Statistics {
+            std::array<CacheStatistics, NumberOfLevels> levels;
+            std::size_t memoryReads;
+            std::size_t memoryWrites;
+            constexpr Statistics& operator+=(const Statistics& other) noexcept {
+                for (std::size_t i = 0; i < NumberOfLevels; ++i) {
+                    levels[i] += other.levels[i];
+                }
+                memoryReads += other.memoryReads;
+                memoryWrites += other.memoryWrites;
+                return *this;
+            }
+            constexpr bool operator==(const Statistics&) const noexcept = default;
+        };
+    public:
+        void access(Address address, bool write) noexcept { accessLevel<0>(address, write, _statistics, _clock); }
+        /**
+         * Run a batch of accesses, the sets of accesses a little further on
+         * are prefetched while the current one is simulated
+         */
+        void run(std::span<const MemoryAccess<Address>> trace) noexcept;
+        /**
+         * Run a batch with the sets sharded across threads by the low bits of
+         * the set index. Each shard sees its accesses in trace order so the
+         * result is the same as the single threaded run.
+         */
+        void run(std::span<const MemoryAccess<Address>> trace, unsigned threads);
+        constexpr const Statistics& statistics() const noexcept { return _statistics; }
+        void reset() noexcept {
+            std::apply([](auto& ... levels) { (levels.flush(), ...); }, _levels);
+            _statistics = { };
+            _clock = 0;
+        }
+    private:
+        static constexpr std::size_t PrefetchDistance = 16;
+        // accesses each shard picks its own out of at a time
+        static constexpr std::size_t ShardChunk = 4096;
+        template<std::size_t I>
+        void accessLevel(Address address, bool write, Statistics& statistics, uint64_t& clock) noexcept {
+            auto& counts = statistics.levels[I];
+            auto outcome = std::get<I>(_levels).access(address, write, ++clock);
+            ++counts.accesses;
+            counts.hits += outcome.hit;
+            counts.misses += !outcome.hit;
+            counts.writebacks += outcome.writeback;
+            if constexpr ((I + 1) == NumberOfLevels) {
+                statistics.memoryReads += !outcome.hit;
+                statistics.memoryWrites += outcome.writeback;
+            } else if (!outcome.hit) {
+                if (outcome.writeback) {
+                    accessLevel<I + 1>(outcome.victim, true, statistics, clock);
+                }
+                accessLevel<I + 1>(address, false, statistics, clock);
+            }
+        }
+        void prefetch(Address address) const noexcept {
+            std::apply([address](const auto& ... levels) { (levels.prefetch(address), ...); }, _levels);
+        }
+    private:
+        std::tuple<Levels...> _levels;
+        Statistics _statistics { };
+        uint64_t _clock = 0;
+};
+
+template<typename ... Levels>
+void CacheHierarchy<Levels...>::run(std::span<const MemoryAccess<Address>> trace) noexcept {
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        prefetch(trace[std::min(i + PrefetchDistance, trace.size() - 1)].address);
+        accessLevel<0>(trace[i].address, trace[i].write, _statistics, _clock);
+    }
+}
+
+template<typename ... Levels>
+void CacheHierarchy<Levels...>::run(std::span<const MemoryAccess<Address>> trace, unsigned threads) {
+    auto shards = std::bit_floor(std::min<std::size_t>(std::max(1u, threads != 0 ? threads : std::thread::hardware_concurrency()), MaximumShards));
+    if (!Shardable || shards == 1) {
+        run(trace);
+        return;
+    }
+    constexpr auto LineBits = std::tuple_element_t<0, std::tuple<Levels...>>::LineBits;
+    std::vector<Statistics> statistics(shards);
+    std::vector<uint64_t> clocks(shards);
+    std::vector<std::thread> workers;
+    for (std::size_t shard = 0; shard < shards; ++shard) {
+        workers.emplace_back([this, trace, shards, shard, &statistics, &clocks] {
+            // a shard's own clock keeps the order of accesses within each of its sets
+            uint64_t clock = _clock;
+            Statistics counts { };
+            std::array<uint32_t, ShardChunk> selected;
+            for (std::size_t base = 0; base < trace.size(); base += ShardChunk) {
+                auto count = std::min(ShardChunk, trace.size() - base);
+                // gather this shard's accesses without a branch per access
+                std::size_t found = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    selected[found] = static_cast<uint32_t>(i);
+                    found += ((trace[base + i].address >> LineBits) & (shards - 1)) == shard;
+                }
+                for (std::size_t i = 0; i < found; ++i) {
+                    auto& entry = trace[base + selected[std::min(i + PrefetchDistance, found - 1)]];
+                    prefetch(entry.address);
+                    auto& current = trace[base + selected[i]];
+                    accessLevel<0>(current.address, current.write, counts, clock);
+                }
+            }
+            statistics[shard] = counts;
+            clocks[shard] = clock;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& counts : statistics) {
+        _statistics += counts;
+    }
+    // later runs are ordered after every access of this one
+    _clock = *std::max_element(clocks.begin(), clocks.end());
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_CacheSimulator_h__
@@ -0,0 +1,197 @@
+/**
+ * @file
+ * Format chunks on persistent worker threads and consume them in order
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_ChunkPipeline_h__
+#define BinaryManipulation_ChunkPipeline_h__
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+namespace BinaryManipulation {
+
+/**
+ * A fixed set of threads that runs one job at a time, so a caller with
+ * several parallel phases starts its threads once instead of per phase
+ */
+class WorkerPool final {
+    public:
+        explicit WorkerPool(unsigned threads = 0) {
+            auto count = std::max(1u, threads != 0 ? threads : std::thread::hardware_concurrency());
+            for (unsigned t = 0; t < count; ++t) {
+                _workers.emplace_back([this] { work(); });
+            }
+        }
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+        ~WorkerPool() {
+            {
+                std::lock_guard guard(_lock);
+                _stopping = true;
+            }
+            _changed.notify_all();
+            for (auto& worker : _workers) {
+                worker.join();
+            }
+        }
+        unsigned size() const noexcept { return static_cast<unsigned>(_workers.size()); }
+        /**
+         * Call fn(i) for every i in [0, count) on the workers and wait for all of them
+         */
+        template<typename Fn>
+        void forEach(std::size_t count, Fn&& fn) {
+            std::atomic<std::size_t> next { 0 };
+            start([&] {
+                for (auto i = next++; i < count; i = next++) {
+                    fn(i);
+                }
+            });
+            wait();
+        }
+        /**
+         * Call format(chunk, buffer) for chunks [0, count) on the workers and
+         * sink(std::string_view) with each buffer in chunk order on the calling
+         * thread. There are two buffers per worker so the pool formats the next
+         * round while the current one is being sunk. format returns false to
+         * give up, sink returns false to stop early; either makes this return false.
+         */
+        template<typename Format, typename Sink>
+        bool formatInOrder(std::size_t count, Format&& format, Sink&& sink) {
+            auto slots = static_cast<std::size_t>(size()) * 2;
+            std::vector<std::vector<char>> buffers(slots);
+            // per slot: 0 while empty, 1 once formatted, 2 if formatting failed
+            std::vector<unsigned char> states(slots, 0);
+            std::mutex lock;
+            std::condition_variable changed;
+            std::size_t next = 0;
+            std::size_t sunk = 0;
+            bool stop = false;
+            start([&] {
+                std::unique_lock guard(lock);
+                while (true) {
+                    // a chunk can only reuse a slot once the chunk before it has been sunk
+                    changed.wait(guard, [&] { return stop || next >= count || next < (sunk + slots); });
+                    if (stop || next >= count) {
+                        return;
+                    }
+                    auto chunk = next++;
+                    guard.unlock();
+                    auto formatted = format(chunk, buffers[chunk % slots]);
+                    guard.lock();
+                    states[chunk % slots] = formatted ? 1 : 2;
+                    changed.notify_all();
+                }
+            });
+            // the workers refer to the state above, release them even if sink throws
+            struct Finish {
+                WorkerPool& pool;
+                std::mutex& lock;
+                std::condition_variable& changed;
+                bool& stop;
+                ~Finish() {
+                    {
+                        std::lock_guard guard(lock);
+                        stop = true;
+                    }
+                    changed.notify_all();
+                    pool.wait();
+                }
+            } finish { *this, lock, changed, stop };
+            auto ok = true;
+            for (std::size_t chunk = 0; ok && chunk < count; ++chunk) {
+                auto slot = chunk % slots;
+                {
+                    std::unique_lock guard(lock);
+                    changed.wait(guard, [&] { return states[slot] != 0; });
+                    ok = states[slot] == 1;
+                }
+                ok = ok && sink(std::string_view(buffers[slot].data(), buffers[slot].size()));
+                std::lock_guard guard(lock);
+                states[slot] = 0;
+                ++sunk;
+                stop = !ok;
+                changed.notify_all();
+            }
+            return ok;
+        }
+    private:
+        void start(std::function<void()> job) {
+            {
+                std::lock_guard guard(_lock);
+                _job = std::move(job);
+                _running = _workers.size();
+                ++_generation;
+            }
+            _changed.notify_all();
+        }
+        void wait() {
+            std::unique_lock guard(_lock);
+            _changed.wait(guard, [this] { return _running == 0; });
+        }
+        void work() {
+            std::size_t seen = 0;
+            std::unique_lock guard(_lock);
+            while (true) {
+                _changed.wait(guard, [&] { return _stopping || _generation != seen; });
+                if (_stopping) {
+                    return;
+                }
+                seen = _generation;
+                guard.unlock();
+                _job();
+                guard.lock();
+                if (--_running == 0) {
+                    _changed.notify_all();
+                }
+            }
+        }
+    private:
+        std::vector<std::thread> _workers;
+        std::mutex _lock;
+        std::condition_variable _changed;
+        std::function<void()> _job;
+        std::size_t _generation = 0;
+        std::size_t _running = 0;
+        bool _stopping = false;
+};
+
+/**
+ * WorkerPool::formatInOrder on a pool of its own
+ */
+template<typename Format, typename Sink>
+bool formatChunksInOrder(std::size_t count, unsigned threads, Format&& format, Sink&& sink) {
+    WorkerPool pool(threads);
+    return pool.formatInOrder(count, std::forward<Format>(format), std::forward<Sink>(sink));
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_ChunkPipeline_h__
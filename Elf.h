@@ -0,0 +1,410 @@
+/**
+ * @file
+ * Zero copy ELF32/ELF64 image reader described with Patterns
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Elf_h__
+#define BinaryManipulation_Elf_h__
+#include "BinaryManipulation.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+namespace BinaryManipulation::Elf {
+
+// identification bytes
+constexpr std::size_t IdentificationLength = 16;
+constexpr std::array<uint8_t, 4> Magic { 0x7F, 'E', 'L', 'F' };
+constexpr uint8_t Class32 = 1;
+constexpr uint8_t Class64 = 2;
+constexpr uint8_t DataLittleEndian = 1;
+constexpr uint8_t DataBigEndian = 2;
+
+constexpr uint32_t SectionTypeSymbolTable = 2;
+constexpr uint32_t SectionTypeStringTable = 3;
+constexpr uint32_t SectionTypeRelocationsWithAddends = 4;
+constexpr uint32_t SectionTypeRelocations = 9;
+constexpr uint32_t SectionTypeDynamicSymbols = 11;
+
+/**
+ * st_info, the type in the lower nibble and the binding in the upper nibble
+ */
+using SymbolType = LowerHalfPattern<uint8_t>;
+using SymbolBinding = UpperHalfPattern<uint8_t>;
+using SymbolInfo = LittleEndianHalves<uint8_t>;
+/**
+ * st_other, only the visibility is defined
+ */
+using SymbolVisibility = FieldVector<uint8_t, uint8_t, 0, 2>;
+
+enum class Binding : uint8_t {
+    Local = 0,
+    Global = 1,
+    Weak = 2,
+};
+enum class Type : uint8_t {
+    None = 0,
+    Object = 1,
+    Function = 2,
+    Section = 3,
+    File = 4,
+    Common = 5,
+    ThreadLocal = 6,
+};
+
+/**
+ * sh_flags, described on the 64-bit form (the 32-bit form is zero extended)
+ */
+using SectionWrite = Flag<uint64_t, 0>;
+using SectionAlloc = Flag<uint64_t, 1>;
+using SectionExecute = Flag<uint64_t, 2>;
+using SectionMerge = Flag<uint64_t, 4>;
+using SectionStrings = Flag<uint64_t, 5>;
+using SectionInfoLink = Flag<uint64_t, 6>;
+using SectionLinkOrder = Flag<uint64_t, 7>;
+using SectionGroup = Flag<uint64_t, 9>;
+using SectionThreadLocal = Flag<uint64_t, 10>;
+using SectionCompressed = Flag<uint64_t, 11>;
+using SectionFlags = Description<uint64_t, SectionWrite, SectionAlloc, SectionExecute, SectionMerge, SectionStrings,
+      SectionInfoLink, SectionLinkOrder, SectionGroup, SectionThreadLocal, SectionCompressed>;
+
+/**
+ * r_info, symbol index and relocation type
+ */
+using Relocation32Info = Description<uint32_t, FieldVector<uint32_t, uint32_t, 8, 24>, LowestQuarterPattern<uint32_t>>;
+using Relocation64Info = Description<uint64_t, UpperHalfPattern<uint64_t>, LowerHalfPattern<uint64_t>>;
+
+struct Section {
+    std::string_view name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t address;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t entrySize;
+    /// empty for sections without file contents or that do not fit in the image
+    std::span<const uint8_t> contents;
+};
+struct Symbol {
+    std::string_view name;
+    uint64_t value;
+    uint64_t size;
+    uint8_t info;
+    uint8_t other;
+    uint16_t sectionIndex;
+    Type type() const noexcept { return static_cast<Type>(SymbolType::decode(info)); }
+    Binding binding() const noexcept { return static_cast<Binding>(SymbolBinding::decode(info)); }
+};
+struct Relocation {
+    uint64_t offset;
+    uint32_t symbol;
+    uint32_t type;
+    int64_t addend;
+};
+
+/**
+ * A view over an ELF image, nothing is copied out of the underlying bytes
+ * until a field is asked for; every offset is checked against the image
+ */
+class Image final {
+    public:
+        explicit Image(std::span<const uint8_t> bytes) noexcept : _bytes(bytes) {
+            if (bytes.size() < IdentificationLength || !std::equal(Magic.begin(), Magic.end(), bytes.begin())) {
+                return;
+            }
+            auto elfClass = bytes[4];
+            auto data = bytes[5];
+            if ((elfClass != Class32 && elfClass != Class64) || (data != DataLittleEndian && data != DataBigEndian)) {
+                return;
+            }
+            _is64 = elfClass == Class64;
+            _order = data == DataLittleEndian ? std::endian::little : std::endian::big;
+            if (bytes.size() < (_is64 ? 64u : 52u)) {
+                return;
+            }
+            _sectionHeaderOffset = word(_is64 ? 40 : 32);
+            _sectionHeaderSize = half(_is64 ? 58 : 46);
+            _sectionCount = half(_is64 ? 60 : 48);
+            _sectionNamesIndex = half(_is64 ? 62 : 50);
+            if (_sectionCount != 0 && (_sectionHeaderSize < (_is64 ? 64u : 40u) ||
+                        !fits(_sectionHeaderOffset, static_cast<uint64_t>(_sectionHeaderSize) * _sectionCount))) {
+                return;
+            }
+            _valid = true;
+        }
+        bool valid() const noexcept { return _valid; }
+        bool is64Bit() const noexcept { return _is64; }
+        std::endian byteOrder() const noexcept { return _order; }
+        uint16_t type() const noexcept { return half(16); }
+        uint16_t machine() const noexcept { return half(18); }
+        uint64_t entry() const noexcept { return word(24); }
+        std::size_t sectionCount() const noexcept { return _sectionCount; }
+        Section section(std::size_t index) const noexcept {
+            auto base = _sectionHeaderOffset + (index * _sectionHeaderSize);
+            Section result { };
+            result.type = load<uint32_t>(base + 4);
+            if (_is64) {
+                result.flags = load<uint64_t>(base + 8);
+                result.address = load<uint64_t>(base + 16);
+                result.offset = load<uint64_t>(base + 24);
+                result.size = load<uint64_t>(base + 32);
+                result.link = load<uint32_t>(base + 40);
+                result.info = load<uint32_t>(base + 44);
+                result.entrySize = load<uint64_t>(base + 56);
+            } else {
+                result.flags = load<uint32_t>(base + 8);
+                result.address = load<uint32_t>(base + 12);
+                result.offset = load<uint32_t>(base + 16);
+                result.size = load<uint32_t>(base + 20);
+                result.link = load<uint32_t>(base + 24);
+                result.info = load<uint32_t>(base + 28);
+                result.entrySize = load<uint32_t>(base + 36);
+            }
+            // SHT_NOBITS (8) occupies no space in the file
+            if (result.type != 8 && fits(result.offset, result.size)) {
+                result.contents = _bytes.subspan(result.offset, result.size);
+            }
+            if (_sectionNamesIndex < _sectionCount && index != _sectionNamesIndex) {
+                result.name = string(section(_sectionNamesIndex).contents, load<uint32_t>(base));
+            } else if (index == _sectionNamesIndex) {
+                result.name = string(result.contents, load<uint32_t>(base));
+            }
+            return result;
+        }
+        std::optional<Section> findSection(std::string_view name) const noexcept {
+            for (std::size_t i = 0; i < _sectionCount; ++i) {
+                if (auto candidate = section(i); candidate.name == name) {
+                    return candidate;
+                }
+            }
+            return std::nullopt;
+        }
+        /**
+         * Zero copy iteration over the entries of a symbol table section
+         */
+        class Symbols final {
+            public:
+                Symbols(const Image& image, std::span<const uint8_t> entries, std::span<const uint8_t> strings) noexcept
+                    : _image(&image), _entries(entries), _strings(strings) { }
+                std::size_t size() const noexcept { return _entries.size() / _image->symbolEntrySize(); }
+                Symbol operator[](std::size_t index) const noexcept {
+                    auto entry = _entries.subspan(index * _image->symbolEntrySize());
+                    auto order = _image->byteOrder();
+                    Symbol result { };
+                    result.name = string(_strings, loadFromBytes<uint32_t>(entry.data(), order));
+                    if (_image->is64Bit()) {
+                        result.info = entry[4];
+                        result.other = entry[5];
+                        result.sectionIndex = loadFromBytes<uint16_t>(entry.data() + 6, order);
+                        result.value = loadFromBytes<uint64_t>(entry.data() + 8, order);
+                        result.size = loadFromBytes<uint64_t>(entry.data() + 16, order);
+                    } else {
+                        result.value = loadFromBytes<uint32_t>(entry.data() + 4, order);
+                        result.size = loadFromBytes<uint32_t>(entry.data() + 8, order);
+                        result.info = entry[12];
+                        result.other = entry[13];
+                        result.sectionIndex = loadFromBytes<uint16_t>(entry.data() + 14, order);
+                    }
+                    return result;
+                }
+                /**
+                 * Gather st_info of the symbols starting at first into a contiguous buffer, returns the number written
+                 */
+                std::size_t gatherInfo(std::span<uint8_t> output, std::size_t first = 0) const noexcept {
+                    auto count = first < size() ? std::min(size() - first, output.size()) : 0;
+                    auto stride = _image->symbolEntrySize();
+                    auto offset = (first * stride) + (_image->is64Bit() ? 4 : 12);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        output[i] = _entries[(i * stride) + offset];
+                    }
+                    return count;
+                }
+                class Iterator final {
+                    public:
+                        using iterator_category = std::forward_iterator_tag;
+                        using value_type = Symbol;
+                        using difference_type = std::ptrdiff_t;
+                    public:
+                        Iterator() = default;
+                        Iterator(const Symbols* symbols, std::size_t index) noexcept : _symbols(symbols), _index(index) { }
+                        Symbol operator*() const noexcept { return (*_symbols)[_index]; }
+                        Iterator& operator++() noexcept { ++_index; return *this; }
+                        Iterator operator++(int) noexcept { auto copy = *this; ++_index; return copy; }
+                        bool operator==(const Iterator& other) const noexcept { return _index == other._index; }
+                    private:
+                        const Symbols* _symbols = nullptr;
+                        std::size_t _index = 0;
+                };
+                Iterator begin() const noexcept { return { this, 0 }; }
+                Iterator end() const noexcept { return { this, size() }; }
+            private:
+                const Image* _image;
+                std::span<const uint8_t> _entries;
+                std::span<const uint8_t> _strings;
+        };
+        std::size_t symbolEntrySize() const noexcept { return _is64 ? 24 : 16; }
+        /**
+         * The symbols of a SHT_SYMTAB or SHT_DYNSYM section (the string table is found through sh_link)
+         */
+        Symbols symbols(const Section& table) const noexcept {
+            auto strings = table.link < _sectionCount ? section(table.link).contents : std::span<const uint8_t> { };
+            auto entries = table.contents.first(table.contents.size() - (table.contents.size() % symbolEntrySize()));
+            return { *this, entries, strings };
+        }
+        /**
+         * Decode the entries of a SHT_REL or SHT_RELA section
+         */
+        template<typename Fn>
+        void forEachRelocation(const Section& table, Fn fn) const noexcept(noexcept(fn(Relocation { }))) {
+            auto withAddend = table.type == SectionTypeRelocationsWithAddends;
+            auto entrySize = (_is64 ? 8u : 4u) * (withAddend ? 3u : 2u);
+            auto order = _order;
+            for (std::size_t i = 0; (i + entrySize) <= table.contents.size(); i += entrySize) {
+                auto entry = table.contents.data() + i;
+                Relocation result { };
+                if (_is64) {
+                    result.offset = loadFromBytes<uint64_t>(entry, order);
+                    std::tie(result.symbol, result.type) = Relocation64Info::decode(loadFromBytes<uint64_t>(entry + 8, order));
+                    result.addend = withAddend ? loadFromBytes<int64_t>(entry + 16, order) : 0;
+                } else {
+                    result.offset = loadFromBytes<uint32_t>(entry, order);
+                    auto [symbol, type] = Relocation32Info::decode(loadFromBytes<uint32_t>(entry + 4, order));
+                    result.symbol = symbol;
+                    result.type = type;
+                    result.addend = withAddend ? loadFromBytes<int32_t>(entry + 8, order) : 0;
+                }
+                fn(result);
+            }
+        }
+    private:
+        bool fits(uint64_t offset, uint64_t length) const noexcept {
+            return offset <= _bytes.size() && length <= (_bytes.size() - offset);
+        }
+        template<typename T>
+        T load(uint64_t offset) const noexcept {
+            return fits(offset, sizeof(T)) ? loadFromBytes<T>(_bytes.data() + offset, _order) : T { };
+        }
+        uint16_t half(uint64_t offset) const noexcept { return load<uint16_t>(offset); }
+        /**
+         * An address or offset sized field, 4 or 8 bytes depending on the class
+         */
+        uint64_t word(uint64_t offset) const noexcept { return _is64 ? load<uint64_t>(offset) : load<uint32_t>(offset); }
+        static std::string_view string(std::span<const uint8_t> table, uint32_t offset) noexcept {
+            if (offset >= table.size()) {
+                return { };
+            }
+            auto start = reinterpret_cast<const char*>(table.data()) + offset;
+            return { start, ::strnlen(start, table.size() - offset) };
+        }
+    private:
+        std::span<const uint8_t> _bytes;
+        std::endian _order = std::endian::little;
+        uint64_t _sectionHeaderOffset = 0;
+        uint16_t _sectionHeaderSize = 0;
+        uint16_t _sectionCount = 0;
+        uint16_t _sectionNamesIndex = 0;
+        bool _is64 = false;
+        bool _valid = false;
+};
+
+/**
+ * Split gathered st_info bytes into bindings and types, a branch free loop
+ * over the HalfOf<uint8_t> patterns that the compiler vectorizes
+ */
+inline std::size_t splitSymbolInfo(std::span<const uint8_t> info, std::span<uint8_t> bindings, std::span<uint8_t> types) noexcept {
+    auto count = std::min({info.size(), bindings.size(), types.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        types[i] = SymbolType::decode(info[i]);
+        bindings[i] = SymbolBinding::decode(info[i]);
+    }
+    return count;
+}
+/**
+ * How many symbols there are of every binding/type combination, indexed by
+ * st_info itself (binding * 16 + type)
+ */
+using SymbolHistogram = std::array<std::size_t, 256>;
+inline void countSymbolKinds(const Image::Symbols& symbols, SymbolHistogram& histogram) noexcept {
+    // gather a batch at a time so the strided loads stay out of the counting loop
+    std::array<uint8_t, 1024> info;
+    for (std::size_t first = 0; first < symbols.size(); first += info.size()) {
+        auto gathered = symbols.gatherInfo(info, first);
+        for (std::size_t i = 0; i < gathered; ++i) {
+            ++histogram[info[i]];
+        }
+    }
+}
+constexpr std::size_t countOf(const SymbolHistogram& histogram, Binding binding, Type type) noexcept {
+    return histogram[SymbolInfo::encode(static_cast<uint8_t>(type), static_cast<uint8_t>(binding))];
+}
+
+/**
+ * Map and scan many files in parallel; fn(path, image) runs on a worker
+ * thread for every file that is a valid ELF image and the results are
+ * returned in input order (invalid files produce a default constructed result)
+ */
+template<typename Fn>
+auto scanFiles(std::span<const std::filesystem::path> paths, Fn fn, unsigned threads = 0) {
+    using Result = std::invoke_result_t<Fn, const std::filesystem::path&, const Image&>;
+    // every thread writes its own slots, a std::vector<bool> would pack
+    // neighbouring results into the same word
+    struct Slot {
+        Result value { };
+    };
+    std::vector<Slot> slots(paths.size());
+    std::atomic<std::size_t> next { 0 };
+    auto worker = [&] {
+        for (auto index = next++; index < paths.size(); index = next++) {
+            MappedFile file(paths[index].c_str());
+            if (Image image(file.bytes()); file.valid() && image.valid()) {
+                slots[index].value = fn(paths[index], image);
+            }
+        }
+    };
+    auto count = std::max(1u, std::min<unsigned>(threads != 0 ? threads : std::thread::hardware_concurrency(), static_cast<unsigned>(paths.size())));
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < count; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    std::vector<Result> results;
+    results.reserve(slots.size());
+    for (auto& slot : slots) {
+        results.push_back(std::move(slot.value));
+    }
+    return results;
+}
+
+} // end namespace BinaryManipulation::Elf
+#endif // BinaryManipulation_Elf_h__
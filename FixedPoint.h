@@ -0,0 +1,293 @@
+/**
+ * @file
+ * Fixed point quantities built out of integer and fraction field vectors
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_FixedPoint_h__
+#define BinaryManipulation_FixedPoint_h__
+#include "BinaryManipulation.h"
+#include <compare>
+#include <limits>
+namespace BinaryManipulation {
+
+/**
+ * A type twice as wide as T, used to hold intermediate products
+ */
+template<typename T>
+struct DoubleWidth final { };
+template<> struct DoubleWidth<int8_t> final { using Type = int16_t; };
+template<> struct DoubleWidth<int16_t> final { using Type = int32_t; };
+template<> struct DoubleWidth<int32_t> final { using Type = int64_t; };
+template<> struct DoubleWidth<uint8_t> final { using Type = uint16_t; };
+template<> struct DoubleWidth<uint16_t> final { using Type = uint32_t; };
+template<> struct DoubleWidth<uint32_t> final { using Type = uint64_t; };
+#ifdef __SIZEOF_INT128__
+template<> struct DoubleWidth<int64_t> final { __extension__ using Type = __int128; };
+template<> struct DoubleWidth<uint64_t> final { __extension__ using Type = unsigned __int128; };
+#endif
+template<typename T>
+using DoubleWidth_t = typename DoubleWidth<T>::Type;
+
+enum class RoundingMode {
+    /// Round towards negative infinity (an arithmetic shift)
+    Floor,
+    /// Round towards zero
+    TowardZero,
+    /// Round to nearest, ties away from zero
+    Nearest,
+    /// Round to nearest, ties to even
+    NearestEven,
+};
+
+/**
+ * Divide by 2^amount with the given rounding mode
+ */
+template<RoundingMode mode, typename W>
+constexpr W roundingShift(W value, std::size_t amount) noexcept {
+    if (amount == 0) {
+        return value;
+    }
+    const W one = 1;
+    const W half = one << (amount - 1);
+    const W fraction = value & ((one << amount) - one);
+    W result = value >> amount;
+    if constexpr (mode == RoundingMode::TowardZero) {
+        result += ((value < 0) && (fraction != 0)) ? one : 0;
+    } else if constexpr (mode == RoundingMode::Nearest) {
+        result += ((fraction > half) || ((fraction == half) && (value >= 0))) ? one : 0;
+    } else if constexpr (mode == RoundingMode::NearestEven) {
+        result += ((fraction > half) || ((fraction == half) && ((result & one) != 0))) ? one : 0;
+    }
+    return result;
+}
+static_assert(roundingShift<RoundingMode::Floor, int32_t>(-3, 1) == -2);
+static_assert(roundingShift<RoundingMode::TowardZero, int32_t>(-3, 1) == -1);
+static_assert(roundingShift<RoundingMode::Nearest, int32_t>(-3, 1) == -2);
+static_assert(roundingShift<RoundingMode::Nearest, int32_t>(3, 1) == 2);
+static_assert(roundingShift<RoundingMode::NearestEven, int32_t>(5, 1) == 2);
+static_assert(roundingShift<RoundingMode::NearestEven, int32_t>(-5, 1) == -2);
+
+/**
+ * Divide numerator by denominator with the given rounding mode
+ */
+template<RoundingMode mode, typename W>
+constexpr W roundingDivide(W numerator, W denominator) noexcept {
+    W quotient = numerator / denominator;
+    W remainder = numerator % denominator;
+    if (remainder == 0) {
+        return quotient;
+    }
+    const bool negative = (numerator < 0) != (denominator < 0);
+    const W direction = negative ? -1 : 1;
+    if constexpr (mode == RoundingMode::Floor) {
+        quotient -= negative ? 1 : 0;
+    } else if constexpr (mode == RoundingMode::Nearest || mode == RoundingMode::NearestEven) {
+        auto twiceRemainder = remainder < 0 ? -(remainder * 2) : (remainder * 2);
+        auto magnitude = denominator < 0 ? -denominator : denominator;
+        if (twiceRemainder > magnitude) {
+            quotient += direction;
+        } else if (twiceRemainder == magnitude) {
+            if constexpr (mode == RoundingMode::Nearest) {
+                quotient += direction;
+            } else {
+                quotient += (quotient & 1) ? direction : 0;
+            }
+        }
+    }
+    return quotient;
+}
+static_assert(roundingDivide<RoundingMode::Floor, int32_t>(-7, 2) == -4);
+static_assert(roundingDivide<RoundingMode::TowardZero, int32_t>(-7, 2) == -3);
+static_assert(roundingDivide<RoundingMode::Nearest, int32_t>(-7, 2) == -4);
+static_assert(roundingDivide<RoundingMode::NearestEven, int32_t>(7, 2) == 4);
+static_assert(roundingDivide<RoundingMode::NearestEven, int32_t>(5, 2) == 2);
+
+/**
+ * A fixed point quantity with FracBits bits of fraction stored in a T. The
+ * integer and fraction parts are FieldVectors over the raw bits so for
+ * Q16.16 and Q32.32 they are exactly the upper and lower halves.
+ */
+template<typename T, std::size_t FracBits>
+class Fixed final {
+    public:
+        static_assert(std::is_integral_v<T> && FracBits < BitCount<T>, "Fraction must fit inside of the storage type!");
+        using StorageType = T;
+        using UnsignedType = std::make_unsigned_t<T>;
+        using WideType = DoubleWidth_t<T>;
+        static constexpr auto FractionBits = FracBits;
+        static constexpr auto IntegerBits = BitCount<T> - FracBits;
+        using FractionPattern = FieldVector<T, UnsignedType, 0, FracBits>;
+        using IntegerPattern = FieldVector<T, T, FracBits, IntegerBits>;
+        using Fields = Description<T, FractionPattern, IntegerPattern>;
+        static constexpr T One = static_cast<T>(static_cast<UnsignedType>(1) << FracBits);
+    public:
+        constexpr Fixed() noexcept = default;
+        static constexpr Fixed fromRaw(T raw) noexcept { Fixed result; result._raw = raw; return result; }
+        static constexpr Fixed fromInteger(T value) noexcept { return fromRaw(static_cast<T>(static_cast<UnsignedType>(value) << FracBits)); }
+        static constexpr Fixed fromParts(T integer, UnsignedType fraction) noexcept {
+            return fromRaw(Fields::encode(std::move(fraction), std::move(integer)));
+        }
+        template<RoundingMode mode = RoundingMode::Nearest>
+        static constexpr Fixed fromDouble(double value) noexcept {
+            auto scaled = value * static_cast<double>(static_cast<WideType>(1) << FracBits);
+            auto truncated = static_cast<WideType>(scaled);
+            auto fraction = scaled - static_cast<double>(truncated);
+            if constexpr (mode == RoundingMode::Floor) {
+                truncated -= (fraction < 0) ? 1 : 0;
+            } else if constexpr (mode == RoundingMode::Nearest) {
+                truncated += (fraction >= 0.5) ? 1 : ((fraction <= -0.5) ? -1 : 0);
+            } else if constexpr (mode == RoundingMode::NearestEven) {
+                auto magnitude = fraction < 0 ? -fraction : fraction;
+                auto direction = fraction < 0 ? -1 : 1;
+                truncated += ((magnitude > 0.5) || ((magnitude == 0.5) && (truncated & 1))) ? direction : 0;
+            }
+            return fromRaw(static_cast<T>(truncated));
+        }
+        constexpr T raw() const noexcept { return _raw; }
+        /// The integer part, rounded towards negative infinity like an arithmetic shift
+        constexpr T integer() const noexcept { return IntegerPattern::decode(_raw); }
+        constexpr UnsignedType fraction() const noexcept { return FractionPattern::decode(_raw); }
+        constexpr double toDouble() const noexcept { return static_cast<double>(_raw) / static_cast<double>(static_cast<WideType>(1) << FracBits); }
+
+        constexpr Fixed operator-() const noexcept { return fromRaw(static_cast<T>(-static_cast<UnsignedType>(_raw))); }
+        friend constexpr Fixed operator+(Fixed a, Fixed b) noexcept { return fromRaw(static_cast<T>(static_cast<UnsignedType>(a._raw) + static_cast<UnsignedType>(b._raw))); }
+        friend constexpr Fixed operator-(Fixed a, Fixed b) noexcept { return fromRaw(static_cast<T>(static_cast<UnsignedType>(a._raw) - static_cast<UnsignedType>(b._raw))); }
+        friend constexpr Fixed operator*(Fixed a, Fixed b) noexcept { return multiply(a, b); }
+        friend constexpr Fixed operator/(Fixed a, Fixed b) noexcept { return divide(a, b); }
+        constexpr Fixed& operator+=(Fixed other) noexcept { return *this = *this + other; }
+        constexpr Fixed& operator-=(Fixed other) noexcept { return *this = *this - other; }
+        constexpr Fixed& operator*=(Fixed other) noexcept { return *this = *this * other; }
+        constexpr Fixed& operator/=(Fixed other) noexcept { return *this = *this / other; }
+        friend constexpr auto operator<=>(Fixed, Fixed) noexcept = default;
+
+        /**
+         * Multiply through the wide type, the result wraps if it does not fit
+         */
+        template<RoundingMode mode = RoundingMode::Nearest>
+        static constexpr Fixed multiply(Fixed a, Fixed b) noexcept {
+            return fromRaw(static_cast<T>(roundingShift<mode>(static_cast<WideType>(a._raw) * static_cast<WideType>(b._raw), FracBits)));
+        }
+        template<RoundingMode mode = RoundingMode::Nearest>
+        static constexpr Fixed divide(Fixed a, Fixed b) noexcept {
+            return fromRaw(static_cast<T>(roundingDivide<mode>(static_cast<WideType>(static_cast<WideType>(a._raw) << FracBits), static_cast<WideType>(b._raw))));
+        }
+        static constexpr Fixed max() noexcept { return fromRaw(std::numeric_limits<T>::max()); }
+        static constexpr Fixed min() noexcept { return fromRaw(std::numeric_limits<T>::min()); }
+        /**
+         * Clamp a wide raw value into the range of T
+         */
+        static constexpr Fixed saturate(WideType value) noexcept {
+            if (value > static_cast<WideType>(std::numeric_limits<T>::max())) {
+                return max();
+            } else if (value < static_cast<WideType>(std::numeric_limits<T>::min())) {
+                return min();
+            } else {
+                return fromRaw(static_cast<T>(value));
+            }
+        }
+        static constexpr Fixed saturatingAdd(Fixed a, Fixed b) noexcept { return saturate(static_cast<WideType>(a._raw) + b._raw); }
+        static constexpr Fixed saturatingSubtract(Fixed a, Fixed b) noexcept { return saturate(static_cast<WideType>(a._raw) - b._raw); }
+        template<RoundingMode mode = RoundingMode::Nearest>
+        static constexpr Fixed saturatingMultiply(Fixed a, Fixed b) noexcept {
+            // the product of two T's always fits in the wide type, so saturation only has to look at the rounded result
+            return saturate(roundingShift<mode>(static_cast<WideType>(a._raw) * static_cast<WideType>(b._raw), FracBits));
+        }
+        template<RoundingMode mode = RoundingMode::Nearest>
+        static constexpr Fixed saturatingDivide(Fixed a, Fixed b) noexcept {
+            if (b._raw == 0) {
+                return a._raw < 0 ? min() : max();
+            }
+            // the shifted numerator only fits when the integer part leaves room, which it does for the half split formats
+            return saturate(roundingDivide<mode>(static_cast<WideType>(static_cast<WideType>(a._raw) << FracBits), static_cast<WideType>(b._raw)));
+        }
+    private:
+        T _raw = 0;
+};
+
+template<typename T>
+using HalfSplitFixed = Fixed<T, HalfShiftAmount<T>>;
+using Q16_16 = HalfSplitFixed<int32_t>;
+using UQ16_16 = HalfSplitFixed<uint32_t>;
+#ifdef __SIZEOF_INT128__
+using Q32_32 = HalfSplitFixed<int64_t>;
+using UQ32_32 = HalfSplitFixed<uint64_t>;
+#endif
+
+// for the half split formats the fields are exactly the halves
+static_assert(Q16_16::IntegerPattern::Mask == static_cast<int32_t>(UpperHalfMask<uint32_t>));
+static_assert(Q16_16::FractionPattern::Mask == static_cast<int32_t>(LowerHalfMask<uint32_t>));
+static_assert((Q16_16::fromDouble(1.5) * Q16_16::fromDouble(-2.25)).toDouble() == -3.375);
+static_assert((Q16_16::fromInteger(1) / Q16_16::fromInteger(3)).raw() == 0x5555);
+static_assert(Q16_16::fromDouble(-1.5).integer() == -2);
+static_assert(Q16_16::fromDouble(-1.5).fraction() == 0x8000);
+static_assert(Q16_16::saturatingAdd(Q16_16::max(), Q16_16::fromInteger(1)) == Q16_16::max());
+static_assert(Q16_16::saturatingMultiply(Q16_16::fromInteger(-300), Q16_16::fromInteger(300)) == Q16_16::min());
+
+// Batch kernels. The products are accumulated in the wide type and only
+// rounded once at the end, which is both more accurate and leaves plain
+// widening multiply/add loops that the compiler vectorizes (pmuldq/vpmuldq
+// for Q16.16).
+
+/**
+ * Dot product of a and b added onto the accumulator
+ */
+template<typename F, RoundingMode mode = RoundingMode::Nearest>
+F multiplyAccumulate(std::span<const F> a, std::span<const F> b, F accumulator = { }) noexcept {
+    using T = typename F::StorageType;
+    using W = typename F::WideType;
+    static_assert(sizeof(F) == sizeof(T) && std::is_standard_layout_v<F>, "Fixed point values must be accessible as their raw storage!");
+    auto count = std::min(a.size(), b.size());
+    auto lhs = reinterpret_cast<const T*>(a.data());
+    auto rhs = reinterpret_cast<const T*>(b.data());
+    W sum = static_cast<W>(accumulator.raw()) << F::FractionBits;
+    for (std::size_t i = 0; i < count; ++i) {
+        sum += static_cast<W>(lhs[i]) * static_cast<W>(rhs[i]);
+    }
+    return F::fromRaw(static_cast<T>(roundingShift<mode>(sum, F::FractionBits)));
+}
+
+/**
+ * accumulators[i] += a[i] * b[i]
+ */
+template<typename F, RoundingMode mode = RoundingMode::Nearest>
+std::size_t multiplyAccumulate(std::span<const F> a, std::span<const F> b, std::span<F> accumulators) noexcept {
+    using T = typename F::StorageType;
+    using U = typename F::UnsignedType;
+    using W = typename F::WideType;
+    static_assert(sizeof(F) == sizeof(T) && std::is_standard_layout_v<F>, "Fixed point values must be accessible as their raw storage!");
+    auto count = std::min({a.size(), b.size(), accumulators.size()});
+    auto lhs = reinterpret_cast<const T*>(a.data());
+    auto rhs = reinterpret_cast<const T*>(b.data());
+    auto acc = reinterpret_cast<T*>(accumulators.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        auto product = roundingShift<mode>(static_cast<W>(lhs[i]) * static_cast<W>(rhs[i]), F::FractionBits);
+        acc[i] = static_cast<T>(static_cast<U>(acc[i]) + static_cast<U>(product));
+    }
+    return count;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_FixedPoint_h__
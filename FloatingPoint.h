@@ -0,0 +1,302 @@
+/**
+ * @file
+ * Sign, exponent, and mantissa layouts of IEEE-754 floating point types
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_FloatingPoint_h__
+#define BinaryManipulation_FloatingPoint_h__
+#include "BinaryManipulation.h"
+#include <limits>
+namespace BinaryManipulation {
+
+/**
+ * Broad categories a floating point value falls into, same idea as std::fpclassify
+ */
+enum class FloatingPointCategory : uint8_t {
+    Normal = 0,
+    Zero,
+    Subnormal,
+    Infinite,
+    NaN,
+    Count,
+};
+
+/**
+ * Describes a binary interchange format where the bits (low to high) are
+ * mantissa, biased exponent, and sign. Values are moved in and out of the
+ * bits type with std::bit_cast so floating point values can be given directly.
+ */
+template<typename F, typename B, typename E, std::size_t exponentBits, std::size_t mantissaBits>
+class IEEE754Layout final {
+    public:
+        using FloatType = F;
+        using BitsType = B;
+        using MantissaType = B;
+        using ExponentType = E;
+        static_assert(sizeof(F) == sizeof(B), "Floating point type and its bits must be the same size!");
+        static constexpr auto ExponentBits = exponentBits;
+        static constexpr auto MantissaBits = mantissaBits;
+        static constexpr E MaxExponent = static_cast<E>(computeMaskFromLength<B>(exponentBits));
+        static constexpr E Bias = static_cast<E>(MaxExponent >> 1);
+        static constexpr B SignPosition = mantissaBits + exponentBits;
+        using MantissaPattern = FieldVector<B, B, 0, mantissaBits>;
+        using ExponentPattern = FieldVector<B, E, mantissaBits, exponentBits>;
+        using SignPattern = Flag<B, SignPosition>;
+        using Fields = Description<B, MantissaPattern, ExponentPattern, SignPattern>;
+    public:
+        IEEE754Layout() = delete;
+        ~IEEE754Layout() = delete;
+        static constexpr B toBits(F value) noexcept { return std::bit_cast<B>(value); }
+        static constexpr F fromBits(B value) noexcept { return std::bit_cast<F>(value); }
+        static constexpr B mantissa(B bits) noexcept { return MantissaPattern::decode(bits); }
+        static constexpr E exponent(B bits) noexcept { return ExponentPattern::decode(bits); }
+        static constexpr bool sign(B bits) noexcept { return SignPattern::decode(bits); }
+        static constexpr B compose(B mantissa, E exponent, bool sign) noexcept {
+            return Fields::encode(std::move(mantissa), std::move(exponent), std::move(sign));
+        }
+        /**
+         * Returns (mantissa, biased exponent, sign)
+         */
+        static constexpr auto decode(F value) noexcept { return Fields::decode(toBits(value)); }
+        static constexpr F encode(B mantissa, E exponent, bool sign) noexcept {
+            return fromBits(compose(mantissa, exponent, sign));
+        }
+        /**
+         * Branch free so that loops over it vectorize
+         */
+        static constexpr FloatingPointCategory categorizeBits(B bits) noexcept {
+            auto exponent = ExponentPattern::decode(bits);
+            auto mantissaIsZero = static_cast<int>(MantissaPattern::decode(bits) == 0);
+            auto exponentIsZero = static_cast<int>(exponent == 0);
+            auto exponentIsMax = static_cast<int>(exponent == MaxExponent);
+            return static_cast<FloatingPointCategory>((exponentIsZero * (2 - mantissaIsZero)) + (exponentIsMax * (4 - mantissaIsZero)));
+        }
+        static constexpr FloatingPointCategory categorize(F value) noexcept { return categorizeBits(toBits(value)); }
+};
+
+using FloatLayout = IEEE754Layout<float, uint32_t, uint8_t, 8, 23>;
+using DoubleLayout = IEEE754Layout<double, uint64_t, uint16_t, 11, 52>;
+using FloatDescription = FloatLayout::Fields;
+using DoubleDescription = DoubleLayout::Fields;
+
+static_assert(std::get<1>(FloatLayout::decode(1.0f)) == 127);
+static_assert(std::get<2>(FloatLayout::decode(-2.0f)));
+static_assert(DoubleLayout::encode(0, DoubleLayout::Bias + 1, true) == -2.0);
+static_assert(FloatLayout::categorize(std::numeric_limits<float>::infinity()) == FloatingPointCategory::Infinite);
+static_assert(DoubleLayout::categorize(std::numeric_limits<double>::denorm_min()) == FloatingPointCategory::Subnormal);
+static_assert(DoubleLayout::categorize(-0.0) == FloatingPointCategory::Zero);
+
+/**
+ * The x87 80-bit extended format. Unlike the interchange formats it carries an
+ * explicit integer bit and is split into a 64-bit significand and a 16-bit
+ * sign/exponent word (followed by padding), so its bits are the Bits struct
+ * rather than an integer. The mantissa is the whole significand.
+ */
+class X87ExtendedLayout final {
+    public:
+        using FloatType = long double;
+        struct Bits {
+            uint64_t significand;
+            uint16_t signExponent;
+            uint8_t padding[sizeof(long double) - sizeof(uint64_t) - sizeof(uint16_t)];
+        };
+        using BitsType = Bits;
+        using MantissaType = uint64_t;
+        using ExponentType = uint16_t;
+        static constexpr ExponentType MaxExponent = 0x7FFF;
+        static constexpr ExponentType Bias = 0x3FFF;
+        using FractionPattern = FieldVector<uint64_t, uint64_t, 0, 63>;
+        using IntegerBitPattern = Flag<uint64_t, 63>;
+        using SignificandFields = Description<uint64_t, FractionPattern, IntegerBitPattern>;
+        using ExponentPattern = FieldVector<uint16_t, uint16_t, 0, 15>;
+        using SignPattern = Flag<uint16_t, 15>;
+        using SignExponentFields = Description<uint16_t, ExponentPattern, SignPattern>;
+    public:
+        X87ExtendedLayout() = delete;
+        ~X87ExtendedLayout() = delete;
+        static Bits toBits(long double value) noexcept {
+            static_assert(std::numeric_limits<long double>::digits == 64, "long double is not the x87 extended format on this target!");
+            return std::bit_cast<Bits>(value);
+        }
+        static long double fromBits(const Bits& bits) noexcept { return std::bit_cast<long double>(bits); }
+        static constexpr MantissaType mantissa(const Bits& bits) noexcept { return bits.significand; }
+        static constexpr ExponentType exponent(const Bits& bits) noexcept { return ExponentPattern::decode(bits.signExponent); }
+        static constexpr bool sign(const Bits& bits) noexcept { return SignPattern::decode(bits.signExponent); }
+        static constexpr Bits compose(MantissaType significand, ExponentType exponent, bool sign) noexcept {
+            return { significand, SignExponentFields::encode(std::move(exponent), std::move(sign)), { } };
+        }
+        /**
+         * Returns (significand including the integer bit, biased exponent, sign)
+         */
+        static auto decode(long double value) noexcept {
+            auto bits = toBits(value);
+            return std::make_tuple(mantissa(bits), exponent(bits), sign(bits));
+        }
+        static long double encode(uint64_t significand, uint16_t exponent, bool sign) noexcept {
+            return fromBits(compose(significand, exponent, sign));
+        }
+        /**
+         * Same categories as the interchange formats. A clear integer bit with a
+         * nonzero exponent (unnormals, pseudo infinities and NaNs) is rejected by
+         * the FPU as an invalid operand so it counts as NaN.
+         */
+        static constexpr FloatingPointCategory categorizeBits(const Bits& bits) noexcept {
+            auto exp = exponent(bits);
+            auto significandIsZero = static_cast<int>(bits.significand == 0);
+            auto fractionIsZero = static_cast<int>(FractionPattern::decode(bits.significand) == 0);
+            auto integerIsClear = static_cast<int>(!IntegerBitPattern::decode(bits.significand));
+            auto exponentIsZero = static_cast<int>(exp == 0);
+            auto exponentIsMax = static_cast<int>(exp == MaxExponent);
+            auto invalid = (1 - exponentIsZero) * integerIsClear;
+            return static_cast<FloatingPointCategory>((exponentIsZero * (2 - significandIsZero)) +
+                                                      ((1 - invalid) * exponentIsMax * (4 - fractionIsZero)) + (invalid * 4));
+        }
+        static FloatingPointCategory categorize(long double value) noexcept { return categorizeBits(toBits(value)); }
+};
+
+static_assert(X87ExtendedLayout::categorizeBits(X87ExtendedLayout::compose(0x8000'0000'0000'0000, X87ExtendedLayout::MaxExponent, true)) == FloatingPointCategory::Infinite);
+static_assert(X87ExtendedLayout::categorizeBits(X87ExtendedLayout::compose(1, 0, false)) == FloatingPointCategory::Subnormal);
+static_assert(X87ExtendedLayout::categorizeBits(X87ExtendedLayout::compose(1, X87ExtendedLayout::Bias, false)) == FloatingPointCategory::NaN);
+
+/**
+ * Map a floating point type to its layout
+ */
+template<typename F>
+struct FloatingPointLayoutOf final { };
+template<>
+struct FloatingPointLayoutOf<float> final { using Type = FloatLayout; };
+template<>
+struct FloatingPointLayoutOf<double> final { using Type = DoubleLayout; };
+template<>
+struct FloatingPointLayoutOf<long double> final {
+    using Type = std::conditional_t<std::numeric_limits<long double>::digits == std::numeric_limits<double>::digits,
+                                    IEEE754Layout<long double, uint64_t, uint16_t, 11, 52>,
+                                    X87ExtendedLayout>;
+};
+template<typename F>
+using FloatingPointLayout_t = typename FloatingPointLayoutOf<F>::Type;
+using LongDoubleLayout = FloatingPointLayout_t<long double>;
+
+// Batch kernels. They are written as straight line loops over the fields so the
+// compiler can vectorize them; each returns the number of elements processed.
+
+template<typename F>
+std::size_t categorize(std::span<const F> input, std::span<FloatingPointCategory> output) noexcept {
+    using Layout = FloatingPointLayout_t<F>;
+    auto count = std::min(input.size(), output.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = Layout::categorize(input[i]);
+    }
+    return count;
+}
+
+template<typename F>
+std::array<std::size_t, static_cast<std::size_t>(FloatingPointCategory::Count)> countCategories(std::span<const F> input) noexcept {
+    using Layout = FloatingPointLayout_t<F>;
+    std::array<std::size_t, static_cast<std::size_t>(FloatingPointCategory::Count)> result { };
+    for (auto value : input) {
+        ++result[static_cast<std::size_t>(Layout::categorize(value))];
+    }
+    return result;
+}
+
+/**
+ * Accumulate the biased exponents of the input into the given histogram which
+ * must have at least MaxExponent + 1 bins. Returns the number of elements
+ * counted, which is zero when the histogram is too short.
+ */
+template<typename F>
+std::size_t exponentHistogram(std::span<const F> input, std::span<std::size_t> histogram) noexcept {
+    using Layout = FloatingPointLayout_t<F>;
+    constexpr std::size_t Bins = static_cast<std::size_t>(Layout::MaxExponent) + 1;
+    if (histogram.size() < Bins) {
+        return 0;
+    }
+    // spread consecutive elements over several sub histograms so runs of
+    // equal exponents do not serialize on the same counter, as long as they
+    // fit in a few pages of stack
+    constexpr std::size_t Ways = (4 * Bins * sizeof(std::size_t)) <= 8192 ? 4 : 1;
+    if constexpr (Ways == 1) {
+        for (auto value : input) {
+            ++histogram[Layout::exponent(Layout::toBits(value))];
+        }
+    } else {
+        std::array<std::array<std::size_t, Bins>, Ways> partial { };
+        std::size_t i = 0;
+        for (; (i + Ways) <= input.size(); i += Ways) {
+            for (std::size_t w = 0; w < Ways; ++w) {
+                ++partial[w][Layout::exponent(Layout::toBits(input[i + w]))];
+            }
+        }
+        for (; i < input.size(); ++i) {
+            ++partial[0][Layout::exponent(Layout::toBits(input[i]))];
+        }
+        for (std::size_t b = 0; b < Bins; ++b) {
+            for (std::size_t w = 0; w < Ways; ++w) {
+                histogram[b] += partial[w][b];
+            }
+        }
+    }
+    return input.size();
+}
+
+/**
+ * Split every value into separate mantissa, exponent, and sign arrays
+ */
+template<typename F>
+std::size_t decompose(std::span<const F> input,
+                      std::span<typename FloatingPointLayout_t<F>::MantissaType> mantissas,
+                      std::span<typename FloatingPointLayout_t<F>::ExponentType> exponents,
+                      std::span<bool> signs) noexcept {
+    using Layout = FloatingPointLayout_t<F>;
+    auto count = std::min({input.size(), mantissas.size(), exponents.size(), signs.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        auto bits = Layout::toBits(input[i]);
+        mantissas[i] = Layout::mantissa(bits);
+        exponents[i] = Layout::exponent(bits);
+        signs[i] = Layout::sign(bits);
+    }
+    return count;
+}
+
+/**
+ * Inverse of decompose
+ */
+template<typename F>
+std::size_t rebuild(std::span<const typename FloatingPointLayout_t<F>::MantissaType> mantissas,
+                    std::span<const typename FloatingPointLayout_t<F>::ExponentType> exponents,
+                    std::span<const bool> signs,
+                    std::span<F> output) noexcept {
+    using Layout = FloatingPointLayout_t<F>;
+    auto count = std::min({output.size(), mantissas.size(), exponents.size(), signs.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = Layout::fromBits(Layout::compose(mantissas[i], exponents[i], signs[i]));
+    }
+    return count;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_FloatingPoint_h__
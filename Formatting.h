@@ -0,0 +1,260 @@
+/**
+ * @file
+ * Allocation free text formatting of Pattern and Description values
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Formatting_h__
+#define BinaryManipulation_Formatting_h__
+#include "BinaryManipulation.h"
+#include <charconv>
+#include <string_view>
+namespace BinaryManipulation {
+
+enum class FieldFormat {
+    Hex,
+    Binary,
+    Decimal,
+};
+
+/**
+ * Number of bits a decoded field can occupy
+ */
+template<typename P>
+constexpr std::size_t FieldBits = std::bit_width(static_cast<std::make_unsigned_t<typename P::DataType>>(P::Mask) >> P::Shift);
+/**
+ * Least and most significant bit positions a pattern covers within its DataType
+ */
+template<typename P>
+constexpr std::size_t FieldLowBit = std::countr_zero(static_cast<std::make_unsigned_t<typename P::DataType>>(P::Mask));
+template<typename P>
+constexpr std::size_t FieldHighBit = std::bit_width(static_cast<std::make_unsigned_t<typename P::DataType>>(P::Mask)) - 1;
+
+/**
+ * The decoded field as raw bits, signed and enum slices are not sign extended
+ */
+template<typename P>
+constexpr uint64_t fieldBits(typename P::DataType word) noexcept {
+    auto value = static_cast<uint64_t>(P::decode(word));
+    if constexpr (FieldBits<P> < 64) {
+        value &= computeMaskFromLength<uint64_t>(FieldBits<P>);
+    }
+    return value;
+}
+
+namespace Formatting {
+constexpr std::string_view Digits = "0123456789abcdef";
+constexpr std::size_t MaximumFieldLength = sizeof("[63:63]=0b") + 64;
+/**
+ * Write value as exactly digits characters in a power of two radix
+ */
+constexpr std::to_chars_result writeFixed(char* first, char* last, uint64_t value, std::size_t digits, std::size_t bitsPerDigit) noexcept {
+    if (static_cast<std::size_t>(last - first) < digits) {
+        return { last, std::errc::value_too_large };
+    }
+    auto digitMask = (uint64_t(1) << bitsPerDigit) - 1;
+    for (std::size_t i = 0; i < digits; ++i) {
+        first[digits - 1 - i] = Digits[value & digitMask];
+        value >>= bitsPerDigit;
+    }
+    return { first + digits, std::errc { } };
+}
+constexpr std::to_chars_result writeText(char* first, char* last, std::string_view text) noexcept {
+    if (static_cast<std::size_t>(last - first) < text.size()) {
+        return { last, std::errc::value_too_large };
+    }
+    return { std::copy(text.begin(), text.end(), first), std::errc { } };
+}
+inline std::to_chars_result writeField(char* first, char* last, uint64_t value, std::size_t bits, FieldFormat format) noexcept {
+    switch (format) {
+        case FieldFormat::Hex:
+            if (auto prefix = writeText(first, last, "0x"); prefix.ec == std::errc { }) {
+                return writeFixed(prefix.ptr, last, value, (bits + 3) / 4, 4);
+            } else {
+                return prefix;
+            }
+        case FieldFormat::Binary:
+            if (auto prefix = writeText(first, last, "0b"); prefix.ec == std::errc { }) {
+                return writeFixed(prefix.ptr, last, value, bits, 1);
+            } else {
+                return prefix;
+            }
+        default:
+            return std::to_chars(first, last, value);
+    }
+}
+/**
+ * The "[high:low]=" prefix of an annotated field, built at compile time
+ */
+struct Annotation final {
+    std::array<char, sizeof("[127:127]=")> text { };
+    std::size_t length = 0;
+    constexpr void append(std::size_t value) noexcept {
+        if (value >= 10) {
+            append(value / 10);
+        }
+        text[length++] = Digits[value % 10];
+    }
+    constexpr std::string_view view() const noexcept { return { text.data(), length }; }
+};
+template<typename P>
+constexpr auto AnnotationOf = [] {
+    Annotation result;
+    result.text[result.length++] = '[';
+    result.append(FieldHighBit<P>);
+    result.text[result.length++] = ':';
+    result.append(FieldLowBit<P>);
+    result.text[result.length++] = ']';
+    result.text[result.length++] = '=';
+    return result;
+}();
+template<typename P>
+constexpr std::size_t leafCount() noexcept {
+    if constexpr (IsDescription<P>) {
+        return []<std::size_t ... I>(std::index_sequence<I...>) { return (leafCount<PatternAt_t<P, I>>() + ... + 0); }(std::make_index_sequence<P::NumberOfPatterns> {});
+    } else {
+        return 1;
+    }
+}
+} // end namespace Formatting
+
+/**
+ * Upper bound on the characters toChars can produce for the given pattern or description
+ */
+template<typename P>
+constexpr std::size_t FormattedLengthBound = Formatting::leafCount<P>() * (Formatting::MaximumFieldLength + sizeof("{ } ")) + sizeof("{ }");
+
+/**
+ * Format the field(s) of word described by P into [first, last) without
+ * allocating. Descriptions become their fields separated by spaces (nested
+ * descriptions are braced), annotated output prefixes every field with the
+ * bit range it occupies (e.g. [31:24]=0x8c). Follows std::to_chars, ec is
+ * value_too_large and ptr is last when the buffer is too small.
+ */
+template<typename P>
+std::to_chars_result toChars(char* first, char* last, typename P::DataType word, FieldFormat format = FieldFormat::Hex, bool annotate = false) noexcept {
+    if constexpr (IsDescription<P>) {
+        std::to_chars_result result { first, std::errc { } };
+        [&]<std::size_t ... I>(std::index_sequence<I...>) {
+            ([&] {
+                if (result.ec != std::errc { }) {
+                    return;
+                }
+                using Inner = PatternAt_t<P, I>;
+                if constexpr (I != 0) {
+                    result = Formatting::writeText(result.ptr, last, " ");
+                }
+                if constexpr (IsDescription<Inner>) {
+                    if (result.ec == std::errc { }) {
+                        result = Formatting::writeText(result.ptr, last, "{ ");
+                    }
+                    if (result.ec == std::errc { }) {
+                        result = toChars<Inner>(result.ptr, last, word, format, annotate);
+                    }
+                    if (result.ec == std::errc { }) {
+                        result = Formatting::writeText(result.ptr, last, " }");
+                    }
+                } else if (result.ec == std::errc { }) {
+                    result = toChars<Inner>(result.ptr, last, word, format, annotate);
+                }
+            }(), ...);
+        }(std::make_index_sequence<P::NumberOfPatterns> {});
+        return result;
+    } else {
+        std::to_chars_result result { first, std::errc { } };
+        if (annotate) {
+            result = Formatting::writeText(first, last, Formatting::AnnotationOf<P>.view());
+        }
+        if (result.ec == std::errc { }) {
+            result = Formatting::writeField(result.ptr, last, fieldBits<P>(word), FieldBits<P>, format);
+        }
+        return result;
+    }
+}
+template<typename P>
+std::to_chars_result toChars(std::span<char> buffer, typename P::DataType word, FieldFormat format = FieldFormat::Hex, bool annotate = false) noexcept {
+    return toChars<P>(buffer.data(), buffer.data() + buffer.size(), word, format, annotate);
+}
+
+/**
+ * Appends formatted values to a caller supplied buffer, the owner flushes it
+ * when full() says so
+ */
+class FormatBuffer final {
+    public:
+        constexpr explicit FormatBuffer(std::span<char> storage) noexcept : _storage(storage) { }
+        template<typename P>
+        bool write(typename P::DataType word, FieldFormat format = FieldFormat::Hex, bool annotate = false) noexcept {
+            return commit(toChars<P>(current(), end(), word, format, annotate));
+        }
+        bool write(std::string_view text) noexcept {
+            return commit(Formatting::writeText(current(), end(), text));
+        }
+        bool write(char c) noexcept {
+            return write(std::string_view(&c, 1));
+        }
+        /**
+         * Write an unsigned value as zero padded hex with the given number of digits
+         */
+        bool writeHex(uint64_t value, std::size_t digits) noexcept {
+            return commit(Formatting::writeFixed(current(), end(), value, digits, 4));
+        }
+        /**
+         * Write an unsigned value as hex with only as many digits as needed
+         */
+        bool writeHex(uint64_t value) noexcept {
+            return commit(std::to_chars(current(), end(), value, 16));
+        }
+        bool writeDecimal(int64_t value) noexcept {
+            return commit(std::to_chars(current(), end(), value));
+        }
+        constexpr std::string_view view() const noexcept { return { _storage.data(), _used }; }
+        constexpr std::size_t size() const noexcept { return _used; }
+        constexpr std::size_t remaining() const noexcept { return _storage.size() - _used; }
+        constexpr bool full(std::size_t reserve) const noexcept { return remaining() < reserve; }
+        constexpr void clear() noexcept { _used = 0; }
+        /**
+         * Drop everything written after the given size
+         */
+        constexpr void truncate(std::size_t size) noexcept { _used = std::min(size, _used); }
+    private:
+        constexpr char* current() const noexcept { return _storage.data() + _used; }
+        constexpr char* end() const noexcept { return _storage.data() + _storage.size(); }
+        // writes are all or nothing, a partial field is discarded
+        constexpr bool commit(std::to_chars_result result) noexcept {
+            if (result.ec != std::errc { }) {
+                return false;
+            }
+            _used = static_cast<std::size_t>(result.ptr - _storage.data());
+            return true;
+        }
+    private:
+        std::span<char> _storage;
+        std::size_t _used = 0;
+};
+
+} // end namespace BinaryManipulation
+
+#endif // BinaryManipulation_Formatting_h__
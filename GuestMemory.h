@@ -0,0 +1,175 @@
+/**
+ * @file
+ * Sparse little endian guest memory with page granular host backing
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_GuestMemory_h__
+#define BinaryManipulation_GuestMemory_h__
+#include "BinaryManipulation.h"
+#include "Mmu.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
+namespace BinaryManipulation {
+
+/**
+ * A little endian guest address space backed one host page at a time.
+ * Every page starts out reading as zero through a shared zero page and is
+ * only given its own backing when first written. An access that fits in
+ * its page, which is every aligned one, is a single host load or store;
+ * one that crosses into the next page is split into the bytes on either
+ * side and assembled with the same byte lanes getQuarters describes,
+ * lowest address in the least significant byte.
+ */
+template<typename A = uint32_t, std::size_t pageBits = 12>
+class GuestMemory final {
+    public:
+        static_assert(std::is_unsigned_v<A>);
+        static_assert(((sizeof(A) * CHAR_BIT) - pageBits) <= 24, "the page directory is a flat array");
+        using Address = A;
+        using Layout = AddressLayout<A, pageBits, (sizeof(A) * CHAR_BIT) - pageBits>;
+        static constexpr std::size_t PageSize = Layout::PageSize;
+        static constexpr std::size_t PageCount = std::size_t { 1 } << Layout::PageNumberBits;
+    public:
+        GuestMemory() : _zero(std::make_unique<Page>()), _directory(PageCount, _zero.get()) { }
+        /**
+         * Read a byte, short, word or long at any alignment
+         */
+        template<typename T>
+        T load(Address address) const noexcept {
+            static_assert(std::is_unsigned_v<T> && sizeof(T) <= PageSize);
+            auto offset = Layout::Offset::decode(address);
+            if (offset <= (PageSize - sizeof(T))) [[likely]] {
+                return loadFromBytes<T>(pageOf(address)->data() + offset);
+            }
+            std::array<uint8_t, sizeof(T)> bytes;
+            read(address, bytes);
+            return loadFromBytes<T>(bytes.data());
+        }
+        template<typename T>
+        void store(Address address, T value) {
+            static_assert(std::is_unsigned_v<T> && sizeof(T) <= PageSize);
+            auto bytes = std::endian::native == std::endian::little ? value : reverseBytes(value);
+            auto offset = Layout::Offset::decode(address);
+            if (offset <= (PageSize - sizeof(T))) [[likely]] {
+                std::memcpy(writablePageOf(address)->data() + offset, &bytes, sizeof(T));
+                return;
+            }
+            write(address, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&bytes), sizeof(T)));
+        }
+        /**
+         * Copy out of guest memory, a page at a time
+         */
+        void read(Address address, std::span<uint8_t> output) const noexcept {
+            for (std::size_t done = 0; done < output.size();) {
+                auto count = chunk(address, output.size() - done);
+                std::memcpy(output.data() + done, pageOf(address)->data() + Layout::Offset::decode(address), count);
+                done += count;
+                address += static_cast<Address>(count);
+            }
+        }
+        void write(Address address, std::span<const uint8_t> input) {
+            for (std::size_t done = 0; done < input.size();) {
+                auto count = chunk(address, input.size() - done);
+                std::memcpy(writablePageOf(address)->data() + Layout::Offset::decode(address), input.data() + done, count);
+                done += count;
+                address += static_cast<Address>(count);
+            }
+        }
+        /**
+         * Set count bytes to value, zeroing a page that was never written leaves it unbacked
+         */
+        void fill(Address address, std::size_t count, uint8_t value) {
+            while (count > 0) {
+                auto length = chunk(address, count);
+                if (value != 0 || pageOf(address) != _zero.get()) {
+                    std::memset(writablePageOf(address)->data() + Layout::Offset::decode(address), value, length);
+                }
+                count -= length;
+                address += static_cast<Address>(length);
+            }
+        }
+        /**
+         * Copy count bytes with memmove semantics, overlapping ranges copy
+         * from the end when the destination is above the source
+         */
+        void move(Address destination, Address source, std::size_t count);
+        /**
+         * Number of pages that have been given their own backing
+         */
+        std::size_t backedPages() const noexcept { return _pages.size(); }
+    private:
+        using Page = std::array<uint8_t, PageSize>;
+        // bytes from address to the end of its page, at most count
+        static constexpr std::size_t chunk(Address address, std::size_t count) noexcept {
+            return std::min(count, PageSize - Layout::Offset::decode(address));
+        }
+        const Page* pageOf(Address address) const noexcept { return _directory[Layout::PageNumber::decode(address)]; }
+        Page* writablePageOf(Address address) {
+            auto& page = _directory[Layout::PageNumber::decode(address)];
+            if (page == _zero.get()) [[unlikely]] {
+                page = _pages.emplace_back(std::make_unique<Page>()).get();
+            }
+            return page;
+        }
+    private:
+        std::unique_ptr<Page> _zero;
+        std::vector<Page*> _directory;
+        std::vector<std::unique_ptr<Page>> _pages;
+};
+
+template<typename A, std::size_t pageBits>
+void GuestMemory<A, pageBits>::move(Address destination, Address source, std::size_t count) {
+    if (static_cast<std::size_t>(static_cast<Address>(destination - source)) >= count) {
+        while (count > 0) {
+            auto length = std::min(chunk(source, count), chunk(destination, count));
+            auto from = pageOf(source)->data() + Layout::Offset::decode(source);
+            std::memmove(writablePageOf(destination)->data() + Layout::Offset::decode(destination), from, length);
+            count -= length;
+            source += static_cast<Address>(length);
+            destination += static_cast<Address>(length);
+        }
+        return;
+    }
+    // the destination starts inside the source so the tail has to move first
+    auto sourceEnd = static_cast<Address>(source + count);
+    auto destinationEnd = static_cast<Address>(destination + count);
+    while (count > 0) {
+        auto length = std::min({ count, Layout::Offset::decode(static_cast<Address>(sourceEnd - 1)) + std::size_t { 1 },
+                Layout::Offset::decode(static_cast<Address>(destinationEnd - 1)) + std::size_t { 1 } });
+        sourceEnd -= static_cast<Address>(length);
+        destinationEnd -= static_cast<Address>(length);
+        auto from = pageOf(sourceEnd)->data() + Layout::Offset::decode(sourceEnd);
+        std::memmove(writablePageOf(destinationEnd)->data() + Layout::Offset::decode(destinationEnd), from, length);
+        count -= length;
+    }
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_GuestMemory_h__
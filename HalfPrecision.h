@@ -0,0 +1,171 @@
+/**
+ * @file
+ * Conversions between float and the 16-bit binary16 and bfloat16 formats
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_HalfPrecision_h__
+#define BinaryManipulation_HalfPrecision_h__
+#include "FloatingPoint.h"
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+// There is no portable 16-bit floating point type so both formats use their
+// bits as the "floating point" type of the layout.
+using Binary16Layout = IEEE754Layout<uint16_t, uint16_t, uint8_t, 5, 10>;
+using BFloat16Layout = IEEE754Layout<uint16_t, uint16_t, uint8_t, 8, 7>;
+
+static_assert(Binary16Layout::Bias == 15);
+static_assert(BFloat16Layout::Bias == FloatLayout::Bias);
+
+/**
+ * Round to nearest even conversion from float to binary16. Overflow goes to
+ * infinity, NaNs stay NaNs (quieted, upper payload bits kept), and values
+ * below the normal range round into the subnormals. Every path is computed
+ * and then selected so that loops over it vectorize.
+ */
+constexpr uint16_t floatToHalf(float value) noexcept {
+    constexpr auto MantissaDrop = FloatLayout::MantissaBits - Binary16Layout::MantissaBits;
+    constexpr auto BiasDifference = static_cast<uint32_t>(FloatLayout::Bias - Binary16Layout::Bias);
+    // smallest float which overflows binary16 once rounded, and the smallest normal binary16
+    constexpr uint32_t Overflow = (BiasDifference + Binary16Layout::MaxExponent) << FloatLayout::MantissaBits;
+    constexpr uint32_t SmallestNormal = (BiasDifference + 1) << FloatLayout::MantissaBits;
+    // adding this constant lets the FPU do the subnormal rounding for us
+    constexpr uint32_t SubnormalMagic = (BiasDifference + MantissaDrop + 1) << FloatLayout::MantissaBits;
+    auto bits = FloatLayout::toBits(value);
+    auto sign = static_cast<uint16_t>(FloatLayout::SignPattern::encode(FloatLayout::SignPattern::decode(bits)) >> 16);
+    auto magnitude = bits & ~FloatLayout::SignPattern::Mask;
+
+    auto isNaN = magnitude > FloatLayout::ExponentPattern::Mask;
+    auto nanOrInfinity = static_cast<uint16_t>(Binary16Layout::ExponentPattern::Mask |
+                                               (isNaN ? (0x200 | ((magnitude >> MantissaDrop) & Binary16Layout::MantissaPattern::Mask)) : 0));
+    auto subnormal = static_cast<uint16_t>(FloatLayout::toBits(FloatLayout::fromBits(magnitude) + FloatLayout::fromBits(SubnormalMagic)) - SubnormalMagic);
+    // round to nearest even by adding just under half an ulp plus the lowest kept bit
+    auto lowestKeptBit = (magnitude >> MantissaDrop) & 1;
+    auto normal = static_cast<uint16_t>((magnitude - (BiasDifference << FloatLayout::MantissaBits) + ((1u << (MantissaDrop - 1)) - 1) + lowestKeptBit) >> MantissaDrop);
+    auto result = magnitude >= Overflow ? nanOrInfinity : (magnitude < SmallestNormal ? subnormal : normal);
+    return static_cast<uint16_t>(result | sign);
+}
+
+/**
+ * Exact conversion from binary16 to float
+ */
+constexpr float halfToFloat(uint16_t value) noexcept {
+    constexpr auto MantissaDrop = FloatLayout::MantissaBits - Binary16Layout::MantissaBits;
+    constexpr auto BiasDifference = static_cast<uint32_t>(FloatLayout::Bias - Binary16Layout::Bias);
+    constexpr uint32_t ShiftedExponent = static_cast<uint32_t>(Binary16Layout::ExponentPattern::Mask) << MantissaDrop;
+    constexpr uint32_t SubnormalMagic = (BiasDifference + 1) << FloatLayout::MantissaBits;
+    auto magnitude = static_cast<uint32_t>(value & ~Binary16Layout::SignPattern::Mask) << MantissaDrop;
+    auto exponent = magnitude & ShiftedExponent;
+    auto rebiased = magnitude + (BiasDifference << FloatLayout::MantissaBits);
+    // infinities and NaNs need the rest of the float exponent range
+    auto nanOrInfinity = rebiased + ((FloatLayout::MaxExponent - Binary16Layout::MaxExponent - BiasDifference) << FloatLayout::MantissaBits);
+    // subnormals are renormalized by the FPU
+    auto subnormal = FloatLayout::toBits(FloatLayout::fromBits(rebiased + (1u << FloatLayout::MantissaBits)) - FloatLayout::fromBits(SubnormalMagic));
+    auto result = exponent == ShiftedExponent ? nanOrInfinity : (exponent == 0 ? subnormal : rebiased);
+    auto sign = static_cast<uint32_t>(Binary16Layout::SignPattern::decode(value)) << FloatLayout::SignPosition;
+    return FloatLayout::fromBits(result | sign);
+}
+
+/**
+ * Round to nearest even conversion from float to bfloat16, bfloat16 is the
+ * upper half of a float so only the rounding and NaN quieting are needed.
+ */
+constexpr uint16_t floatToBFloat16(float value) noexcept {
+    auto bits = FloatLayout::toBits(value);
+    auto upper = std::get<1>(getHalves<uint32_t>(bits));
+    auto isNaN = (bits & ~FloatLayout::SignPattern::Mask) > FloatLayout::ExponentPattern::Mask;
+    auto rounded = static_cast<uint16_t>((bits + 0x7FFF + (upper & 1)) >> HalfShiftAmount<uint32_t>);
+    return isNaN ? static_cast<uint16_t>(upper | 0x40) : rounded;
+}
+
+constexpr float bfloat16ToFloat(uint16_t value) noexcept {
+    return FloatLayout::fromBits(fromHalves<uint32_t>(0, static_cast<uint16_t>(value)));
+}
+
+static_assert(floatToHalf(1.0f) == 0x3C00);
+static_assert(floatToHalf(-2.0f) == 0xC000);
+static_assert(floatToHalf(65504.0f) == 0x7BFF);
+static_assert(floatToHalf(65520.0f) == 0x7C00);
+static_assert(floatToHalf(5.960464477539063e-8f) == 0x0001);
+static_assert(halfToFloat(0x3555) == 0.333251953125f);
+static_assert(halfToFloat(0x0001) == 5.960464477539063e-8f);
+static_assert(floatToBFloat16(1.0f) == 0x3F80);
+static_assert(bfloat16ToFloat(0xC000) == -2.0f);
+
+// Batch conversions, F16C is used for binary16 when available. Everything
+// else relies on the branch free integer routines above which the compiler
+// vectorizes with whatever SSE2/AVX2 support is enabled.
+
+inline std::size_t floatToHalf(std::span<const float> input, std::span<uint16_t> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    std::size_t i = 0;
+#ifdef __F16C__
+    for (auto blocks = count - (count % 8); i < blocks; i += 8) {
+        auto v = _mm256_loadu_ps(input.data() + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output.data() + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = floatToHalf(input[i]);
+    }
+    return count;
+}
+
+inline std::size_t halfToFloat(std::span<const uint16_t> input, std::span<float> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    std::size_t i = 0;
+#ifdef __F16C__
+    for (auto blocks = count - (count % 8); i < blocks; i += 8) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input.data() + i));
+        _mm256_storeu_ps(output.data() + i, _mm256_cvtph_ps(v));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = halfToFloat(input[i]);
+    }
+    return count;
+}
+
+inline std::size_t floatToBFloat16(std::span<const float> input, std::span<uint16_t> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = floatToBFloat16(input[i]);
+    }
+    return count;
+}
+
+inline std::size_t bfloat16ToFloat(std::span<const uint16_t> input, std::span<float> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = bfloat16ToFloat(input[i]);
+    }
+    return count;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_HalfPrecision_h__
@@ -0,0 +1,291 @@
+/**
+ * @file
+ * Morton (Z-order) interleaving of the halves of a binary quantity
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Interleave_h__
+#define BinaryManipulation_Interleave_h__
+#include "BinaryManipulation.h"
+#include <algorithm>
+#include <bit>
+#include <span>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+/**
+ * The number of bits each lane gets when a T is interleaved "ways" ways
+ */
+template<typename T, std::size_t ways>
+constexpr auto LaneBitCount = BitCount<T> / ways;
+
+/**
+ * Compute the mask of the positions occupied by the bits of lane zero once a
+ * lane has been broken into chunks of the given size and spread "ways" apart.
+ * A chunk of one gives the final Morton positions (0x5555... for two ways).
+ */
+template<typename T>
+constexpr T computeSpreadMask(std::size_t ways, std::size_t chunk) noexcept {
+    T result = 0;
+    for (std::size_t i = 0; i < BitCount<T> / ways; ++i) {
+        result |= static_cast<T>(static_cast<T>(1) << (((i / chunk) * ways * chunk) + (i % chunk)));
+    }
+    return result;
+}
+static_assert(computeSpreadMask<uint32_t>(2, 1) == 0x5555'5555);
+static_assert(computeSpreadMask<uint32_t>(2, 16) == 0x0000'FFFF);
+static_assert(computeSpreadMask<uint32_t>(3, 1) == 0x0924'9249);
+static_assert(computeSpreadMask<uint64_t>(3, 2) == 0x10C3'0C30'C30C'30C3);
+
+/**
+ * Move the low lane bits of the input apart so that they are "ways" bits
+ * from one another using the classic magic number shift ladder.
+ */
+template<typename T, std::size_t ways, std::size_t chunk = std::bit_ceil(LaneBitCount<T, ways>)>
+constexpr T spreadBits(T value) noexcept {
+    if constexpr (chunk == 0) {
+        return value;
+    } else if constexpr (chunk == std::bit_ceil(LaneBitCount<T, ways>)) {
+        // the first rung only strips off the bits which are not part of the lane
+        return spreadBits<T, ways, chunk / 2>(static_cast<T>(value & computeSpreadMask<T>(ways, chunk)));
+    } else {
+        constexpr auto mask = computeSpreadMask<T>(ways, chunk);
+        return spreadBits<T, ways, chunk / 2>(static_cast<T>((value | (value << ((ways - 1) * chunk))) & mask));
+    }
+}
+
+/**
+ * Inverse of spreadBits, gather every "ways"-th bit back into the low bits
+ */
+template<typename T, std::size_t ways, std::size_t chunk = 1>
+constexpr T compactBits(T value) noexcept {
+    if constexpr (chunk >= std::bit_ceil(LaneBitCount<T, ways>)) {
+        return value;
+    } else {
+        if constexpr (chunk == 1) {
+            value = static_cast<T>(value & computeSpreadMask<T>(ways, 1));
+        }
+        constexpr auto mask = computeSpreadMask<T>(ways, chunk * 2);
+        return compactBits<T, ways, chunk * 2>(static_cast<T>((value | (value >> ((ways - 1) * chunk))) & mask));
+    }
+}
+static_assert(spreadBits<uint16_t, 2>(0xFF) == 0x5555);
+static_assert(compactBits<uint16_t, 2>(0x5555) == 0xFF);
+static_assert(spreadBits<uint32_t, 3>(0x3FF) == 0x0924'9249);
+static_assert(compactBits<uint64_t, 3>(0x1249'2492'4924'9249) == 0x1F'FFFF);
+
+/**
+ * Place the given lane value into its interleaved position. Uses PDEP when
+ * the target has BMI2 and falls back to the shift ladder otherwise.
+ */
+template<typename T, std::size_t ways>
+constexpr T depositLane(T value, std::size_t lane) noexcept {
+    using U = std::make_unsigned_t<T>;
+#ifdef __BMI2__
+    if (!std::is_constant_evaluated()) {
+        constexpr auto mask = computeSpreadMask<U>(ways, 1);
+        if constexpr (sizeof(U) == sizeof(uint64_t)) {
+            return static_cast<T>(_pdep_u64(static_cast<U>(value), mask) << lane);
+        } else if constexpr (sizeof(U) == sizeof(uint32_t)) {
+            return static_cast<T>(_pdep_u32(static_cast<U>(value), mask) << lane);
+        }
+    }
+#endif
+    return static_cast<T>(static_cast<U>(spreadBits<U, ways>(static_cast<U>(value)) << lane));
+}
+
+/**
+ * Pull the given lane out of an interleaved value. Uses PEXT when the target
+ * has BMI2 and falls back to the shift ladder otherwise.
+ */
+template<typename T, std::size_t ways>
+constexpr T extractLane(T value, std::size_t lane) noexcept {
+    using U = std::make_unsigned_t<T>;
+#ifdef __BMI2__
+    if (!std::is_constant_evaluated()) {
+        constexpr auto mask = computeSpreadMask<U>(ways, 1);
+        if constexpr (sizeof(U) == sizeof(uint64_t)) {
+            return static_cast<T>(_pext_u64(static_cast<U>(value), mask << lane));
+        } else if constexpr (sizeof(U) == sizeof(uint32_t)) {
+            return static_cast<T>(_pext_u32(static_cast<U>(value), mask << lane));
+        }
+    }
+#endif
+    return static_cast<T>(compactBits<U, ways>(static_cast<U>(static_cast<U>(value) >> lane)));
+}
+
+/**
+ * Interleave the given halves so that the bits of the lower half land in the
+ * even bit positions and the bits of the upper half land in the odd ones.
+ */
+template<typename T>
+constexpr T interleaveHalves(HalfType_t<T> lower, HalfType_t<T> upper) noexcept {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(depositLane<U, 2>(static_cast<U>(lower), 0) | depositLane<U, 2>(static_cast<U>(upper), 1));
+}
+
+/**
+ * Interleave the lower and upper halves of the given value (Morton encode)
+ */
+template<typename T>
+constexpr T interleaveHalves(T input) noexcept {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(depositLane<U, 2>(static_cast<U>(input), 0) |
+                          depositLane<U, 2>(static_cast<U>(static_cast<U>(input) >> HalfShiftAmount<T>), 1));
+}
+
+/**
+ * Inverse of interleaveHalves, the even bits are gathered into the lower
+ * half and the odd bits into the upper half (Morton decode)
+ */
+template<typename T>
+constexpr T deinterleave(T input) noexcept {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(extractLane<U, 2>(static_cast<U>(input), 0) |
+                          static_cast<U>(extractLane<U, 2>(static_cast<U>(input), 1) << HalfShiftAmount<T>));
+}
+
+/**
+ * Deinterleave the given value and hand back the halves the same way
+ * getHalves does
+ */
+template<typename T>
+constexpr decltype(auto) deinterleaveHalves(T input) noexcept {
+    return getHalves<T>(deinterleave<T>(input));
+}
+
+static_assert(interleaveHalves<uint16_t>(0x00FF) == 0x5555);
+static_assert(interleaveHalves<uint32_t>(0xFFFF'0000) == 0xAAAA'AAAA);
+static_assert(interleaveHalves<uint32_t>(0x0003, 0x0001) == 0b0111);
+static_assert(interleaveHalves<uint8_t>(0xF0) == 0xAA);
+static_assert(deinterleave<uint64_t>(interleaveHalves<uint64_t>(0xFDED'ABCD'0123'4567)) == 0xFDED'ABCD'0123'4567);
+
+/**
+ * Three way interleave, each argument contributes LaneBitCount<T, 3> bits
+ * with the first argument landing in bit zero
+ */
+template<typename T>
+constexpr T interleave3(T a, T b, T c) noexcept {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(depositLane<U, 3>(static_cast<U>(a), 0) |
+                          depositLane<U, 3>(static_cast<U>(b), 1) |
+                          depositLane<U, 3>(static_cast<U>(c), 2));
+}
+
+/**
+ * Inverse of interleave3
+ */
+template<typename T>
+constexpr std::tuple<T, T, T> deinterleave3(T input) noexcept {
+    using U = std::make_unsigned_t<T>;
+    return std::make_tuple(static_cast<T>(extractLane<U, 3>(static_cast<U>(input), 0)),
+                           static_cast<T>(extractLane<U, 3>(static_cast<U>(input), 1)),
+                           static_cast<T>(extractLane<U, 3>(static_cast<U>(input), 2)));
+}
+static_assert(interleave3<uint32_t>(1, 2, 4) == 0x111);
+static_assert(interleave3<uint64_t>(0x1F'FFFF, 0, 0) == 0x1249'2492'4924'9249);
+static_assert(std::get<2>(deinterleave3<uint16_t>(interleave3<uint16_t>(0b10101, 0b00011, 0b11001))) == 0b11001);
+
+// Batch kernels. These always use the shift ladder instead of PDEP/PEXT since
+// the ladder is nothing but shifts, ands, and ors which the compiler turns
+// into wide SIMD operations while PDEP/PEXT are scalar only. The number of
+// elements actually processed (the shortest span) is returned.
+
+template<typename T>
+std::size_t interleaveHalves(std::span<const HalfType_t<T>> lower, std::span<const HalfType_t<T>> upper, std::type_identity_t<std::span<T>> output) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min({lower.size(), upper.size(), output.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = static_cast<T>(spreadBits<U, 2>(static_cast<U>(lower[i])) |
+                                   static_cast<U>(spreadBits<U, 2>(static_cast<U>(upper[i])) << 1));
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t interleaveHalves(std::span<const T> input, std::type_identity_t<std::span<T>> output) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min(input.size(), output.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        auto value = static_cast<U>(input[i]);
+        output[i] = static_cast<T>(spreadBits<U, 2>(value) |
+                                   static_cast<U>(spreadBits<U, 2>(static_cast<U>(value >> HalfShiftAmount<T>)) << 1));
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t deinterleave(std::span<const T> input, std::type_identity_t<std::span<T>> output) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min(input.size(), output.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        auto value = static_cast<U>(input[i]);
+        output[i] = static_cast<T>(compactBits<U, 2>(value) |
+                                   static_cast<U>(compactBits<U, 2>(static_cast<U>(value >> 1)) << HalfShiftAmount<T>));
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t deinterleave(std::span<const T> input, std::span<HalfType_t<T>> lower, std::span<HalfType_t<T>> upper) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min({input.size(), lower.size(), upper.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        auto value = static_cast<U>(input[i]);
+        lower[i] = static_cast<HalfType_t<T>>(compactBits<U, 2>(value));
+        upper[i] = static_cast<HalfType_t<T>>(compactBits<U, 2>(static_cast<U>(value >> 1)));
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t interleave3(std::span<const T> a, std::span<const T> b, std::span<const T> c, std::type_identity_t<std::span<T>> output) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min({a.size(), b.size(), c.size(), output.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = static_cast<T>(spreadBits<U, 3>(static_cast<U>(a[i])) |
+                                   static_cast<U>(spreadBits<U, 3>(static_cast<U>(b[i])) << 1) |
+                                   static_cast<U>(spreadBits<U, 3>(static_cast<U>(c[i])) << 2));
+    }
+    return count;
+}
+
+template<typename T>
+std::size_t deinterleave3(std::span<const T> input, std::type_identity_t<std::span<T>> a, std::type_identity_t<std::span<T>> b, std::type_identity_t<std::span<T>> c) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto count = std::min({input.size(), a.size(), b.size(), c.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        auto value = static_cast<U>(input[i]);
+        a[i] = static_cast<T>(compactBits<U, 3>(value));
+        b[i] = static_cast<T>(compactBits<U, 3>(static_cast<U>(value >> 1)));
+        c[i] = static_cast<T>(compactBits<U, 3>(static_cast<U>(value >> 2)));
+    }
+    return count;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_Interleave_h__
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * Read only memory mapped files (POSIX)
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_MappedFile_h__
+#define BinaryManipulation_MappedFile_h__
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace BinaryManipulation {
+
+/**
+ * A whole file mapped read only; check valid() after construction, errno
+ * describes the failure
+ */
+class MappedFile final {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const char* path) noexcept {
+            auto fd = ::open(path, O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+            struct stat info { };
+            if (::fstat(fd, &info) == 0) {
+                _size = static_cast<std::size_t>(info.st_size);
+                if (_size == 0) {
+                    _valid = true;
+                } else if (auto mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0); mapping != MAP_FAILED) {
+                    _data = static_cast<const uint8_t*>(mapping);
+                    _valid = true;
+                } else {
+                    _size = 0;
+                }
+            }
+            ::close(fd);
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept { swap(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            MappedFile temporary(std::move(other));
+            swap(temporary);
+            return *this;
+        }
+        ~MappedFile() {
+            if (_data) {
+                ::munmap(const_cast<uint8_t*>(_data), _size);
+            }
+        }
+        bool valid() const noexcept { return _valid; }
+        std::span<const uint8_t> bytes() const noexcept { return { _data, _size }; }
+        std::size_t size() const noexcept { return _size; }
+        /**
+         * Tell the kernel the mapping will be read front to back
+         */
+        void adviseSequential() const noexcept {
+            if (_data) {
+                ::madvise(const_cast<uint8_t*>(_data), _size, MADV_SEQUENTIAL);
+            }
+        }
+        void swap(MappedFile& other) noexcept {
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_valid, other._valid);
+        }
+    private:
+        const uint8_t* _data = nullptr;
+        std::size_t _size = 0;
+        bool _valid = false;
+};
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_MappedFile_h__
@@ -0,0 +1,328 @@
+/**
+ * @file
+ * A software MMU, multi level page walker and set associative TLB built from address field patterns
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Mmu_h__
+#define BinaryManipulation_Mmu_h__
+#include "BinaryManipulation.h"
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <utility>
+namespace BinaryManipulation {
+
+/**
+ * A virtual address split into page table indices above a page offset,
+ * levelBits lists the index widths starting from the root table
+ */
+template<typename A, std::size_t offsetBits, std::size_t ... levelBits>
+struct AddressLayout final {
+    static_assert(std::is_unsigned_v<A>);
+    static_assert(sizeof...(levelBits) > 0);
+    using AddressType = A;
+    static constexpr std::size_t OffsetBits = offsetBits;
+    static constexpr std::size_t Levels = sizeof...(levelBits);
+    static constexpr std::size_t PageNumberBits = (levelBits + ...);
+    static_assert((OffsetBits + PageNumberBits) <= (sizeof(A) * CHAR_BIT));
+    static constexpr std::array<std::size_t, Levels> IndexBits { levelBits... };
+    static constexpr std::size_t indexLowBit(std::size_t level) noexcept {
+        auto position = OffsetBits;
+        for (auto i = level + 1; i < Levels; ++i) {
+            position += IndexBits[i];
+        }
+        return position;
+    }
+    using Offset = FieldVector<A, A, 0, OffsetBits>;
+    using PageNumber = FieldVector<A, A, OffsetBits, PageNumberBits>;
+    template<std::size_t level>
+    using Index = FieldVector<A, A, indexLowBit(level), IndexBits[level]>;
+    static constexpr A PageSize = A { 1 } << OffsetBits;
+};
+
+/**
+ * Two level 4k paging over 32-bit addresses
+ */
+using TwoLevel32 = AddressLayout<uint32_t, 12, 10, 10>;
+static_assert(TwoLevel32::Index<0>::decode(0xFFC0'0000) == 0x3FF);
+static_assert(TwoLevel32::Index<1>::decode(0x003F'F000) == 0x3FF);
+/**
+ * Four level 4k paging over 48-bit addresses
+ */
+using FourLevel48 = AddressLayout<uint64_t, 12, 9, 9, 9, 9>;
+static_assert(FourLevel48::Index<0>::decode(0xFF80'0000'0000) == 0x1FF);
+
+/**
+ * A page table entry, the same layout is used at every level and the frame
+ * number is the physical address of the next table or page shifted down by
+ * the page offset width
+ */
+template<typename E, std::size_t frameBits, std::size_t frameLowBit = 12>
+struct PageTableEntry final {
+    using DataType = E;
+    using Present = Flag<E, 0>;
+    using Writable = Flag<E, 1>;
+    using User = Flag<E, 2>;
+    using Accessed = Flag<E, 5>;
+    using Dirty = Flag<E, 6>;
+    using Frame = FieldVector<E, E, frameLowBit, frameBits>;
+    using Layout = Description<E, Present, Writable, User, Accessed, Dirty, Frame>;
+};
+using PageTableEntry32 = PageTableEntry<uint32_t, 20>;
+using PageTableEntry64 = PageTableEntry<uint64_t, 40>;
+static_assert(PageTableEntry32::Layout::encode(true, true, false, false, false, 0x12345) == 0x1234'5003);
+
+/**
+ * Access kinds, combined as flags
+ */
+namespace AccessFlags {
+    constexpr uint8_t Read = 0b00;
+    constexpr uint8_t Write = 0b01;
+    constexpr uint8_t User = 0b10;
+} // end namespace AccessFlags
+
+enum class TranslationFault : uint8_t {
+    None,
+    NotPresent,
+    Protection,
+    // a page table lies outside of physical memory
+    BusError,
+};
+template<typename A>
+struct Translation {
+    A address;
+    TranslationFault fault;
+};
+/**
+ * hits and misses count TLB lookups; runHits counts addresses a batch
+ * translate served from the page of the address before it, without a lookup
+ */
+struct TlbStatistics {
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t runHits;
+};
+
+/**
+ * A set associative TLB indexed by the low bits of the page number and
+ * tagged with the rest. Each set keeps its tags together so a lookup
+ * compares every way at once, a full set evicts in round robin order.
+ */
+template<typename Layout, std::size_t sets, std::size_t ways>
+class Tlb final {
+    public:
+        static_assert(std::has_single_bit(sets));
+        using Address = typename Layout::AddressType;
+        static constexpr std::size_t SetBits = std::countr_zero(sets);
+        static_assert(SetBits < Layout::PageNumberBits);
+        using SetIndex = FieldVector<Address, std::size_t, Layout::OffsetBits, SetBits>;
+        using Tag = FieldVector<Address, Address, Layout::OffsetBits + SetBits, Layout::PageNumberBits - SetBits>;
+        // never a valid tag since tags are narrower than an address
+        static constexpr Address InvalidTag = ~Address { 0 };
+        struct Entry {
+            Address frame;
+            bool writable;
+            bool user;
+            bool dirty;
+        };
+    public:
+        constexpr Tlb() noexcept { flush(); }
+        constexpr const Entry* lookup(Address address) const noexcept {
+            auto& set = _sets[SetIndex::decode(address)];
+            auto tag = Tag::decode(address);
+            std::size_t way = ways;
+            for (std::size_t i = 0; i < ways; ++i) {
+                way = (set.tags[i] == tag) ? i : way;
+            }
+            return way == ways ? nullptr : &set.entries[way];
+        }
+        constexpr void insert(Address address, const Entry& entry) noexcept {
+            auto& set = _sets[SetIndex::decode(address)];
+            auto tag = Tag::decode(address);
+            // refill an entry already holding the page before evicting another
+            std::size_t way = set.victim;
+            for (std::size_t i = 0; i < ways; ++i) {
+                way = (set.tags[i] == tag) ? i : way;
+            }
+            set.victim = (way == set.victim) ? (set.victim + 1) % ways : set.victim;
+            set.tags[way] = tag;
+            set.entries[way] = entry;
+        }
+        constexpr void invalidate(Address address) noexcept {
+            auto& set = _sets[SetIndex::decode(address)];
+            auto tag = Tag::decode(address);
+            for (auto& candidate : set.tags) {
+                candidate = (candidate == tag) ? InvalidTag : candidate;
+            }
+        }
+        constexpr void flush() noexcept {
+            for (auto& set : _sets) {
+                set.tags.fill(InvalidTag);
+                set.victim = 0;
+            }
+        }
+    private:
+        struct Set {
+            std::array<Address, ways> tags;
+            std::array<Entry, ways> entries;
+            std::size_t victim;
+        };
+        std::array<Set, sets> _sets { };
+};
+
+/**
+ * Translates virtual addresses through page tables held in a span of
+ * physical memory. The walk descends one Index field per level, checks
+ * that the write and user permissions hold at every level, and sets the
+ * accessed bits on the way down and the dirty bit on the leaf, like the
+ * hardware it models. Page tables are stored little endian.
+ */
+template<typename Layout, typename Entry, std::size_t tlbSets = 64, std::size_t tlbWays = 4>
+class Mmu final {
+    public:
+        using Address = typename Layout::AddressType;
+        using EntryType = typename Entry::DataType;
+        using Cache = Tlb<Layout, tlbSets, tlbWays>;
+    public:
+        explicit Mmu(std::span<uint8_t> physical, Address root = 0) noexcept : _physical(physical), _root(root) { }
+        /**
+         * Switch to another root table, which drops every cached translation
+         */
+        void setRoot(Address root) noexcept {
+            _root = root;
+            _tlb.flush();
+        }
+        constexpr Address root() const noexcept { return _root; }
+        /**
+         * Must be called after changing the entries that map address
+         */
+        void invalidate(Address address) noexcept { _tlb.invalidate(address); }
+        void flush() noexcept { _tlb.flush(); }
+        constexpr TlbStatistics statistics() const noexcept { return _statistics; }
+        Translation<Address> translate(Address address, uint8_t access) noexcept {
+            auto cached = _tlb.lookup(address);
+            // the first write through a clean page has to walk to set its dirty bit
+            if (cached && permitted(*cached, access) && (cached->dirty || !(access & AccessFlags::Write))) {
+                ++_statistics.hits;
+                return { cached->frame | Layout::Offset::decode(address), TranslationFault::None };
+            }
+            ++_statistics.misses;
+            return walk(address, access);
+        }
+        /**
+         * Translate a trace of addresses until the first fault, returns the
+         * number translated. Runs of addresses in the same page skip the TLB.
+         */
+        std::size_t translate(std::span<const Address> addresses, std::span<Address> physical, uint8_t access, TranslationFault& fault) noexcept;
+    private:
+        static constexpr bool permitted(const typename Cache::Entry& entry, uint8_t access) noexcept {
+            return (entry.writable || !(access & AccessFlags::Write)) && (entry.user || !(access & AccessFlags::User));
+        }
+        EntryType loadEntry(Address address) const noexcept { return loadFromBytes<EntryType>(_physical.data() + address); }
+        void storeEntry(Address address, EntryType value) noexcept {
+            auto bytes = std::endian::native == std::endian::little ? value : reverseBytes(value);
+            std::memcpy(_physical.data() + address, &bytes, sizeof(bytes));
+        }
+        Translation<Address> walk(Address address, uint8_t access) noexcept;
+    private:
+        std::span<uint8_t> _physical;
+        Address _root;
+        Cache _tlb;
+        TlbStatistics _statistics { };
+};
+
+template<typename Layout, typename Entry, std::size_t tlbSets, std::size_t tlbWays>
+Translation<typename Layout::AddressType> Mmu<Layout, Entry, tlbSets, tlbWays>::walk(Address address, uint8_t access) noexcept {
+    typename Cache::Entry result { _root, true, true, false };
+    auto fault = TranslationFault::None;
+    auto step = [&]<std::size_t level>() {
+        auto entryAddress = static_cast<Address>(result.frame + Layout::template Index<level>::decode(address) * sizeof(EntryType));
+        if (entryAddress > _physical.size() - sizeof(EntryType)) {
+            fault = TranslationFault::BusError;
+            return false;
+        }
+        auto entry = loadEntry(entryAddress);
+        if (!Entry::Present::decode(entry)) {
+            fault = TranslationFault::NotPresent;
+            return false;
+        }
+        result.writable &= Entry::Writable::decode(entry);
+        result.user &= Entry::User::decode(entry);
+        if (!permitted(result, access)) {
+            fault = TranslationFault::Protection;
+            return false;
+        }
+        auto updated = Entry::Accessed::encode(entry, true);
+        if constexpr (level == (Layout::Levels - 1)) {
+            updated = Entry::Dirty::encode(updated, Entry::Dirty::decode(entry) || (access & AccessFlags::Write));
+            result.dirty = Entry::Dirty::decode(updated);
+        }
+        if (updated != entry) {
+            storeEntry(entryAddress, updated);
+        }
+        result.frame = static_cast<Address>(Entry::Frame::decode(entry) << Layout::OffsetBits);
+        return true;
+    };
+    auto completed = [&]<std::size_t ... level>(std::index_sequence<level...>) {
+        return (step.template operator()<level>() && ...);
+    }(std::make_index_sequence<Layout::Levels> { });
+    if (!completed) {
+        return { 0, fault };
+    }
+    _tlb.insert(address, result);
+    return { result.frame | Layout::Offset::decode(address), TranslationFault::None };
+}
+
+template<typename Layout, typename Entry, std::size_t tlbSets, std::size_t tlbWays>
+std::size_t Mmu<Layout, Entry, tlbSets, tlbWays>::translate(std::span<const Address> addresses, std::span<Address> physical, uint8_t access, TranslationFault& fault) noexcept {
+    auto count = std::min(addresses.size(), physical.size());
+    // the page translated last, the frame is only valid while page is not InvalidPage
+    constexpr auto InvalidPage = ~Address { 0 };
+    Address page = InvalidPage;
+    Address frame = 0;
+    fault = TranslationFault::None;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto address = addresses[i];
+        if (Layout::PageNumber::decode(address) == page) {
+            ++_statistics.runHits;
+            physical[i] = frame | Layout::Offset::decode(address);
+            continue;
+        }
+        auto translated = translate(address, access);
+        if (translated.fault != TranslationFault::None) {
+            fault = translated.fault;
+            return i;
+        }
+        physical[i] = translated.address;
+        page = Layout::PageNumber::decode(address);
+        frame = translated.address & ~(Layout::PageSize - 1);
+    }
+    return count;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_Mmu_h__
@@ -0,0 +1,225 @@
+/**
+ * @file
+ * Layouts of the Ethernet, IPv4, TCP, and UDP headers
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_NetworkHeaders_h__
+#define BinaryManipulation_NetworkHeaders_h__
+#include "BinaryManipulation.h"
+namespace BinaryManipulation::Network {
+
+// Headers are described one 32-bit row at a time exactly as they are drawn
+// in the RFCs (bit 31 is the first bit on the wire). The endian policy is
+// applied when a row is loaded, it is always read in network byte order, so
+// sub byte fields such as the IHL nibble or the fragment offset stay
+// contiguous patterns.
+using Row = uint32_t;
+inline Row loadRow(std::span<const uint8_t> header, std::size_t index) noexcept {
+    return loadFromBytes<Row>(header.data() + (index * sizeof(Row)), std::endian::big);
+}
+
+/**
+ * A pattern (or a whole Description) applied to the given row of a header
+ */
+template<std::size_t row, typename P>
+struct HeaderField final {
+    using Layout = P;
+    static constexpr auto RowIndex = row;
+    static auto decode(std::span<const uint8_t> header) noexcept {
+        return P::decode(loadRow(header, row));
+    }
+};
+template<typename R, Row position, Row length>
+using RowBits = FieldVector<Row, R, position, length>;
+template<Row position>
+using RowFlag = Flag<Row, position>;
+
+namespace Ethernet {
+constexpr std::size_t HeaderLength = 14;
+constexpr std::size_t VlanTagLength = 4;
+constexpr uint16_t EtherTypeIPv4 = 0x0800;
+constexpr uint16_t EtherTypeVlan = 0x8100;
+/**
+ * The payload of an Ethernet II frame (skipping a single 802.1Q tag), empty if truncated
+ */
+inline std::span<const uint8_t> payload(std::span<const uint8_t> frame, uint16_t& etherType) noexcept {
+    if (frame.size() < HeaderLength) {
+        return { };
+    }
+    auto offset = HeaderLength;
+    etherType = loadFromBytes<uint16_t>(frame.data() + 12, std::endian::big);
+    if (etherType == EtherTypeVlan) {
+        if (frame.size() < (HeaderLength + VlanTagLength)) {
+            return { };
+        }
+        etherType = loadFromBytes<uint16_t>(frame.data() + 16, std::endian::big);
+        offset += VlanTagLength;
+    }
+    return frame.subspan(offset);
+}
+} // end namespace Ethernet
+
+namespace IPv4 {
+constexpr std::size_t MinimumHeaderLength = 20;
+constexpr uint8_t ProtocolICMP = 1;
+constexpr uint8_t ProtocolTCP = 6;
+constexpr uint8_t ProtocolUDP = 17;
+using VersionBits = RowBits<uint8_t, 28, 4>;
+using HeaderLengthBits = RowBits<uint8_t, 24, 4>;
+using DSCPBits = RowBits<uint8_t, 18, 6>;
+using ECNBits = RowBits<uint8_t, 16, 2>;
+using TotalLengthBits = RowBits<uint16_t, 0, 16>;
+using IdentificationBits = RowBits<uint16_t, 16, 16>;
+using ReservedFlag = RowFlag<15>;
+using DontFragmentFlag = RowFlag<14>;
+using MoreFragmentsFlag = RowFlag<13>;
+using FragmentOffsetBits = RowBits<uint16_t, 0, 13>;
+using TimeToLiveBits = RowBits<uint8_t, 24, 8>;
+using ProtocolBits = RowBits<uint8_t, 16, 8>;
+using ChecksumBits = RowBits<uint16_t, 0, 16>;
+using AddressBits = RowBits<uint32_t, 0, 32>;
+
+using Version = HeaderField<0, VersionBits>;
+/// in 32-bit words
+using HeaderLength = HeaderField<0, HeaderLengthBits>;
+using DSCP = HeaderField<0, DSCPBits>;
+using ECN = HeaderField<0, ECNBits>;
+using TotalLength = HeaderField<0, TotalLengthBits>;
+using Identification = HeaderField<1, IdentificationBits>;
+using DontFragment = HeaderField<1, DontFragmentFlag>;
+using MoreFragments = HeaderField<1, MoreFragmentsFlag>;
+/// in 8 byte units
+using FragmentOffset = HeaderField<1, FragmentOffsetBits>;
+using TimeToLive = HeaderField<2, TimeToLiveBits>;
+using Protocol = HeaderField<2, ProtocolBits>;
+using Checksum = HeaderField<2, ChecksumBits>;
+using SourceAddress = HeaderField<3, AddressBits>;
+using DestinationAddress = HeaderField<4, AddressBits>;
+// whole rows when several fields are needed at once
+using ServiceRow = HeaderField<0, Description<Row, VersionBits, HeaderLengthBits, DSCPBits, ECNBits, TotalLengthBits>>;
+using FragmentRow = HeaderField<1, Description<Row, IdentificationBits, ReservedFlag, DontFragmentFlag, MoreFragmentsFlag, FragmentOffsetBits>>;
+using RoutingRow = HeaderField<2, Description<Row, TimeToLiveBits, ProtocolBits, ChecksumBits>>;
+} // end namespace IPv4
+
+namespace TCP {
+constexpr std::size_t MinimumHeaderLength = 20;
+using PortBits = RowBits<uint16_t, 16, 16>;
+using LowPortBits = RowBits<uint16_t, 0, 16>;
+using SequenceBits = RowBits<uint32_t, 0, 32>;
+using DataOffsetBits = RowBits<uint8_t, 28, 4>;
+using FlagBits = RowBits<uint8_t, 16, 8>;
+using CWRFlag = RowFlag<23>;
+using ECEFlag = RowFlag<22>;
+using URGFlag = RowFlag<21>;
+using ACKFlag = RowFlag<20>;
+using PSHFlag = RowFlag<19>;
+using RSTFlag = RowFlag<18>;
+using SYNFlag = RowFlag<17>;
+using FINFlag = RowFlag<16>;
+using WindowBits = RowBits<uint16_t, 0, 16>;
+
+using SourcePort = HeaderField<0, PortBits>;
+using DestinationPort = HeaderField<0, LowPortBits>;
+using SequenceNumber = HeaderField<1, SequenceBits>;
+using AcknowledgementNumber = HeaderField<2, SequenceBits>;
+/// in 32-bit words
+using DataOffset = HeaderField<3, DataOffsetBits>;
+using Flags = HeaderField<3, FlagBits>;
+using SYN = HeaderField<3, SYNFlag>;
+using ACK = HeaderField<3, ACKFlag>;
+using FIN = HeaderField<3, FINFlag>;
+using RST = HeaderField<3, RSTFlag>;
+using Window = HeaderField<3, WindowBits>;
+using Checksum = HeaderField<4, PortBits>;
+using UrgentPointer = HeaderField<4, LowPortBits>;
+using ControlRow = HeaderField<3, Description<Row, DataOffsetBits, CWRFlag, ECEFlag, URGFlag, ACKFlag, PSHFlag, RSTFlag, SYNFlag, FINFlag, WindowBits>>;
+} // end namespace TCP
+
+namespace UDP {
+constexpr std::size_t HeaderLength = 8;
+using SourcePort = HeaderField<0, TCP::PortBits>;
+using DestinationPort = HeaderField<0, TCP::LowPortBits>;
+using Length = HeaderField<1, TCP::PortBits>;
+using Checksum = HeaderField<1, TCP::LowPortBits>;
+} // end namespace UDP
+
+/**
+ * The layers of a packet, all views into the original buffer. Fields that do
+ * not apply (or could not be parsed) are empty spans.
+ */
+struct DecodedPacket {
+    std::span<const uint8_t> ip;
+    std::span<const uint8_t> transport;
+    std::span<const uint8_t> payload;
+    uint8_t protocol = 0;
+};
+
+/**
+ * Locate the IPv4 header and the TCP or UDP header that follows it, header
+ * lengths and the IPv4 total length are validated against the buffer
+ */
+inline DecodedPacket decodeIPv4(std::span<const uint8_t> datagram) noexcept {
+    DecodedPacket result;
+    if (datagram.size() < IPv4::MinimumHeaderLength) {
+        return result;
+    }
+    auto [version, headerLength, dscp, ecn, totalLength] = IPv4::ServiceRow::decode(datagram);
+    auto headerBytes = static_cast<std::size_t>(headerLength) * sizeof(Row);
+    if (version != 4 || headerBytes < IPv4::MinimumHeaderLength || totalLength < headerBytes || datagram.size() < headerBytes) {
+        return result;
+    }
+    // captures may be truncated (snap length) or padded (minimum frame size)
+    datagram = datagram.first(std::min<std::size_t>(datagram.size(), totalLength));
+    result.ip = datagram.first(headerBytes);
+    result.protocol = IPv4::Protocol::decode(datagram);
+    // only the first fragment carries the transport header
+    if (IPv4::FragmentOffset::decode(datagram) != 0) {
+        result.payload = datagram.subspan(headerBytes);
+        return result;
+    }
+    auto rest = datagram.subspan(headerBytes);
+    if (result.protocol == IPv4::ProtocolTCP && rest.size() >= TCP::MinimumHeaderLength) {
+        auto transportBytes = static_cast<std::size_t>(TCP::DataOffset::decode(rest)) * sizeof(Row);
+        if (transportBytes >= TCP::MinimumHeaderLength && transportBytes <= rest.size()) {
+            result.transport = rest.first(transportBytes);
+            result.payload = rest.subspan(transportBytes);
+        }
+    } else if (result.protocol == IPv4::ProtocolUDP && rest.size() >= UDP::HeaderLength) {
+        result.transport = rest.first(UDP::HeaderLength);
+        result.payload = rest.subspan(UDP::HeaderLength);
+    } else {
+        result.payload = rest;
+    }
+    return result;
+}
+inline DecodedPacket decodeEthernet(std::span<const uint8_t> frame) noexcept {
+    uint16_t etherType = 0;
+    auto payload = Ethernet::payload(frame, etherType);
+    return etherType == Ethernet::EtherTypeIPv4 ? decodeIPv4(payload) : DecodedPacket { };
+}
+
+} // end namespace BinaryManipulation::Network
+#endif // BinaryManipulation_NetworkHeaders_h__
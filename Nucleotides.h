@@ -0,0 +1,285 @@
+/**
+ * @file
+ * Two bit packed nucleotide sequences built on the quarter patterns of a byte
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Nucleotides_h__
+#define BinaryManipulation_Nucleotides_h__
+#include "BinaryManipulation.h"
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef __SSSE3__
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+// Bases are stored four to a byte in the LittleEndianQuarters<uint8_t> lanes,
+// base i of a sequence lives in quarter i % 4 of byte i / 4. The codes come
+// straight out of the ASCII letters ((c >> 1) & 0b11) which gives
+// A = 0, C = 1, T = 2, G = 3 for both upper and lower case. Complements are
+// therefore code ^ 0b10 and G/C are exactly the codes with the low bit set.
+
+enum class Nucleotide : uint8_t {
+    A = 0b00,
+    C = 0b01,
+    T = 0b10,
+    G = 0b11,
+};
+
+constexpr uint8_t ComplementMask = 0b10;
+constexpr uint8_t ComplementAllLanes = 0b1010'1010;
+constexpr uint8_t LowBitOfAllLanes = 0b0101'0101;
+constexpr std::string_view NucleotideLetters = "ACTG";
+
+constexpr Nucleotide asciiToNucleotide(char c) noexcept {
+    return static_cast<Nucleotide>((static_cast<uint8_t>(c) >> 1) & LowestQuarterMask<uint8_t>);
+}
+constexpr char nucleotideToAscii(Nucleotide n) noexcept {
+    return NucleotideLetters[static_cast<uint8_t>(n)];
+}
+constexpr bool isNucleotideLetter(char c) noexcept {
+    switch (c) {
+        case 'A': case 'C': case 'G': case 'T':
+        case 'a': case 'c': case 'g': case 't':
+            return true;
+        default:
+            return false;
+    }
+}
+static_assert(asciiToNucleotide('G') == Nucleotide::G && asciiToNucleotide('t') == Nucleotide::T);
+static_assert(nucleotideToAscii(asciiToNucleotide('c')) == 'C');
+static_assert(static_cast<uint8_t>(Nucleotide::A) == (static_cast<uint8_t>(Nucleotide::T) ^ ComplementMask));
+
+constexpr std::size_t packedNucleotideBytes(std::size_t count) noexcept {
+    return (count + 3) / 4;
+}
+
+constexpr Nucleotide getNucleotide(std::span<const uint8_t> packed, std::size_t index) noexcept {
+    return static_cast<Nucleotide>((packed[index / 4] >> ((index % 4) * QuarterShiftAmount<uint8_t>)) & LowestQuarterMask<uint8_t>);
+}
+
+/**
+ * Check that every character is one of ACGTacgt
+ */
+inline bool isValidNucleotideText(std::string_view text) noexcept {
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    const auto lowerCase = _mm_set1_epi8(0x20);
+    for (; (i + 16) <= text.size(); i += 16) {
+        auto v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i)), lowerCase);
+        auto ok = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('a')), _mm_cmpeq_epi8(v, _mm_set1_epi8('c'))),
+                               _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('g')), _mm_cmpeq_epi8(v, _mm_set1_epi8('t'))));
+        if (_mm_movemask_epi8(ok) != 0xFFFF) {
+            return false;
+        }
+    }
+#endif
+    for (; i < text.size(); ++i) {
+        if (!isNucleotideLetter(text[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Pack ASCII nucleotides into two bit lanes. The text is assumed to be valid
+ * (see isValidNucleotideText), returns the number of bases packed.
+ */
+inline std::size_t packNucleotides(std::string_view text, std::span<uint8_t> packed) noexcept {
+    auto count = std::min(text.size(), packed.size() * 4);
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    // codes -> (c0 + 4c1) in 16-bit lanes -> (c0 + 4c1 + 16c2 + 64c3) in 32-bit lanes -> bytes
+    const auto codeMask = _mm_set1_epi8(0b11);
+    const auto pairWeights = _mm_set1_epi16(0x0401);
+    const auto quadWeights = _mm_set1_epi32(0x0010'0001);
+    const auto gather = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (; (i + 16) <= count; i += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        auto codes = _mm_and_si128(_mm_srli_epi16(v, 1), codeMask);
+        auto quads = _mm_madd_epi16(_mm_maddubs_epi16(codes, pairWeights), quadWeights);
+        auto bytes = _mm_cvtsi128_si32(_mm_shuffle_epi8(quads, gather));
+        std::memcpy(packed.data() + (i / 4), &bytes, sizeof(bytes));
+    }
+#endif
+    for (; i < count; i += 4) {
+        uint8_t lanes[4] { };
+        for (std::size_t j = 0; j < 4 && (i + j) < count; ++j) {
+            lanes[j] = static_cast<uint8_t>(asciiToNucleotide(text[i + j]));
+        }
+        packed[i / 4] = fromQuarters<uint8_t>(std::move(lanes[0]), std::move(lanes[1]), std::move(lanes[2]), std::move(lanes[3]));
+    }
+    return count;
+}
+
+/**
+ * Expand count packed bases back into upper case ASCII
+ */
+inline std::size_t unpackNucleotides(std::span<const uint8_t> packed, std::size_t count, std::span<char> text) noexcept {
+    count = std::min({count, packed.size() * 4, text.size()});
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    // broadcast every byte to four positions, keep the two bits of the lane each
+    // position is responsible for, and map those (possibly shifted) bits to letters
+    const auto broadcast = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+    const auto laneMask = _mm_setr_epi8(0x03, 0x0C, 0x03, 0x0C, 0x03, 0x0C, 0x03, 0x0C, 0x03, 0x0C, 0x03, 0x0C, 0x03, 0x0C, 0x03, 0x0C);
+    const auto upperLanes = _mm_setr_epi8(0, 0, -1, -1, 0, 0, -1, -1, 0, 0, -1, -1, 0, 0, -1, -1);
+    const auto letters = _mm_setr_epi8('A', 'C', 'T', 'G', 'C', 0, 0, 0, 'T', 0, 0, 0, 'G', 0, 0, 0);
+    const auto lowNibble = _mm_set1_epi8(0x0F);
+    for (; (i + 16) <= count; i += 16) {
+        uint32_t bytes = 0;
+        std::memcpy(&bytes, packed.data() + (i / 4), sizeof(bytes));
+        auto v = _mm_shuffle_epi8(_mm_cvtsi32_si128(static_cast<int>(bytes)), broadcast);
+        auto low = _mm_and_si128(v, lowNibble);
+        auto high = _mm_and_si128(_mm_srli_epi16(v, 4), lowNibble);
+        auto selected = _mm_or_si128(_mm_andnot_si128(upperLanes, low), _mm_and_si128(upperLanes, high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(text.data() + i), _mm_shuffle_epi8(letters, _mm_and_si128(selected, laneMask)));
+    }
+#endif
+    for (; i < count; ++i) {
+        text[i] = nucleotideToAscii(getNucleotide(packed, i));
+    }
+    return count;
+}
+
+/**
+ * Reverse complement count packed bases: complement every lane with an xor,
+ * reverse the lanes within each byte, reverse the bytes, and finally shift
+ * out the empty lanes of a partial last byte.
+ */
+inline std::size_t reverseComplement(std::span<const uint8_t> packed, std::size_t count, std::span<uint8_t> output) noexcept {
+    count = std::min({count, packed.size() * 4, output.size() * 4});
+    auto bytes = packedNucleotideBytes(count);
+    auto reverseLanes = [](uint8_t value) noexcept {
+        value = static_cast<uint8_t>((value >> 4) | (value << 4));
+        return static_cast<uint8_t>(((value >> 2) & 0x33) | ((value & 0x33) << 2));
+    };
+    for (std::size_t i = 0; i < bytes; ++i) {
+        output[bytes - 1 - i] = reverseLanes(static_cast<uint8_t>(packed[i] ^ ComplementAllLanes));
+    }
+    if (auto emptyLanes = (bytes * 4) - count; emptyLanes != 0) {
+        auto shift = emptyLanes * QuarterShiftAmount<uint8_t>;
+        for (std::size_t i = 0; i < bytes; ++i) {
+            auto next = (i + 1) < bytes ? output[i + 1] : 0;
+            output[i] = static_cast<uint8_t>((output[i] >> shift) | (next << (8 - shift)));
+        }
+    }
+    return count;
+}
+
+/**
+ * Number of G or C bases in the first count bases, a population count of the
+ * low bit of every lane
+ */
+inline std::size_t gcCount(std::span<const uint8_t> packed, std::size_t count) noexcept {
+    count = std::min(count, packed.size() * 4);
+    auto fullBytes = count / 4;
+    std::size_t total = 0;
+    std::size_t i = 0;
+    for (; (i + sizeof(uint64_t)) <= fullBytes; i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, packed.data() + i, sizeof(word));
+        total += std::popcount(word & 0x5555'5555'5555'5555ull);
+    }
+    for (; i < fullBytes; ++i) {
+        total += std::popcount(static_cast<uint8_t>(packed[i] & LowBitOfAllLanes));
+    }
+    if (auto remaining = count % 4; remaining != 0) {
+        total += std::popcount(static_cast<uint8_t>(packed[fullBytes] & LowBitOfAllLanes & computeMaskFromLength<uint8_t>(remaining * 2)));
+    }
+    return total;
+}
+
+/**
+ * A k-mer is 2k bits with the first base in the most significant lane
+ */
+template<std::size_t k>
+using KmerPattern = FieldVector<uint64_t, uint64_t, 0, k * 2>;
+static_assert(KmerPattern<32>::Mask == 0xFFFF'FFFF'FFFF'FFFF);
+
+/**
+ * Call fn(position, kmer) for every k-mer in the first count bases, the
+ * k-mer is rolled along one base at a time
+ */
+template<std::size_t k, typename Fn>
+void forEachKmer(std::span<const uint8_t> packed, std::size_t count, Fn fn) noexcept(noexcept(fn(std::size_t(0), uint64_t(0)))) {
+    static_assert(k > 0 && k <= 32, "k-mers must fit into a uint64_t!");
+    count = std::min(count, packed.size() * 4);
+    uint64_t kmer = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        kmer = KmerPattern<k>::decode((kmer << 2) | static_cast<uint64_t>(getNucleotide(packed, i)));
+        if ((i + 1) >= k) {
+            fn(i + 1 - k, kmer);
+        }
+    }
+}
+
+/**
+ * Owning two bit packed sequence
+ */
+class NucleotideSequence final {
+    public:
+        NucleotideSequence() = default;
+        /**
+         * Returns false (leaving the sequence empty) if the text contains anything other than ACGTacgt
+         */
+        bool assign(std::string_view text) {
+            _length = 0;
+            _storage.clear();
+            if (!isValidNucleotideText(text)) {
+                return false;
+            }
+            _storage.resize(packedNucleotideBytes(text.size()));
+            _length = packNucleotides(text, _storage);
+            return true;
+        }
+        std::size_t size() const noexcept { return _length; }
+        std::span<const uint8_t> packed() const noexcept { return _storage; }
+        Nucleotide operator[](std::size_t index) const noexcept { return getNucleotide(_storage, index); }
+        std::string toString() const {
+            std::string result(_length, 'A');
+            unpackNucleotides(_storage, _length, result);
+            return result;
+        }
+        NucleotideSequence reverseComplement() const {
+            NucleotideSequence result;
+            result._storage.resize(_storage.size());
+            result._length = BinaryManipulation::reverseComplement(_storage, _length, result._storage);
+            return result;
+        }
+        std::size_t gcCount() const noexcept { return BinaryManipulation::gcCount(_storage, _length); }
+        template<std::size_t k, typename Fn>
+        void forEachKmer(Fn fn) const { BinaryManipulation::forEachKmer<k>(_storage, _length, fn); }
+    private:
+        std::vector<uint8_t> _storage;
+        std::size_t _length = 0;
+};
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_Nucleotides_h__
@@ -0,0 +1,243 @@
+/**
+ * @file
+ * Non power of two (24 and 48-bit) packed unsigned storage types
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_PackedIntegers_h__
+#define BinaryManipulation_PackedIntegers_h__
+#include "BinaryManipulation.h"
+#include <limits>
+#ifdef __SSSE3__
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+/**
+ * An unsigned quantity stored as exactly Bytes little endian bytes with no
+ * alignment requirements. Arithmetic is done in WideType and truncated on the
+ * way back so that Pattern, Description, and HalfOf work on it like any other
+ * unsigned type.
+ */
+template<std::size_t Bytes>
+class PackedUnsigned final {
+    public:
+        static_assert(Bytes > 0 && Bytes <= sizeof(uint64_t), "Packed quantities must fit into a uint64_t!");
+        using WideType = std::conditional_t<(Bytes <= sizeof(uint32_t)), uint32_t, uint64_t>;
+        static constexpr WideType ValueMask = (Bytes == sizeof(WideType)) ? ~static_cast<WideType>(0) :
+                                              ((static_cast<WideType>(1) << (Bytes * CHAR_BIT)) - 1);
+    public:
+        constexpr PackedUnsigned() noexcept : storage { } { }
+        template<typename I>
+        requires std::is_integral_v<I>
+        constexpr PackedUnsigned(I value) noexcept : storage { } {
+            auto wide = static_cast<WideType>(value);
+            for (std::size_t i = 0; i < Bytes; ++i) {
+                storage[i] = static_cast<uint8_t>(wide >> (i * CHAR_BIT));
+            }
+        }
+        constexpr WideType value() const noexcept {
+            WideType result = 0;
+            for (std::size_t i = 0; i < Bytes; ++i) {
+                result |= static_cast<WideType>(storage[i]) << (i * CHAR_BIT);
+            }
+            return result;
+        }
+        template<typename I>
+        requires std::is_integral_v<I>
+        explicit constexpr operator I() const noexcept { return static_cast<I>(value()); }
+
+        friend constexpr PackedUnsigned operator&(PackedUnsigned a, PackedUnsigned b) noexcept { return a.value() & b.value(); }
+        friend constexpr PackedUnsigned operator|(PackedUnsigned a, PackedUnsigned b) noexcept { return a.value() | b.value(); }
+        friend constexpr PackedUnsigned operator^(PackedUnsigned a, PackedUnsigned b) noexcept { return a.value() ^ b.value(); }
+        friend constexpr PackedUnsigned operator+(PackedUnsigned a, PackedUnsigned b) noexcept { return a.value() + b.value(); }
+        friend constexpr PackedUnsigned operator-(PackedUnsigned a, PackedUnsigned b) noexcept { return a.value() - b.value(); }
+        friend constexpr PackedUnsigned operator<<(PackedUnsigned a, std::size_t amount) noexcept { return a.value() << amount; }
+        friend constexpr PackedUnsigned operator>>(PackedUnsigned a, std::size_t amount) noexcept { return a.value() >> amount; }
+        friend constexpr PackedUnsigned operator<<(PackedUnsigned a, PackedUnsigned amount) noexcept { return a.value() << amount.value(); }
+        friend constexpr PackedUnsigned operator>>(PackedUnsigned a, PackedUnsigned amount) noexcept { return a.value() >> amount.value(); }
+        friend constexpr bool operator==(PackedUnsigned a, PackedUnsigned b) noexcept { return a.storage == b.storage; }
+        constexpr PackedUnsigned operator~() const noexcept { return ~value(); }
+        constexpr PackedUnsigned& operator&=(PackedUnsigned other) noexcept { return *this = *this & other; }
+        constexpr PackedUnsigned& operator|=(PackedUnsigned other) noexcept { return *this = *this | other; }
+        constexpr PackedUnsigned& operator^=(PackedUnsigned other) noexcept { return *this = *this ^ other; }
+    public:
+        // public so that packed values can be used as template parameters (masks and shifts)
+        std::array<uint8_t, Bytes> storage;
+};
+
+using uint24_t = PackedUnsigned<3>;
+using uint48_t = PackedUnsigned<6>;
+static_assert(sizeof(uint24_t) == 3 && alignof(uint24_t) == 1);
+static_assert(sizeof(uint48_t) == 6 && alignof(uint48_t) == 1);
+static_assert(BitCount<uint24_t> == 24);
+static_assert(BitCount<uint48_t> == 48);
+
+template<std::size_t Bytes>
+constexpr int countSetBits(PackedUnsigned<Bytes> value) noexcept {
+    return std::popcount(value.value());
+}
+
+template<>
+class HalfOf<uint24_t> final {
+    public:
+        using FullType = uint24_t;
+        using HalfType = uint16_t;
+    public:
+        HalfOf() = delete;
+        ~HalfOf() = delete;
+        HalfOf(const HalfOf&) = delete;
+        HalfOf(HalfOf&&) = delete;
+        HalfOf& operator=(const HalfOf&) = delete;
+        HalfOf& operator=(HalfOf&&) = delete;
+};
+
+template<>
+class HalfOf<uint48_t> final {
+    public:
+        using FullType = uint48_t;
+        using HalfType = uint32_t;
+    public:
+        HalfOf() = delete;
+        ~HalfOf() = delete;
+        HalfOf(const HalfOf&) = delete;
+        HalfOf(HalfOf&&) = delete;
+        HalfOf& operator=(const HalfOf&) = delete;
+        HalfOf& operator=(HalfOf&&) = delete;
+};
+
+// the halves and quarters do not fill their slice types so the masks have to be spelled out
+template<> constexpr uint24_t LowerHalfMask<uint24_t> = 0xFFF;
+template<> constexpr uint48_t LowerHalfMask<uint48_t> = 0xFF'FFFF;
+template<> constexpr uint24_t LowestQuarterMask<uint24_t> = 0x3F;
+template<> constexpr uint48_t LowestQuarterMask<uint48_t> = 0xFFF;
+
+static_assert(UpperHalfMask<uint24_t> == 0xFFF000);
+static_assert(HighestQuarterMask<uint48_t> == 0xFFF0'0000'0000);
+static_assert(FieldVector<uint24_t, uint8_t, 8, 8>::decode(0x12'3456) == 0x34);
+static_assert(FieldVector<uint24_t, uint8_t, 8, 8>::encode(0x12'0056, 0x34) == 0x12'3456);
+static_assert(Flag<uint48_t, 47>::decode(0x8000'0000'0000));
+static_assert(std::get<1>(getHalves<uint24_t>(0xABC'DEF)) == 0xABC);
+
+/**
+ * Expand packed quantities into the lanes of their WideType. The number of
+ * elements converted (the shorter of the two spans) is returned.
+ */
+template<std::size_t Bytes>
+std::size_t loadPacked(std::span<const PackedUnsigned<Bytes>> input, std::span<typename PackedUnsigned<Bytes>::WideType> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    // every 16 byte load must stay within the input so leave room at the end
+    auto bytes = reinterpret_cast<const uint8_t*>(input.data());
+    auto out = reinterpret_cast<__m128i*>(output.data());
+    if constexpr (Bytes == 3) {
+        const auto ctrl = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        for (; (i + 6) <= count; i += 4) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + (i * Bytes)));
+            _mm_storeu_si128(out + (i / 4), _mm_shuffle_epi8(v, ctrl));
+        }
+    } else if constexpr (Bytes == 6) {
+        const auto ctrl = _mm_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1);
+        for (; (i + 3) <= count; i += 2) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + (i * Bytes)));
+            _mm_storeu_si128(out + (i / 2), _mm_shuffle_epi8(v, ctrl));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = input[i].value();
+    }
+    return count;
+}
+
+/**
+ * Expand packed quantities into their WideType while sign extending them,
+ * mostly useful for 24-bit audio samples.
+ */
+template<std::size_t Bytes>
+std::size_t loadPackedSigned(std::span<const PackedUnsigned<Bytes>> input, std::span<std::make_signed_t<typename PackedUnsigned<Bytes>::WideType>> output) noexcept {
+    using Wide = typename PackedUnsigned<Bytes>::WideType;
+    using Signed = std::make_signed_t<Wide>;
+    constexpr auto Unused = BitCount<Wide> - BitCount<PackedUnsigned<Bytes>>;
+    auto count = std::min(input.size(), output.size());
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    if constexpr (Bytes == 3) {
+        // place the bytes in the top of each lane and let the arithmetic shift do the extension
+        auto bytes = reinterpret_cast<const uint8_t*>(input.data());
+        auto out = reinterpret_cast<__m128i*>(output.data());
+        const auto ctrl = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        for (; (i + 6) <= count; i += 4) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + (i * Bytes)));
+            _mm_storeu_si128(out + (i / 4), _mm_srai_epi32(_mm_shuffle_epi8(v, ctrl), Unused));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = static_cast<Signed>(static_cast<Wide>(input[i].value() << Unused)) >> Unused;
+    }
+    return count;
+}
+
+/**
+ * Truncate WideType lanes into packed storage
+ */
+template<std::size_t Bytes>
+std::size_t storePacked(std::span<const typename PackedUnsigned<Bytes>::WideType> input, std::span<PackedUnsigned<Bytes>> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    // the 16 byte store writes past the converted elements so leave room at the end
+    auto in = reinterpret_cast<const __m128i*>(input.data());
+    auto bytes = reinterpret_cast<uint8_t*>(output.data());
+    if constexpr (Bytes == 3) {
+        const auto ctrl = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for (; (i + 6) <= count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + (i * Bytes)), _mm_shuffle_epi8(_mm_loadu_si128(in + (i / 4)), ctrl));
+        }
+    } else if constexpr (Bytes == 6) {
+        const auto ctrl = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+        for (; (i + 3) <= count; i += 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + (i * Bytes)), _mm_shuffle_epi8(_mm_loadu_si128(in + (i / 2)), ctrl));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = PackedUnsigned<Bytes>(input[i]);
+    }
+    return count;
+}
+
+/**
+ * View a raw byte buffer as packed quantities (any trailing partial element is ignored)
+ */
+template<std::size_t Bytes>
+std::span<const PackedUnsigned<Bytes>> asPacked(std::span<const uint8_t> bytes) noexcept {
+    return { reinterpret_cast<const PackedUnsigned<Bytes>*>(bytes.data()), bytes.size() / Bytes };
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_PackedIntegers_h__
@@ -0,0 +1,185 @@
+/**
+ * @file
+ * Zero copy reader for libpcap capture files
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Pcap_h__
+#define BinaryManipulation_Pcap_h__
+#include "BinaryManipulation.h"
+#include "MappedFile.h"
+#include <iterator>
+#include <vector>
+namespace BinaryManipulation {
+
+constexpr uint32_t PcapMicrosecondMagic = 0xA1B2'C3D4;
+constexpr uint32_t PcapNanosecondMagic = 0xA1B2'3C4D;
+constexpr std::size_t PcapFileHeaderLength = 24;
+constexpr std::size_t PcapRecordHeaderLength = 16;
+
+enum class PcapLinkType : uint32_t {
+    Ethernet = 1,
+    Raw = 101,
+};
+
+/**
+ * A captured packet, data points into the capture itself
+ */
+struct PcapPacket {
+    uint32_t seconds;
+    /// microseconds or nanoseconds depending on the capture
+    uint32_t fraction;
+    uint32_t originalLength;
+    std::span<const uint8_t> data;
+};
+
+/**
+ * Walks the records of a capture held in memory (usually a MappedFile) without
+ * copying. A truncated final record ends the iteration.
+ */
+class PcapReader final {
+    public:
+        class Iterator final {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = PcapPacket;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const PcapPacket*;
+                using reference = const PcapPacket&;
+            public:
+                Iterator() = default;
+                Iterator(std::span<const uint8_t> remaining, std::endian order) noexcept : _remaining(remaining), _order(order) { load(); }
+                reference operator*() const noexcept { return _current; }
+                pointer operator->() const noexcept { return &_current; }
+                Iterator& operator++() noexcept {
+                    _remaining = _remaining.subspan(PcapRecordHeaderLength + _current.data.size());
+                    load();
+                    return *this;
+                }
+                Iterator operator++(int) noexcept {
+                    auto copy = *this;
+                    ++(*this);
+                    return copy;
+                }
+                bool operator==(const Iterator& other) const noexcept { return _remaining.data() == other._remaining.data(); }
+            private:
+                void load() noexcept {
+                    if (_remaining.size() < PcapRecordHeaderLength) {
+                        _remaining = { };
+                        return;
+                    }
+                    auto field = [this](std::size_t index) noexcept { return loadFromBytes<uint32_t>(_remaining.data() + (index * 4), _order); };
+                    auto captured = static_cast<std::size_t>(field(2));
+                    if (captured > (_remaining.size() - PcapRecordHeaderLength)) {
+                        _remaining = { };
+                        return;
+                    }
+                    _current = { field(0), field(1), field(3), _remaining.subspan(PcapRecordHeaderLength, captured) };
+                }
+            private:
+                std::span<const uint8_t> _remaining;
+                std::endian _order = std::endian::little;
+                PcapPacket _current { };
+        };
+    public:
+        explicit PcapReader(std::span<const uint8_t> bytes) noexcept : _bytes(bytes) {
+            if (bytes.size() < PcapFileHeaderLength) {
+                return;
+            }
+            // the magic number is written in the byte order of the capturing host
+            for (auto order : { std::endian::little, std::endian::big }) {
+                auto magic = loadFromBytes<uint32_t>(bytes.data(), order);
+                if (magic == PcapMicrosecondMagic || magic == PcapNanosecondMagic) {
+                    _order = order;
+                    _nanoseconds = magic == PcapNanosecondMagic;
+                    _valid = true;
+                }
+            }
+            if (_valid) {
+                _snapLength = loadFromBytes<uint32_t>(bytes.data() + 16, _order);
+                _linkType = static_cast<PcapLinkType>(loadFromBytes<uint32_t>(bytes.data() + 20, _order));
+            }
+        }
+        bool valid() const noexcept { return _valid; }
+        bool nanosecondTimestamps() const noexcept { return _nanoseconds; }
+        std::endian byteOrder() const noexcept { return _order; }
+        uint32_t snapLength() const noexcept { return _snapLength; }
+        PcapLinkType linkType() const noexcept { return _linkType; }
+        Iterator begin() const noexcept { return _valid ? Iterator(_bytes.subspan(PcapFileHeaderLength), _order) : end(); }
+        Iterator end() const noexcept { return { }; }
+    private:
+        std::span<const uint8_t> _bytes;
+        std::endian _order = std::endian::little;
+        uint32_t _snapLength = 0;
+        PcapLinkType _linkType = PcapLinkType::Ethernet;
+        bool _nanoseconds = false;
+        bool _valid = false;
+};
+
+/**
+ * Owns the mapping of a capture file alongside a reader over it
+ */
+class PcapFile final {
+    public:
+        explicit PcapFile(const char* path) noexcept : _file(path), _reader(_file.bytes()) {
+            _file.adviseSequential();
+        }
+        bool valid() const noexcept { return _file.valid() && _reader.valid(); }
+        const PcapReader& reader() const noexcept { return _reader; }
+        auto begin() const noexcept { return _reader.begin(); }
+        auto end() const noexcept { return _reader.end(); }
+    private:
+        MappedFile _file;
+        PcapReader _reader;
+};
+
+/**
+ * Append a native byte order, microsecond capture file header
+ */
+inline void writePcapHeader(std::vector<uint8_t>& output, PcapLinkType linkType, uint32_t snapLength = 0xFFFF) {
+    auto put = [&output](auto value) {
+        uint8_t bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        output.insert(output.end(), std::begin(bytes), std::end(bytes));
+    };
+    put(PcapMicrosecondMagic);
+    put(uint16_t(2));
+    put(uint16_t(4));
+    put(int32_t(0));
+    put(uint32_t(0));
+    put(snapLength);
+    put(static_cast<uint32_t>(linkType));
+}
+inline void writePcapRecord(std::vector<uint8_t>& output, uint32_t seconds, uint32_t microseconds, std::span<const uint8_t> data) {
+    for (auto value : { seconds, microseconds, static_cast<uint32_t>(data.size()), static_cast<uint32_t>(data.size()) }) {
+        uint8_t bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        output.insert(output.end(), std::begin(bytes), std::end(bytes));
+    }
+    output.insert(output.end(), data.begin(), data.end());
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_Pcap_h__
@@ -0,0 +1,138 @@
+/**
+ * @file
+ * Packed pixel format descriptions and conversions between them
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_PixelFormats_h__
+#define BinaryManipulation_PixelFormats_h__
+#include "BinaryManipulation.h"
+namespace BinaryManipulation {
+
+// Pixel formats are Descriptions whose patterns are the channels in red,
+// green, blue, (optional) alpha order. Bit positions are relative to the
+// value, not memory, so RGBA8888 is the byte sequence R, G, B, A in memory on
+// little endian hosts.
+
+template<typename T, T start, T end>
+using ChannelRange = FieldRange<T, uint16_t, start, end>;
+
+using RGBA8888 = Description<uint32_t, ChannelRange<uint32_t, 0, 7>, ChannelRange<uint32_t, 8, 15>, ChannelRange<uint32_t, 16, 23>, ChannelRange<uint32_t, 24, 31>>;
+using BGRA8888 = Description<uint32_t, ChannelRange<uint32_t, 16, 23>, ChannelRange<uint32_t, 8, 15>, ChannelRange<uint32_t, 0, 7>, ChannelRange<uint32_t, 24, 31>>;
+using RGB565 = Description<uint16_t, ChannelRange<uint16_t, 11, 15>, ChannelRange<uint16_t, 5, 10>, ChannelRange<uint16_t, 0, 4>>;
+using RGBA5551 = Description<uint16_t, ChannelRange<uint16_t, 11, 15>, ChannelRange<uint16_t, 6, 10>, ChannelRange<uint16_t, 1, 5>, ChannelRange<uint16_t, 0, 0>>;
+using ARGB1555 = Description<uint16_t, ChannelRange<uint16_t, 10, 14>, ChannelRange<uint16_t, 5, 9>, ChannelRange<uint16_t, 0, 4>, ChannelRange<uint16_t, 15, 15>>;
+using RGBA4444 = Description<uint16_t, ChannelRange<uint16_t, 12, 15>, ChannelRange<uint16_t, 8, 11>, ChannelRange<uint16_t, 4, 7>, ChannelRange<uint16_t, 0, 3>>;
+using RGB10A2 = Description<uint32_t, ChannelRange<uint32_t, 0, 9>, ChannelRange<uint32_t, 10, 19>, ChannelRange<uint32_t, 20, 29>, ChannelRange<uint32_t, 30, 31>>;
+
+template<typename Format>
+constexpr bool HasAlphaChannel = Format::NumberOfPatterns == 4;
+
+/**
+ * Convert a channel value from one width to another. Widening replicates
+ * the high bits into the new low bits (so full scale stays full scale) and
+ * narrowing rounds to the nearest representable value.
+ */
+template<std::size_t fromWidth, std::size_t toWidth>
+constexpr uint32_t rescaleChannel(uint32_t value) noexcept {
+    if constexpr (fromWidth == toWidth) {
+        return value;
+    } else if constexpr (fromWidth < toWidth) {
+        uint32_t result = 0;
+        for (int position = static_cast<int>(toWidth) - static_cast<int>(fromWidth); position > -static_cast<int>(fromWidth); position -= static_cast<int>(fromWidth)) {
+            result |= position >= 0 ? (value << position) : (value >> -position);
+        }
+        return result;
+    } else {
+        constexpr uint32_t fromMax = (1u << fromWidth) - 1;
+        constexpr uint32_t toMax = (1u << toWidth) - 1;
+        return ((value * toMax) + (fromMax / 2)) / fromMax;
+    }
+}
+static_assert(rescaleChannel<5, 8>(0x1F) == 0xFF);
+static_assert(rescaleChannel<5, 8>(0x10) == 0x84);
+static_assert(rescaleChannel<1, 8>(1) == 0xFF);
+static_assert(rescaleChannel<2, 8>(0b10) == 0b1010'1010);
+static_assert(rescaleChannel<8, 5>(0x84) == 0x10);
+static_assert(rescaleChannel<10, 8>(0x3FF) == 0xFF);
+
+namespace Pixels {
+template<typename From, typename To, std::size_t channel>
+constexpr typename To::DataType convertChannel(typename From::DataType pixel) noexcept {
+    using Target = PatternAt_t<To, channel>;
+    constexpr auto toWidth = static_cast<std::size_t>(Target::FieldWidth);
+    if constexpr (channel < From::NumberOfPatterns) {
+        using Source = PatternAt_t<From, channel>;
+        constexpr auto fromWidth = static_cast<std::size_t>(Source::FieldWidth);
+        return Target::encode(static_cast<uint16_t>(rescaleChannel<fromWidth, toWidth>(Source::decode(pixel))));
+    } else {
+        // no alpha in the source means fully opaque
+        return Target::Mask;
+    }
+}
+template<typename From, typename To, std::size_t ... channels>
+constexpr typename To::DataType convert(typename From::DataType pixel, std::index_sequence<channels...>) noexcept {
+    return static_cast<typename To::DataType>((convertChannel<From, To, channels>(pixel) | ...));
+}
+} // end namespace Pixels
+
+/**
+ * Convert a single pixel between formats, alpha is dropped if the target
+ * does not have it and is opaque if the source does not have it
+ */
+template<typename From, typename To>
+constexpr typename To::DataType convertPixel(typename From::DataType pixel) noexcept {
+    return Pixels::convert<From, To>(pixel, std::make_index_sequence<To::NumberOfPatterns> { });
+}
+static_assert(convertPixel<RGB565, RGBA8888>(0xF800) == 0xFF00'00FF);
+static_assert(convertPixel<RGBA8888, RGB565>(0xFF00'FF00) == 0x07E0);
+static_assert(convertPixel<RGBA8888, RGBA5551>(0x7F00'0000) == 0x0000);
+static_assert(convertPixel<RGB10A2, RGBA8888>(0xC000'03FF) == 0xFF00'00FF);
+
+/**
+ * Convert a run of pixels. Each channel is a constant mask, shift, and
+ * rescale so the loop is straight line code the compiler vectorizes.
+ */
+template<typename From, typename To>
+std::size_t convertPixels(std::span<const typename From::DataType> input, std::span<typename To::DataType> output) noexcept {
+    auto count = std::min(input.size(), output.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = convertPixel<From, To>(input[i]);
+    }
+    return count;
+}
+
+template<typename From>
+std::size_t toRGBA8888(std::span<const typename From::DataType> input, std::span<uint32_t> output) noexcept {
+    return convertPixels<From, RGBA8888>(input, output);
+}
+
+template<typename To>
+std::size_t fromRGBA8888(std::span<const uint32_t> input, std::span<typename To::DataType> output) noexcept {
+    return convertPixels<RGBA8888, To>(input, output);
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_PixelFormats_h__
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * Registers declared by their Description with cached decoded fields and dirty tracking
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_RegisterFile_h__
+#define BinaryManipulation_RegisterFile_h__
+#include "BinaryManipulation.h"
+#include "Watchpoints.h"
+#include <array>
+#include <tuple>
+#include <utility>
+namespace BinaryManipulation {
+
+/**
+ * Index of the first field of D laid out by P, NumberOfPatterns if none is
+ */
+template<typename D, typename P>
+constexpr std::size_t PatternIndex = [] <std::size_t ... I>(std::index_sequence<I...>) {
+    std::size_t index = D::NumberOfPatterns;
+    ((index = (index == D::NumberOfPatterns && std::is_same_v<PatternAt_t<D, I>, P>) ? I : index), ...);
+    return index;
+}(std::make_index_sequence<D::NumberOfPatterns> { });
+
+/**
+ * A register whose fields are decoded when it is written rather than when
+ * it is read. Every write records which fields changed in a dirty mask
+ * that stays set until taken. A watchable register also reports writes
+ * to its armed fields, otherwise the watch compiles away entirely.
+ */
+template<typename D, bool watchable = false>
+class CachedRegister final {
+    public:
+        static_assert(IsDescription<D>);
+        static_assert(D::NumberOfPatterns <= 64, "one dirty bit per field");
+        using DataType = typename D::DataType;
+        using Fields = typename D::SliceType;
+        using DirtyMask = uint64_t;
+        template<std::size_t I>
+        using FieldPattern = PatternAt_t<D, I>;
+        static constexpr std::size_t NumberOfFields = D::NumberOfPatterns;
+        static constexpr bool Watchable = watchable;
+        using WatchType = WatchFor<watchable, DataType>;
+    public:
+        constexpr explicit CachedRegister(DataType value = 0) noexcept : _raw(value), _fields(decodeAll(value)) { }
+        constexpr DataType raw() const noexcept { return _raw; }
+        constexpr const Fields& fields() const noexcept { return _fields; }
+        template<std::size_t I>
+        constexpr const auto& field() const noexcept { return std::get<I>(_fields); }
+        template<typename P>
+        constexpr const auto& field() const noexcept { return field<indexOf<P>()>(); }
+        /**
+         * Replace the whole register
+         */
+        constexpr void write(DataType value) noexcept(!watchable) {
+            _watch.check(_raw, value);
+            _dirty |= changedFields(_raw, value);
+            _raw = value;
+            _fields = decodeAll(value);
+        }
+        /**
+         * Update a single field, the others keep their cached values
+         */
+        template<std::size_t I>
+        constexpr void setField(typename FieldPattern<I>::SliceType value) noexcept(!watchable) {
+            using P = FieldPattern<I>;
+            auto updated = watchedEncode<P>(_raw, value, _watch);
+            _dirty |= static_cast<DirtyMask>(((_raw ^ updated) & P::Mask) != 0) << I;
+            _raw = updated;
+            std::get<I>(_fields) = P::decode(updated);
+        }
+        template<typename P>
+        constexpr void setField(typename P::SliceType value) noexcept(!watchable) { setField<indexOf<P>()>(value); }
+        constexpr DirtyMask dirty() const noexcept { return _dirty; }
+        template<typename P>
+        constexpr bool isDirty() const noexcept { return (_dirty >> indexOf<P>()) & 1; }
+        /**
+         * The fields changed since the last call
+         */
+        constexpr DirtyMask takeDirty() noexcept { return std::exchange(_dirty, 0); }
+        constexpr WatchType& watch() noexcept requires watchable { return _watch; }
+        /**
+         * One bit per field whose bits differ between the two values
+         */
+        static constexpr DirtyMask changedFields(DataType before, DataType after) noexcept {
+            auto difference = before ^ after;
+            return [difference] <std::size_t ... I>(std::index_sequence<I...>) {
+                return ((static_cast<DirtyMask>((difference & FieldPattern<I>::Mask) != 0) << I) | ... | DirtyMask { 0 });
+            }(std::make_index_sequence<NumberOfFields> { });
+        }
+    private:
+        template<typename P>
+        static constexpr std::size_t indexOf() noexcept {
+            static_assert(PatternIndex<D, P> < NumberOfFields, "the pattern is not a field of this register");
+            return PatternIndex<D, P>;
+        }
+        static constexpr Fields decodeAll(DataType value) noexcept {
+            return [value] <std::size_t ... I>(std::index_sequence<I...>) {
+                return Fields { FieldPattern<I>::decode(value)... };
+            }(std::make_index_sequence<NumberOfFields> { });
+        }
+    private:
+        DataType _raw;
+        Fields _fields;
+        DirtyMask _dirty = 0;
+        [[no_unique_address]] WatchType _watch;
+};
+
+/**
+ * A set of registers, each declared with the Description of its layout.
+ * A snapshot only holds the raw values; restoring one rewrites every
+ * register so the dirty masks show what the restore changed.
+ */
+template<bool watchable, typename ... Descriptions>
+class BasicRegisterFile final {
+    public:
+        static constexpr std::size_t NumberOfRegisters = sizeof...(Descriptions);
+        using Registers = std::tuple<CachedRegister<Descriptions, watchable>...>;
+        using Snapshot = std::tuple<typename Descriptions::DataType...>;
+        template<std::size_t I>
+        using RegisterAt = std::tuple_element_t<I, Registers>;
+    public:
+        constexpr BasicRegisterFile() noexcept = default;
+        constexpr explicit BasicRegisterFile(typename Descriptions::DataType ... values) noexcept : _registers(CachedRegister<Descriptions, watchable>(values)...) { }
+        template<std::size_t I>
+        constexpr RegisterAt<I>& get() noexcept { return std::get<I>(_registers); }
+        template<std::size_t I>
+        constexpr const RegisterAt<I>& get() const noexcept { return std::get<I>(_registers); }
+        /**
+         * Look a register up by its Description, which must be unique in the file
+         */
+        template<typename D>
+        constexpr CachedRegister<D, watchable>& get() noexcept { return std::get<CachedRegister<D, watchable>>(_registers); }
+        template<typename D>
+        constexpr const CachedRegister<D, watchable>& get() const noexcept { return std::get<CachedRegister<D, watchable>>(_registers); }
+        constexpr Snapshot snapshot() const noexcept {
+            return std::apply([](const auto& ... registers) { return Snapshot { registers.raw()... }; }, _registers);
+        }
+        constexpr void restore(const Snapshot& snapshot) noexcept(!watchable) {
+            [&] <std::size_t ... I>(std::index_sequence<I...>) {
+                (std::get<I>(_registers).write(std::get<I>(snapshot)), ...);
+            }(std::make_index_sequence<NumberOfRegisters> { });
+        }
+        /**
+         * Take the dirty masks of every register, in declaration order
+         */
+        constexpr std::array<uint64_t, NumberOfRegisters> takeDirty() noexcept {
+            return std::apply([](auto& ... registers) { return std::array<uint64_t, NumberOfRegisters> { registers.takeDirty()... }; }, _registers);
+        }
+        /**
+         * Send the hits of every register to log, the source of a hit is the register's index
+         */
+        template<typename Log>
+        constexpr void attach(Log& log) noexcept requires watchable {
+            [&] <std::size_t ... I>(std::index_sequence<I...>) {
+                (std::get<I>(_registers).watch().attach(log, I), ...);
+            }(std::make_index_sequence<NumberOfRegisters> { });
+        }
+    private:
+        Registers _registers;
+};
+template<typename ... Descriptions>
+using RegisterFile = BasicRegisterFile<false, Descriptions...>;
+template<typename ... Descriptions>
+using WatchedRegisterFile = BasicRegisterFile<true, Descriptions...>;
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_RegisterFile_h__
@@ -1,5 +1,40 @@
 #include "BinaryManipulation.h"
+#include "Interleave.h"
+#include "BytePlanes.h"
+#include "PackedIntegers.h"
+#include "FloatingPoint.h"
+#include "HalfPrecision.h"
+#include "FixedPoint.h"
+#include "PixelFormats.h"
+#include "Nucleotides.h"
+#include "Utf8.h"
+#include "TextCodecs.h"
+#include "Formatting.h"
+#include "i960.h"
+#include "i960Disassembler.h"
+#include "i960Encoder.h"
+#include "i960Interpreter.h"
+#include "RegisterFile.h"
+#include "i960Stream.h"
+#include "Mmu.h"
+#include "CacheSimulator.h"
+#include "GuestMemory.h"
+#include "Watchpoints.h"
+#include "NetworkHeaders.h"
+#include "Pcap.h"
+#include "Elf.h"
+#include <cmath>
 #include <iostream>
+#include <vector>
+#include <numeric>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 
 template<typename T>
 void outputToCout(T value) noexcept {
@@ -116,10 +151,1679 @@ using TraceControlsFlag = BinaryManipulation::Flag<Ordinal, position>;
          std::cout << "Failure!" << std::endl;
      }
  }
+void test4() {
+    std::cout << "Simple test 4: Morton interleaving of halves" << std::endl;
+    // reference implementation, walk the bits one at a time
+    auto slowInterleave = [](uint32_t value) noexcept {
+        uint32_t result = 0;
+        for (int i = 0; i < 16; ++i) {
+            result |= ((value >> i) & 1) << (2 * i);
+            result |= ((value >> (16 + i)) & 1) << ((2 * i) + 1);
+        }
+        return result;
+    };
+    std::vector<uint16_t> xs, ys;
+    std::vector<uint32_t> words;
+    uint32_t state = 0xFDEDABCD;
+    for (int i = 0; i < 0x1000; ++i) {
+        // xorshift32, good enough to cover the bit patterns
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        auto [lower, upper] = BinaryManipulation::getHalves<uint32_t>(state);
+        xs.push_back(lower);
+        ys.push_back(upper);
+        words.push_back(state);
+        auto encoded = BinaryManipulation::interleaveHalves<uint32_t>(state);
+        if (encoded != slowInterleave(state) || BinaryManipulation::deinterleave<uint32_t>(encoded) != state) {
+            std::cout << "Bad interleave of 0x" << std::hex << state << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+        auto wide = static_cast<uint64_t>(state) * 0x9E37'79B9'7F4A'7C15;
+        auto [a, b, c] = BinaryManipulation::deinterleave3<uint64_t>(BinaryManipulation::interleave3<uint64_t>(wide, wide >> 21, wide >> 42));
+        if (a != (wide & 0x1F'FFFF) || b != ((wide >> 21) & 0x1F'FFFF) || c != ((wide >> 42) & 0x1F'FFFF)) {
+            std::cout << "Bad three way interleave of 0x" << std::hex << wide << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::vector<uint32_t> encoded(words.size()), fromPairs(words.size()), decoded(words.size());
+    BinaryManipulation::interleaveHalves<uint32_t>(words, encoded);
+    BinaryManipulation::interleaveHalves<uint32_t>(xs, ys, fromPairs);
+    BinaryManipulation::deinterleave<uint32_t>(encoded, decoded);
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        if (encoded[i] != slowInterleave(words[i]) || fromPairs[i] != encoded[i] || decoded[i] != words[i]) {
+            std::cout << "Batch mismatch on 0x" << std::hex << words[i] << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+template<typename T>
+bool checkPlaneRoundTrip(std::size_t count) noexcept {
+    std::vector<T> input(count), output(count);
+    uint64_t state = 0x0123'4567'89AB'CDEF;
+    for (auto& value : input) {
+        state = (state * 6364136223846793005ull) + 1442695040888963407ull;
+        value = static_cast<T>(state >> 17);
+    }
+    std::vector<uint8_t> planes(count * sizeof(T));
+    BinaryManipulation::toBytePlanes<T>(input, planes);
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t k = 0; k < sizeof(T); ++k) {
+            if (planes[(k * count) + i] != static_cast<uint8_t>(input[i] >> (k * 8))) {
+                return false;
+            }
+        }
+    }
+    BinaryManipulation::fromBytePlanes<T>(planes, output);
+    if (input != output) {
+        return false;
+    }
+    if constexpr (sizeof(T) >= sizeof(uint32_t)) {
+        std::vector<BinaryManipulation::QuarterType_t<T>> quarters(count * 4);
+        std::fill(output.begin(), output.end(), 0);
+        BinaryManipulation::toQuarterPlanes<T>(input, quarters);
+        BinaryManipulation::fromQuarterPlanes<T>(quarters, output);
+        if (input != output || quarters[(3 * count) + (count / 2)] != std::get<3>(BinaryManipulation::getQuarters<T>(input[count / 2]))) {
+            return false;
+        }
+    }
+    std::vector<BinaryManipulation::HalfType_t<T>> halves(count * 2);
+    std::fill(output.begin(), output.end(), 0);
+    BinaryManipulation::toHalfPlanes<T>(input, halves);
+    BinaryManipulation::fromHalfPlanes<T>(halves, output);
+    if (input != output || halves[count] != std::get<1>(BinaryManipulation::getHalves<T>(input[0]))) {
+        return false;
+    }
+    std::vector<uint8_t> nibbles(BinaryManipulation::nibblePlaneStride(count) * sizeof(T) * 2);
+    std::fill(output.begin(), output.end(), 0);
+    BinaryManipulation::toNibblePlanes<T>(input, nibbles);
+    BinaryManipulation::fromNibblePlanes<T>(nibbles, output);
+    return input == output;
+}
+void test5() {
+    std::cout << "Simple test 5: Byte, quarter, half, and nibble planes" << std::endl;
+    for (std::size_t count : { 1, 15, 16, 17, 1000, 1027 }) {
+        if (!checkPlaneRoundTrip<uint16_t>(count) ||
+            !checkPlaneRoundTrip<uint32_t>(count) ||
+            !checkPlaneRoundTrip<uint64_t>(count)) {
+            std::cout << "Plane round trip failed for " << std::dec << count << " elements" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test6() {
+    std::cout << "Simple test 6: Mixed endian record normalization" << std::endl;
+    // a 64-bit record: little endian 16-bit tag, big endian 32-bit length, big endian 16-bit checksum
+    using Tag = BinaryManipulation::FieldVector<uint64_t, uint16_t, 0, 16>;
+    using Length = BinaryManipulation::BigEndianFieldVector<uint64_t, uint32_t, 16, 32>;
+    using Checksum = BinaryManipulation::BigEndianFieldVector<uint64_t, uint16_t, 48, 16>;
+    using Record = BinaryManipulation::Description<uint64_t, Tag, Length, Checksum>;
+    using NativeRecord = BinaryManipulation::NormalizedForm_t<Record>;
+    static_assert(BinaryManipulation::ByteOrderPermutation<Record> == BinaryManipulation::ByteOrderPermutationType<uint64_t> { 0, 1, 5, 4, 3, 2, 7, 6 });
+    auto makeRaw = [](uint16_t tag, uint32_t length, uint16_t checksum) noexcept {
+        // assemble the bytes the way they would appear on disk
+        uint8_t bytes[8] = {
+            static_cast<uint8_t>(tag), static_cast<uint8_t>(tag >> 8),
+            static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16), static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length),
+            static_cast<uint8_t>(checksum >> 8), static_cast<uint8_t>(checksum),
+        };
+        uint64_t result = 0;
+        for (int i = 7; i >= 0; --i) {
+            result = (result << 8) | bytes[i];
+        }
+        return result;
+    };
+    std::vector<uint64_t> raw, expected;
+    for (uint32_t i = 0; i < 1027; ++i) {
+        auto tag = static_cast<uint16_t>(i * 0x9E37);
+        auto length = i * 0x0101'0203u;
+        auto checksum = static_cast<uint16_t>(~tag);
+        raw.push_back(makeRaw(tag, length, checksum));
+        expected.push_back(NativeRecord::encode(std::move(tag), std::move(length), std::move(checksum)));
+        auto [t, l, c] = Record::decode(raw.back());
+        if (t != tag || l != length || c != checksum) {
+            std::cout << "Direct decode of 0x" << std::hex << raw.back() << " failed" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    auto converted = raw;
+    Record::normalizeEndianness(converted);
+    if (converted != expected || NativeRecord::decode(converted[5]) != Record::decode(raw[5])) {
+        std::cout << "Batch normalization failed!" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    Record::normalizeEndianness(converted);
+    if (converted != raw) {
+        std::cout << "Normalization is not its own inverse!" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test7() {
+    std::cout << "Simple test 7: Packed 24 and 48-bit quantities" << std::endl;
+    using BinaryManipulation::uint24_t;
+    using BinaryManipulation::uint48_t;
+    // an RGB triplet packed into 24 bits
+    using Red = BinaryManipulation::FieldVector<uint24_t, uint8_t, 0, 8>;
+    using Green = BinaryManipulation::FieldVector<uint24_t, uint8_t, 8, 8>;
+    using Blue = BinaryManipulation::FieldVector<uint24_t, uint8_t, 16, 8>;
+    using RGB = BinaryManipulation::Description<uint24_t, Red, Green, Blue>;
+    std::vector<uint8_t> raw;
+    for (int i = 0; i < 1001 * 6; ++i) {
+        raw.push_back(static_cast<uint8_t>((i * 37) ^ (i >> 3)));
+    }
+    auto samples = BinaryManipulation::asPacked<3>(raw);
+    std::vector<uint32_t> wide(samples.size());
+    std::vector<int32_t> signedWide(samples.size());
+    BinaryManipulation::loadPacked<3>(samples, wide);
+    BinaryManipulation::loadPackedSigned<3>(samples, signedWide);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        auto expected = raw[i * 3] | (raw[(i * 3) + 1] << 8) | (raw[(i * 3) + 2] << 16);
+        auto [r, g, b] = RGB::decode(samples[i]);
+        auto signedExpected = (expected & 0x80'0000) ? (expected - 0x100'0000) : expected;
+        if (wide[i] != static_cast<uint32_t>(expected) || signedWide[i] != signedExpected ||
+            r != raw[i * 3] || g != raw[(i * 3) + 1] || b != raw[(i * 3) + 2] ||
+            RGB::encode(std::move(r), std::move(g), std::move(b)) != samples[i]) {
+            std::cout << "Mismatch on 24-bit element " << std::dec << i << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::vector<uint24_t> repacked(samples.size());
+    BinaryManipulation::storePacked<3>(wide, repacked);
+    if (!std::equal(repacked.begin(), repacked.end(), samples.begin())) {
+        std::cout << "24-bit store mismatch!" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    auto addresses = BinaryManipulation::asPacked<6>(raw);
+    std::vector<uint64_t> wideAddresses(addresses.size());
+    std::vector<uint48_t> repackedAddresses(addresses.size());
+    BinaryManipulation::loadPacked<6>(addresses, wideAddresses);
+    BinaryManipulation::storePacked<6>(wideAddresses, repackedAddresses);
+    for (std::size_t i = 0; i < addresses.size(); ++i) {
+        auto [lower, upper] = BinaryManipulation::getHalves<uint48_t>(addresses[i]);
+        if (wideAddresses[i] != addresses[i].value() || repackedAddresses[i] != addresses[i] ||
+            lower != (wideAddresses[i] & 0xFF'FFFF) || upper != (wideAddresses[i] >> 24)) {
+            std::cout << "Mismatch on 48-bit element " << std::dec << i << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+template<typename F>
+bool checkFloatingPointBatches() noexcept {
+    using Layout = BinaryManipulation::FloatingPointLayout_t<F>;
+    using Category = BinaryManipulation::FloatingPointCategory;
+    std::vector<F> values { 0, -0.0, 1, -2, std::numeric_limits<F>::denorm_min(), std::numeric_limits<F>::infinity(),
+                            std::numeric_limits<F>::quiet_NaN(), std::numeric_limits<F>::max(), std::numeric_limits<F>::min() };
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(std::ldexp(static_cast<F>(i) + static_cast<F>(0.25), (i % 200) - 100));
+    }
+    std::vector<Category> categories(values.size());
+    BinaryManipulation::categorize<F>(values, categories);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        Category expected = Category::Normal;
+        switch (std::fpclassify(values[i])) {
+            case FP_ZERO: expected = Category::Zero; break;
+            case FP_SUBNORMAL: expected = Category::Subnormal; break;
+            case FP_INFINITE: expected = Category::Infinite; break;
+            case FP_NAN: expected = Category::NaN; break;
+            default: break;
+        }
+        if (categories[i] != expected) {
+            return false;
+        }
+    }
+    auto counts = BinaryManipulation::countCategories<F>(values);
+    if (counts[static_cast<int>(Category::NaN)] != 1 || counts[static_cast<int>(Category::Zero)] != 2) {
+        return false;
+    }
+    std::vector<std::size_t> histogram(static_cast<std::size_t>(Layout::MaxExponent) + 1);
+    if (BinaryManipulation::exponentHistogram<F>(values, std::span<std::size_t>(histogram).first(Layout::MaxExponent)) != 0 ||
+        BinaryManipulation::exponentHistogram<F>(values, histogram) != values.size()) {
+        return false;
+    }
+    if (histogram[Layout::Bias] < 1 || std::accumulate(histogram.begin(), histogram.end(), std::size_t(0)) != values.size()) {
+        return false;
+    }
+    std::vector<typename Layout::MantissaType> mantissas(values.size());
+    std::vector<typename Layout::ExponentType> exponents(values.size());
+    std::unique_ptr<bool[]> signs(new bool[values.size()]);
+    std::vector<F> rebuilt(values.size());
+    BinaryManipulation::decompose<F>(values, mantissas, exponents, std::span<bool>(signs.get(), values.size()));
+    BinaryManipulation::rebuild<F>(mantissas, exponents, std::span<const bool>(signs.get(), values.size()), rebuilt);
+    // compared through the fields, long double may carry padding that is not part of the value
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        auto expected = Layout::toBits(values[i]);
+        auto actual = Layout::toBits(rebuilt[i]);
+        if (Layout::mantissa(expected) != Layout::mantissa(actual) || Layout::exponent(expected) != Layout::exponent(actual) ||
+            Layout::sign(expected) != Layout::sign(actual)) {
+            return false;
+        }
+    }
+    return signs[3] && !signs[2];
+}
+void test8() {
+    std::cout << "Simple test 8: IEEE-754 field decomposition" << std::endl;
+    if (!checkFloatingPointBatches<float>() || !checkFloatingPointBatches<double>() || !checkFloatingPointBatches<long double>()) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if constexpr (std::is_same_v<BinaryManipulation::LongDoubleLayout, BinaryManipulation::X87ExtendedLayout>) {
+        auto [significand, exponent, sign] = BinaryManipulation::LongDoubleLayout::decode(-1.5L);
+        if (significand != 0xC000'0000'0000'0000 || exponent != 0x3FFF || !sign ||
+            BinaryManipulation::LongDoubleLayout::encode(significand, exponent + 1, false) != 3.0L) {
+            std::cout << "long double decode failed!" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+template<typename ToFloat, typename FromFloat, typename BatchFrom>
+bool checkHalfRounding(ToFloat toFloat, FromFloat fromFloat, BatchFrom batchFrom, uint16_t infinity) noexcept {
+    // every midpoint between two adjacent 16-bit values must round to the even one,
+    // and anything just off of the midpoint must round towards the closer one
+    std::vector<float> inputs;
+    std::vector<uint16_t> expected;
+    for (uint32_t h = 0; h < infinity; ++h) {
+        for (uint32_t sign : { 0x0000, 0x8000 }) {
+            auto lower = static_cast<uint16_t>(h | sign);
+            auto upper = static_cast<uint16_t>((h + 1) | sign);
+            auto lowerValue = toFloat(lower);
+            auto upperValue = toFloat(upper);
+            if (BinaryManipulation::FloatLayout::toBits(lowerValue) != BinaryManipulation::FloatLayout::toBits(toFloat(fromFloat(lowerValue)))) {
+                return false;
+            }
+            auto midpoint = (lowerValue / 2) + (upperValue / 2);
+            if (std::isinf(upperValue)) {
+                // the midpoint between the largest finite value and infinity
+                midpoint = lowerValue + ((lowerValue - toFloat(static_cast<uint16_t>((h - 1) | sign))) / 2);
+            }
+            inputs.push_back(midpoint);
+            expected.push_back((lower & 1) ? upper : lower);
+            inputs.push_back(std::nextafter(midpoint, lowerValue));
+            expected.push_back(lower);
+            inputs.push_back(std::nextafter(midpoint, upperValue));
+            expected.push_back(upper);
+        }
+    }
+    inputs.push_back(std::numeric_limits<float>::infinity());
+    expected.push_back(infinity);
+    inputs.push_back(std::numeric_limits<float>::max());
+    expected.push_back(infinity);
+    std::vector<uint16_t> batch(inputs.size());
+    batchFrom(std::span<const float>(inputs), std::span<uint16_t>(batch));
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        if (fromFloat(inputs[i]) != expected[i] || batch[i] != expected[i]) {
+            std::cout << "0x" << std::hex << BinaryManipulation::FloatLayout::toBits(inputs[i]) << " -> 0x" << fromFloat(inputs[i])
+                      << " (batch 0x" << batch[i] << ") instead of 0x" << expected[i] << std::endl;
+            return false;
+        }
+    }
+    auto nan = fromFloat(std::numeric_limits<float>::quiet_NaN());
+    return std::isnan(toFloat(nan)) && std::isnan(toFloat(fromFloat(-std::numeric_limits<float>::signaling_NaN())));
+}
+void test9() {
+    std::cout << "Simple test 9: binary16 and bfloat16 conversions" << std::endl;
+    // exhaustive 16-bit to float check against the batch kernels
+    std::vector<uint16_t> all(0x10000);
+    std::iota(all.begin(), all.end(), 0);
+    std::vector<float> halves(all.size()), brains(all.size());
+    BinaryManipulation::halfToFloat(all, halves);
+    BinaryManipulation::bfloat16ToFloat(all, brains);
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        auto h = static_cast<uint16_t>(i);
+        auto expected = std::ldexp(static_cast<float>(h & 0x3FF) + ((h & 0x7C00) ? 1024.0f : 0.0f), std::max((h >> 10) & 0x1F, 1) - 25);
+        if ((h & 0x7C00) == 0x7C00) {
+            expected = (h & 0x3FF) ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+        }
+        expected = (h & 0x8000) ? -expected : expected;
+        auto matches = [expected](float value) noexcept { return std::isnan(expected) ? std::isnan(value) : (value == expected && std::signbit(value) == std::signbit(expected)); };
+        if (!matches(halves[i]) || !matches(BinaryManipulation::halfToFloat(h)) ||
+            BinaryManipulation::FloatLayout::toBits(brains[i]) != (static_cast<uint32_t>(h) << 16)) {
+            std::cout << "Bad conversion of 0x" << std::hex << h << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    auto toHalf = [](uint16_t h) noexcept { return BinaryManipulation::halfToFloat(h); };
+    auto fromHalf = [](float f) noexcept { return BinaryManipulation::floatToHalf(f); };
+    auto batchHalf = [](std::span<const float> in, std::span<uint16_t> out) noexcept { return BinaryManipulation::floatToHalf(in, out); };
+    auto toBrain = [](uint16_t h) noexcept { return BinaryManipulation::bfloat16ToFloat(h); };
+    auto fromBrain = [](float f) noexcept { return BinaryManipulation::floatToBFloat16(f); };
+    auto batchBrain = [](std::span<const float> in, std::span<uint16_t> out) noexcept { return BinaryManipulation::floatToBFloat16(in, out); };
+    if (!checkHalfRounding(toHalf, fromHalf, batchHalf, 0x7C00) || !checkHalfRounding(toBrain, fromBrain, batchBrain, 0x7F80)) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test10() {
+    std::cout << "Simple test 10: Fixed point arithmetic" << std::endl;
+    using BinaryManipulation::Q16_16;
+    using BinaryManipulation::RoundingMode;
+    std::vector<Q16_16> as, bs, accumulators;
+    double expectedDot = 0;
+    uint32_t state = 0xFDEDABCD;
+    for (int i = 0; i < 4099; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        // keep the values small enough that the products fit in Q16.16
+        auto a = Q16_16::fromRaw(static_cast<int32_t>(state) >> 8);
+        auto b = Q16_16::fromRaw(static_cast<int32_t>(state * 0x9E37'79B9u) >> 9);
+        auto product = a.toDouble() * b.toDouble();
+        auto nearest = std::floor((product * 65536.0) + 0.5);
+        auto expected = Q16_16::fromRaw(static_cast<int32_t>(product < 0 && (nearest - (product * 65536.0)) == 0.5 ? nearest - 1 : nearest));
+        auto floored = Q16_16::fromRaw(static_cast<int32_t>(std::floor(product * 65536.0)));
+        if ((a * b) != expected || Q16_16::multiply<RoundingMode::Floor>(a, b) != floored ||
+            a.integer() != static_cast<int32_t>(std::floor(a.toDouble())) ||
+            Q16_16::fromParts(a.integer(), a.fraction()) != a) {
+            std::cout << "Bad multiply of " << a.toDouble() << " and " << b.toDouble() << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+        if (b.raw() != 0) {
+            auto quotient = Q16_16::divide<RoundingMode::TowardZero>(a, b);
+            if (quotient.raw() != static_cast<int32_t>(std::trunc((a.toDouble() / b.toDouble()) * 65536.0))) {
+                std::cout << "Bad divide of " << a.toDouble() << " by " << b.toDouble() << std::endl;
+                std::cout << "Failure!" << std::endl;
+                return;
+            }
+        }
+        as.push_back(a);
+        bs.push_back(b);
+        accumulators.push_back(Q16_16::fromInteger(i));
+        if (i < 16) {
+            // the full dot product would not fit into Q16.16
+            expectedDot += product;
+        }
+    }
+    auto dot = BinaryManipulation::multiplyAccumulate<Q16_16>(std::span(as).first(16), std::span(bs).first(16));
+    if (std::fabs(dot.toDouble() - expectedDot) > (1.0 / 65536.0)) {
+        std::cout << "Bad dot product " << dot.toDouble() << " vs " << expectedDot << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    BinaryManipulation::multiplyAccumulate<Q16_16>(as, bs, accumulators);
+    for (std::size_t i = 0; i < as.size(); ++i) {
+        if (accumulators[i] != (Q16_16::fromInteger(static_cast<int32_t>(i)) + (as[i] * bs[i]))) {
+            std::cout << "Bad multiply accumulate at " << std::dec << i << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+#ifdef __SIZEOF_INT128__
+    using BinaryManipulation::Q32_32;
+    auto big = Q32_32::fromDouble(123456.75) * Q32_32::fromDouble(-0.5);
+    if (big.toDouble() != -61728.375 || big.integer() != -61729 || Q32_32::saturatingMultiply(Q32_32::max(), Q32_32::fromInteger(2)) != Q32_32::max()) {
+        std::cout << "Bad Q32.32 arithmetic" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+#endif
+    std::cout << "Passed!" << std::endl;
+}
+template<typename Format>
+bool checkSixteenBitPixelFormat() noexcept {
+    // exhaustive: every 16-bit pixel must survive a trip through RGBA8888 and
+    // every expanded channel must be within one step of the exact scaling
+    std::vector<uint16_t> all(0x10000), back(0x10000);
+    std::vector<uint32_t> wide(0x10000);
+    std::iota(all.begin(), all.end(), 0);
+    BinaryManipulation::toRGBA8888<Format>(all, wide);
+    BinaryManipulation::fromRGBA8888<Format>(wide, back);
+    auto [r, g, b, a] = BinaryManipulation::RGBA8888::decode(wide[0xFFFF]);
+    if (r != 0xFF || g != 0xFF || b != 0xFF || a != 0xFF) {
+        return false;
+    }
+    for (uint32_t i = 0; i < all.size(); ++i) {
+        auto [sr, sg, sb] = std::make_tuple(BinaryManipulation::PatternAt_t<Format, 0>::decode(all[i]),
+                                            BinaryManipulation::PatternAt_t<Format, 1>::decode(all[i]),
+                                            BinaryManipulation::PatternAt_t<Format, 2>::decode(all[i]));
+        auto [wr, wg, wb, wa] = BinaryManipulation::RGBA8888::decode(wide[i]);
+        auto close = [](uint32_t narrow, uint32_t widened, int width) noexcept {
+            return std::fabs((narrow * 255.0 / ((1 << width) - 1)) - widened) < 1.0;
+        };
+        // channels which are not in the format are dropped, so compare masked
+        auto usedBits = BinaryManipulation::PatternAt_t<Format, 0>::Mask | BinaryManipulation::PatternAt_t<Format, 1>::Mask |
+                        BinaryManipulation::PatternAt_t<Format, 2>::Mask;
+        if constexpr (BinaryManipulation::HasAlphaChannel<Format>) {
+            usedBits |= BinaryManipulation::PatternAt_t<Format, 3>::Mask;
+        } else if (wa != 0xFF) {
+            return false;
+        }
+        if (back[i] != (all[i] & usedBits) ||
+            !close(sr, wr, BinaryManipulation::PatternAt_t<Format, 0>::FieldWidth) ||
+            !close(sg, wg, BinaryManipulation::PatternAt_t<Format, 1>::FieldWidth) ||
+            !close(sb, wb, BinaryManipulation::PatternAt_t<Format, 2>::FieldWidth)) {
+            std::cout << "Bad pixel conversion of 0x" << std::hex << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+void test11() {
+    std::cout << "Simple test 11: Packed pixel formats" << std::endl;
+    if (!checkSixteenBitPixelFormat<BinaryManipulation::RGB565>() ||
+        !checkSixteenBitPixelFormat<BinaryManipulation::RGBA5551>() ||
+        !checkSixteenBitPixelFormat<BinaryManipulation::ARGB1555>() ||
+        !checkSixteenBitPixelFormat<BinaryManipulation::RGBA4444>()) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // narrowing must round to nearest for every 8-bit channel value
+    for (uint32_t v = 0; v < 256; ++v) {
+        if (BinaryManipulation::rescaleChannel<8, 5>(v) != static_cast<uint32_t>(std::lround(v * 31.0 / 255.0)) ||
+            BinaryManipulation::rescaleChannel<8, 2>(v) != static_cast<uint32_t>(std::lround(v * 3.0 / 255.0))) {
+            std::cout << "Bad narrowing of " << std::dec << v << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::vector<uint32_t> pixels { 0xFFFF'FFFF, 0x8040'2010, 0x0000'0000, 0x7FFF'00FF };
+    std::vector<uint32_t> tenBit(pixels.size()), bgra(pixels.size());
+    BinaryManipulation::fromRGBA8888<BinaryManipulation::RGB10A2>(pixels, tenBit);
+    BinaryManipulation::convertPixels<BinaryManipulation::RGB10A2, BinaryManipulation::BGRA8888>(tenBit, bgra);
+    if (tenBit[0] != 0xFFFF'FFFF || bgra[1] != 0xAA10'2040 || bgra[3] != 0x55FF'00FF) {
+        std::cout << "Bad RGB10A2 conversion" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+template<std::size_t k>
+bool checkKmers(const BinaryManipulation::NucleotideSequence& sequence, const std::string& upper) {
+    bool kmersMatch = true;
+    std::size_t kmerCount = 0;
+    sequence.forEachKmer<k>([&](std::size_t position, uint64_t kmer) {
+        uint64_t manual = 0;
+        for (std::size_t j = 0; j < k; ++j) {
+            manual = (manual << 2) | static_cast<uint64_t>(BinaryManipulation::asciiToNucleotide(upper[position + j]));
+        }
+        kmersMatch = kmersMatch && (manual == kmer);
+        ++kmerCount;
+    });
+    return kmersMatch && kmerCount == (upper.size() - k + 1);
+}
+void test12() {
+    std::cout << "Simple test 12: Two bit packed nucleotides" << std::endl;
+    std::string text;
+    uint32_t state = 12345;
+    for (int i = 0; i < 1001; ++i) {
+        state = state * 1103515245 + 12345;
+        text += "ACGTacgt"[(state >> 16) % 8];
+    }
+    BinaryManipulation::NucleotideSequence sequence;
+    if (sequence.assign("ACGTN") || !sequence.assign(text) || sequence.size() != text.size()) {
+        std::cout << "Bad validation" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::string upper(text);
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](char c) { return static_cast<char>(std::toupper(c)); });
+    if (sequence.toString() != upper) {
+        std::cout << "Bad pack/unpack round trip" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::string expected(upper.rbegin(), upper.rend());
+    for (auto& c : expected) {
+        c = c == 'A' ? 'T' : c == 'T' ? 'A' : c == 'C' ? 'G' : 'C';
+    }
+    if (sequence.reverseComplement().toString() != expected) {
+        std::cout << "Bad reverse complement" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (sequence.gcCount() != static_cast<std::size_t>(std::count_if(upper.begin(), upper.end(), [](char c) { return c == 'G' || c == 'C'; }))) {
+        std::cout << "Bad GC count" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // 32 is the widest k-mer, a full uint64_t
+    if (!checkKmers<5>(sequence, upper) || !checkKmers<32>(sequence, upper)) {
+        std::cout << "Bad k-mers" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test13() {
+    std::cout << "Simple test 13: UTF-8 validation and transcoding" << std::endl;
+    std::vector<char32_t> codePoints;
+    uint32_t state = 4321;
+    for (int i = 0; i < 2000; ++i) {
+        state = state * 1103515245 + 12345;
+        switch ((state >> 16) % 5) {
+            case 0: codePoints.push_back(0x80 + (state >> 8) % 0x780); break;
+            case 1: codePoints.push_back(0xE000 + (state >> 8) % 0x2000); break;
+            case 2: codePoints.push_back(0x1'0000 + (state >> 4) % 0x10'0000); break;
+            default:
+                for (int j = 0; j < 20; ++j) {
+                    codePoints.push_back(U'a' + j);
+                }
+                break;
+        }
+    }
+    std::vector<uint8_t> encoded(codePoints.size() * 4);
+    auto toUtf8 = BinaryManipulation::utf32ToUtf8(codePoints, encoded);
+    encoded.resize(toUtf8.produced);
+    std::vector<char32_t> decoded(codePoints.size());
+    auto toUtf32 = BinaryManipulation::utf8ToUtf32(encoded, decoded);
+    if (!toUtf8.valid || !toUtf32.valid || toUtf32.produced != codePoints.size() || decoded != codePoints ||
+        !BinaryManipulation::isValidUtf8(encoded)) {
+        std::cout << "Bad round trip" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    const std::string padding(20, 'x');
+    for (auto bad : { "\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\x80", "\xE2\x82", "\xF8\x88\x80\x80\x80" }) {
+        if (BinaryManipulation::isValidUtf8(padding + bad) || BinaryManipulation::isValidUtf8(padding + bad + padding) ||
+            BinaryManipulation::isValidUtf8(bad + padding)) {
+            std::cout << "Accepted invalid sequence" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    // the vector and scalar validators must agree on every corrupted buffer
+    for (int i = 0; i < 4000; ++i) {
+        state = state * 1103515245 + 12345;
+        std::vector<uint8_t> corrupted(encoded.begin(), encoded.begin() + 64 + (state >> 16) % 64);
+        corrupted[(state >> 8) % corrupted.size()] ^= static_cast<uint8_t>(1u << ((state >> 20) % 8));
+        if (BinaryManipulation::isValidUtf8(corrupted) != BinaryManipulation::Utf8::isValidScalar(corrupted)) {
+            std::cout << "Validators disagree" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    char32_t surrogate[] { U'a', 0xD800 };
+    uint8_t small[8];
+    if (auto result = BinaryManipulation::utf32ToUtf8(surrogate, small); result.valid || result.consumed != 1) {
+        std::cout << "Encoded a surrogate" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+template<typename T>
+bool checkHexRoundTrip(const std::vector<T>& words) noexcept {
+    std::string text(BinaryManipulation::hexEncodedLength<T>(words.size()), ' ');
+    std::vector<T> parsed(words.size());
+    BinaryManipulation::hexEncode<T>(words, text, std::is_same_v<T, uint16_t>);
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        char expected[32];
+        std::snprintf(expected, sizeof(expected), std::is_same_v<T, uint16_t> ? "%0*llX" : "%0*llx",
+                static_cast<int>(BinaryManipulation::HexDigitsPerWord<T>), static_cast<unsigned long long>(words[i]));
+        if (text.compare(i * BinaryManipulation::HexDigitsPerWord<T>, BinaryManipulation::HexDigitsPerWord<T>, expected) != 0) {
+            return false;
+        }
+    }
+    auto decoded = BinaryManipulation::hexDecode<T>(text, parsed);
+    return decoded && *decoded == words.size() && parsed == words;
+}
+void test14() {
+    std::cout << "Simple test 14: Hex and base64 codecs" << std::endl;
+    std::vector<uint64_t> source(67);
+    uint64_t state = 0x1234'5678'9ABC'DEF0ull;
+    for (auto& value : source) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        value = state;
+    }
+    std::vector<uint8_t> bytes(source.size());
+    std::vector<uint16_t> halves(source.size());
+    std::vector<uint32_t> words(source.size());
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(source[i] >> 56);
+        halves[i] = static_cast<uint16_t>(source[i] >> 48);
+        words[i] = static_cast<uint32_t>(source[i] >> 32);
+    }
+    if (!checkHexRoundTrip(bytes) || !checkHexRoundTrip(halves) || !checkHexRoundTrip(words) || !checkHexRoundTrip(source)) {
+        std::cout << "Bad hex round trip" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    uint32_t parsed[4];
+    if (BinaryManipulation::hexDecode<uint32_t>("0123456789abcdefDEADBEEFcafeg00d", parsed) ||
+        BinaryManipulation::hexDecode<uint32_t>("DEADbeef", parsed).value_or(0) != 1 || parsed[0] != 0xDEAD'BEEF) {
+        std::cout << "Bad hex validation" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::string encoded;
+    if (encoded.resize(BinaryManipulation::base64EncodedLength(6)); BinaryManipulation::base64Encode(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>("foobar"), 6), encoded) != 8 || encoded != "Zm9vYmFy") {
+        std::cout << "Bad base64 encoding" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    auto raw = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(source.data()), source.size() * sizeof(uint64_t));
+    for (std::size_t length = 0; length < 100; ++length) {
+        auto input = raw.subspan(length, raw.size() - (length * 3));
+        encoded.assign(BinaryManipulation::base64EncodedLength(input.size()), ' ');
+        std::vector<uint8_t> decoded(BinaryManipulation::base64DecodedLength(encoded.size()));
+        BinaryManipulation::base64Encode(input, encoded);
+        auto count = BinaryManipulation::base64Decode(encoded, decoded);
+        if (!count || *count != input.size() || !std::equal(input.begin(), input.end(), decoded.begin())) {
+            std::cout << "Bad base64 round trip of " << std::dec << input.size() << " bytes" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+        encoded[(length * 7) % (encoded.size() - 4)] = '*';
+        if (BinaryManipulation::base64Decode(encoded, decoded)) {
+            std::cout << "Accepted invalid base64" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test15() {
+    std::cout << "Simple test 15: Allocation free field formatting" << std::endl;
+    using Ordinal = uint32_t;
+    using StandardOpcodePattern = BinaryManipulation::HighestQuarterPattern<Ordinal>;
+    using ExtendedOpcodePattern = BinaryManipulation::Pattern<Ordinal, uint16_t, 0b111'1000'0000, 7>;
+    using OpcodeExtraction = BinaryManipulation::Description<Ordinal, StandardOpcodePattern, ExtendedOpcodePattern>;
+    using WithFlag = BinaryManipulation::Description<Ordinal, OpcodeExtraction, BinaryManipulation::Flag<Ordinal, 0>>;
+    auto check = [](auto format, bool annotate, std::string_view expected, auto layout) noexcept {
+        using Layout = typename decltype(layout)::type;
+        char buffer[BinaryManipulation::FormattedLengthBound<Layout>];
+        auto result = BinaryManipulation::toChars<Layout>(buffer, 0x8C00'0381, format, annotate);
+        return result.ec == std::errc { } && std::string_view(buffer, result.ptr - buffer) == expected;
+    };
+    if (!check(BinaryManipulation::FieldFormat::Hex, false, "0x8c 0x7", std::type_identity<OpcodeExtraction> { }) ||
+        !check(BinaryManipulation::FieldFormat::Hex, true, "[31:24]=0x8c [10:7]=0x7", std::type_identity<OpcodeExtraction> { }) ||
+        !check(BinaryManipulation::FieldFormat::Binary, false, "0b10001100 0b0111", std::type_identity<OpcodeExtraction> { }) ||
+        !check(BinaryManipulation::FieldFormat::Decimal, false, "{ 140 7 } 1", std::type_identity<WithFlag> { }) ||
+        !check(BinaryManipulation::FieldFormat::Hex, true, "[0:0]=0x1", std::type_identity<BinaryManipulation::Flag<Ordinal, 0>> { })) {
+        std::cout << "Bad formatted output" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    char small[6];
+    if (BinaryManipulation::toChars<OpcodeExtraction>(small, 0x8C00'0381).ec != std::errc::value_too_large) {
+        std::cout << "Overflowed a small buffer" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    char storage[24];
+    BinaryManipulation::FormatBuffer out(storage);
+    if (!out.writeHex(0x8C00'0381, 8) || !out.write(':') || !out.write<OpcodeExtraction>(0x8C00'0381) ||
+        out.write<OpcodeExtraction>(0x8C00'0381, BinaryManipulation::FieldFormat::Binary) || out.view() != "8c000381:0x8c 0x7") {
+        std::cout << "Bad format buffer" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test16() {
+    std::cout << "Simple test 16: Bulk hex token parsing" << std::endl;
+    std::vector<uint32_t> expected;
+    std::string text;
+    uint32_t state = 0xC0FFEE;
+    for (int i = 0; i < 3000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        auto value = state >> (state % 29);
+        expected.push_back(value);
+        char token[32];
+        // mix fixed width, minimal width, prefixed, and upper case tokens with assorted separators
+        switch (i % 4) {
+            case 0: std::snprintf(token, sizeof(token), "%08x ", value); break;
+            case 1: std::snprintf(token, sizeof(token), "%x,", value); break;
+            case 2: std::snprintf(token, sizeof(token), "0x%X\n", value); break;
+            default: std::snprintf(token, sizeof(token), "%X \t\r\n  ", value); break;
+        }
+        text += token;
+    }
+    std::vector<uint32_t> parsed(expected.size() + 1);
+    auto result = BinaryManipulation::parseHexTokens<uint32_t>(text, parsed);
+    parsed.pop_back();
+    if (!result.valid || result.produced != expected.size() || result.consumed != text.size() || parsed != expected) {
+        std::cout << "Bad token parse" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    uint64_t wide[3];
+    if (auto r = BinaryManipulation::parseHexTokens<uint64_t>("  0123456789abcdef ffffffffffffffff 7", wide);
+            !r.valid || r.produced != 3 || wide[0] != 0x0123'4567'89AB'CDEFull || wide[1] != ~0ull || wide[2] != 7) {
+        std::cout << "Bad 64-bit parse" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (auto r = BinaryManipulation::parseHexTokens<uint32_t>("12 123456789 3", parsed); r.valid || r.produced != 1 || r.consumed != 3) {
+        std::cout << "Accepted an over long token" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (auto r = BinaryManipulation::parseHexTokens<uint32_t>("12 34 5g 78", parsed); r.valid || r.produced != 2) {
+        std::cout << "Accepted a bad digit" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::vector<BinaryManipulation::i960::OpcodeExtraction::SliceType> fields(expected.size());
+    result = BinaryManipulation::parseHexFields<BinaryManipulation::i960::OpcodeExtraction>(text, fields);
+    if (!result.valid || result.produced != expected.size()) {
+        std::cout << "Bad fused parse" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (fields[i] != BinaryManipulation::i960::OpcodeExtraction::decode(expected[i])) {
+            std::cout << "Bad fused fields at " << std::dec << i << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+std::vector<uint8_t> makeFrame(uint8_t protocol, uint8_t tcpFlags, std::size_t payloadLength, bool vlan) {
+    std::vector<uint8_t> frame(12, 0xEE);
+    auto put16 = [&frame](uint16_t value) { frame.push_back(value >> 8); frame.push_back(value & 0xFF); };
+    auto put32 = [&put16](uint32_t value) { put16(value >> 16); put16(value & 0xFFFF); };
+    if (vlan) {
+        put16(0x8100);
+        put16(42);
+    }
+    put16(0x0800);
+    auto transportLength = protocol == 6 ? 20 : 8;
+    // version 4, 5 words, DSCP 46 (EF), ECN 1, don't fragment
+    put32(0x45B9'0000 | (20 + transportLength + payloadLength));
+    put32(0x1234'4000);
+    put32(0x40'00'0000 | (protocol << 16));
+    put32(0xC0A8'0001);
+    put32(0x0A00'0002);
+    if (protocol == 6) {
+        put32(0x1F90'0050);
+        put32(1000);
+        put32(2000);
+        put32(0x5000'0100 | (tcpFlags << 16));
+        put32(0);
+    } else {
+        put32(0x0035'D431);
+        put32(((8 + payloadLength) << 16));
+    }
+    frame.insert(frame.end(), payloadLength, 0xAB);
+    return frame;
+}
+void test17() {
+    namespace Network = BinaryManipulation::Network;
+    std::cout << "Simple test 17: Network headers and capture files" << std::endl;
+    std::vector<uint8_t> capture;
+    BinaryManipulation::writePcapHeader(capture, BinaryManipulation::PcapLinkType::Ethernet);
+    auto syn = makeFrame(6, 0b0000'0010, 0, false);
+    auto ack = makeFrame(6, 0b0001'0000, 100, true);
+    auto udp = makeFrame(17, 0, 33, false);
+    // a minimum size frame is padded past the IPv4 total length
+    udp.insert(udp.end(), 7, 0);
+    BinaryManipulation::writePcapRecord(capture, 1, 10, syn);
+    BinaryManipulation::writePcapRecord(capture, 2, 20, ack);
+    BinaryManipulation::writePcapRecord(capture, 3, 30, udp);
+    capture.resize(capture.size() + 5);
+    BinaryManipulation::PcapReader reader(capture);
+    std::vector<Network::DecodedPacket> packets;
+    for (const auto& packet : reader) {
+        packets.push_back(Network::decodeEthernet(packet.data));
+    }
+    if (!reader.valid() || reader.linkType() != BinaryManipulation::PcapLinkType::Ethernet || packets.size() != 3) {
+        std::cout << "Bad capture file" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    auto [version, headerLength, dscp, ecn, totalLength] = Network::IPv4::ServiceRow::decode(packets[0].ip);
+    if (version != 4 || headerLength != 5 || dscp != 46 || ecn != 1 || totalLength != 40 ||
+        !Network::IPv4::DontFragment::decode(packets[0].ip) || Network::IPv4::Identification::decode(packets[0].ip) != 0x1234 ||
+        Network::IPv4::SourceAddress::decode(packets[0].ip) != 0xC0A8'0001 || Network::IPv4::TimeToLive::decode(packets[0].ip) != 64) {
+        std::cout << "Bad IPv4 header" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (!Network::TCP::SYN::decode(packets[0].transport) || Network::TCP::ACK::decode(packets[0].transport) ||
+        !Network::TCP::ACK::decode(packets[1].transport) || packets[1].payload.size() != 100 ||
+        Network::TCP::DestinationPort::decode(packets[1].transport) != 80 || Network::TCP::SequenceNumber::decode(packets[1].transport) != 1000 ||
+        Network::TCP::Window::decode(packets[1].transport) != 0x100) {
+        std::cout << "Bad TCP header" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (packets[2].protocol != Network::IPv4::ProtocolUDP || packets[2].payload.size() != 33 ||
+        Network::UDP::SourcePort::decode(packets[2].transport) != 53 || Network::UDP::Length::decode(packets[2].transport) != 41) {
+        std::cout << "Bad UDP header" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // a capture written on a big endian host
+    std::vector<uint8_t> swapped(capture.begin(), capture.begin() + BinaryManipulation::PcapFileHeaderLength + BinaryManipulation::PcapRecordHeaderLength + syn.size());
+    for (std::size_t offset : { 0, 8, 12, 16, 20, 24, 28, 32, 36 }) {
+        auto value = BinaryManipulation::loadFromBytes<uint32_t>(swapped.data() + offset, std::endian::big);
+        std::memcpy(swapped.data() + offset, &value, sizeof(value));
+    }
+    std::swap(swapped[4], swapped[5]);
+    std::swap(swapped[6], swapped[7]);
+    BinaryManipulation::PcapReader bigEndian(swapped);
+    if (!bigEndian.valid() || bigEndian.byteOrder() != std::endian::big || std::distance(bigEndian.begin(), bigEndian.end()) != 1 ||
+        bigEndian.begin()->seconds != 1 || bigEndian.begin()->data.size() != syn.size()) {
+        std::cout << "Bad big endian capture" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+std::vector<uint8_t> makeBigEndianElf32() {
+    // header, .shstrtab, .strtab, .symtab, .rel.text, then the section headers
+    std::vector<uint8_t> image { 0x7F, 'E', 'L', 'F', 1, 2, 1 };
+    image.resize(52);
+    auto put16At = [&image](std::size_t offset, uint16_t value) { image[offset] = value >> 8; image[offset + 1] = value & 0xFF; };
+    auto put32At = [&](std::size_t offset, uint32_t value) { put16At(offset, value >> 16); put16At(offset + 2, value & 0xFFFF); };
+    auto append = [&image](std::string_view text) { auto offset = image.size(); image.insert(image.end(), text.begin(), text.end()); return offset; };
+    put16At(16, 1);
+    put16At(18, 3);
+    auto sectionNames = append(std::string_view("\0.shstrtab\0.strtab\0.symtab\0.rel.text\0", 38));
+    auto strings = append(std::string_view("\0start\0counter\0", 15));
+    auto symbols = image.size();
+    image.resize(symbols + (16 * 3));
+    // null, start (global function), counter (local object)
+    put32At(symbols + 16, 1);
+    put32At(symbols + 20, 0x1000);
+    put32At(symbols + 24, 64);
+    image[symbols + 28] = 0x12;
+    put16At(symbols + 30, 1);
+    put32At(symbols + 32, 7);
+    put32At(symbols + 36, 0x2000);
+    put32At(symbols + 40, 4);
+    image[symbols + 44] = 0x01;
+    image[symbols + 45] = 0x02;
+    put16At(symbols + 46, 2);
+    auto relocations = image.size();
+    image.resize(relocations + 8);
+    put32At(relocations, 0x1004);
+    put32At(relocations + 4, (2 << 8) | 0x15);
+    auto headers = image.size();
+    image.resize(headers + (40 * 5));
+    auto section = [&](std::size_t index, uint32_t name, uint32_t type, uint32_t offset, uint32_t size, uint32_t link, uint32_t flags) {
+        auto base = headers + (index * 40);
+        put32At(base, name);
+        put32At(base + 4, type);
+        put32At(base + 8, flags);
+        put32At(base + 16, offset);
+        put32At(base + 20, size);
+        put32At(base + 24, link);
+    };
+    section(1, 1, 3, sectionNames, 38, 0, 0);
+    section(2, 11, 3, strings, 15, 0, 0);
+    section(3, 19, 2, symbols, 48, 2, 0);
+    section(4, 27, 9, relocations, 8, 3, 0b110);
+    put32At(32, headers);
+    put16At(46, 40);
+    put16At(48, 5);
+    put16At(50, 1);
+    return image;
+}
+std::vector<uint8_t> makeLittleEndianElf64(std::size_t functions, bool withMain) {
+    // header, .shstrtab, .strtab, .symtab, then the section headers; the
+    // symbols are the given number of global functions and a local object
+    std::vector<uint8_t> image { 0x7F, 'E', 'L', 'F', 2, 1, 1 };
+    image.resize(64);
+    auto putAt = [&image](std::size_t offset, uint64_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; ++i) {
+            image[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+        }
+    };
+    auto append = [&image](std::string_view text) { auto offset = image.size(); image.insert(image.end(), text.begin(), text.end()); return offset; };
+    putAt(16, 2, 2);
+    putAt(18, 62, 2);
+    auto sectionNames = append(std::string_view("\0.shstrtab\0.strtab\0.symtab\0", 27));
+    auto strings = append(std::string_view("\0main\0helper\0table\0", 19));
+    auto symbols = image.size();
+    auto symbolCount = functions + 2;
+    image.resize(symbols + (24 * symbolCount));
+    for (std::size_t i = 1; i <= functions; ++i) {
+        auto base = symbols + (i * 24);
+        putAt(base, (i == 1 && withMain) ? 1 : 6, 4);
+        image[base + 4] = 0x12;
+        putAt(base + 6, 1, 2);
+        putAt(base + 8, 0x40'1000 + (i * 0x100), 8);
+        putAt(base + 16, 0x80, 8);
+    }
+    auto object = symbols + ((functions + 1) * 24);
+    putAt(object, 13, 4);
+    image[object + 4] = 0x01;
+    putAt(object + 6, 2, 2);
+    putAt(object + 16, 8, 8);
+    auto headers = image.size();
+    image.resize(headers + (64 * 4));
+    auto section = [&](std::size_t index, uint32_t name, uint32_t type, uint64_t offset, uint64_t size, uint32_t link, uint64_t entrySize) {
+        auto base = headers + (index * 64);
+        putAt(base, name, 4);
+        putAt(base + 4, type, 4);
+        putAt(base + 24, offset, 8);
+        putAt(base + 32, size, 8);
+        putAt(base + 40, link, 4);
+        putAt(base + 56, entrySize, 8);
+    };
+    section(1, 1, 3, sectionNames, 27, 0, 0);
+    section(2, 11, 3, strings, 19, 0, 0);
+    section(3, 19, 2, symbols, 24 * symbolCount, 2, 24);
+    putAt(40, headers, 8);
+    putAt(58, 64, 2);
+    putAt(60, 4, 2);
+    putAt(62, 1, 2);
+    return image;
+}
+void test18() {
+    namespace Elf = BinaryManipulation::Elf;
+    std::cout << "Simple test 18: ELF image reader" << std::endl;
+    auto bytes = makeBigEndianElf32();
+    Elf::Image image(bytes);
+    if (!image.valid() || image.is64Bit() || image.byteOrder() != std::endian::big || image.sectionCount() != 5 || image.machine() != 3) {
+        std::cout << "Bad ELF header" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    auto symbolTable = image.findSection(".symtab");
+    auto relocationTable = image.findSection(".rel.text");
+    if (!symbolTable || !relocationTable || !Elf::SectionExecute::decode(relocationTable->flags) || Elf::SectionWrite::decode(relocationTable->flags)) {
+        std::cout << "Bad sections" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    auto symbols = image.symbols(*symbolTable);
+    std::vector<Elf::Symbol> all(symbols.begin(), symbols.end());
+    if (all.size() != 3 || all[1].name != "start" || all[1].binding() != Elf::Binding::Global || all[1].type() != Elf::Type::Function ||
+        all[1].value != 0x1000 || all[2].name != "counter" || all[2].type() != Elf::Type::Object || Elf::SymbolVisibility::decode(all[2].other) != 2) {
+        std::cout << "Bad symbols" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    uint8_t info[3], bindings[3], types[3];
+    if (symbols.gatherInfo(info) != 3 || Elf::splitSymbolInfo(info, bindings, types) != 3 ||
+        bindings[1] != 1 || types[1] != 2 || bindings[2] != 0 || types[2] != 1) {
+        std::cout << "Bad symbol classification" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::vector<Elf::Relocation> relocations;
+    image.forEachRelocation(*relocationTable, [&relocations](const Elf::Relocation& relocation) noexcept { relocations.push_back(relocation); });
+    if (relocations.size() != 1 || relocations[0].offset != 0x1004 || relocations[0].symbol != 2 || relocations[0].type != 0x15) {
+        std::cout << "Bad relocations" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // scan little endian ELF64 images, mixed with files that are not ELF at all
+    auto directory = std::filesystem::temp_directory_path();
+    std::vector<std::filesystem::path> images { directory / "BinaryManipulatorTest0.elf", directory / "BinaryManipulatorTest1.elf" };
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        auto elf = makeLittleEndianElf64(2 + (i * 3), i == 0);
+        std::ofstream(images[i], std::ios::binary).write(reinterpret_cast<const char*>(elf.data()), static_cast<std::streamsize>(elf.size()));
+    }
+    std::vector<std::filesystem::path> paths;
+    for (std::size_t i = 0; i < 64; ++i) {
+        paths.push_back(i % 4 == 3 ? std::filesystem::path("/dev/null") : images[i % 2]);
+    }
+    auto counts = Elf::scanFiles(paths, [](const std::filesystem::path&, const Elf::Image& image) noexcept {
+        Elf::SymbolHistogram histogram { };
+        if (auto table = image.findSection(".symtab"); table && image.is64Bit() && image.byteOrder() == std::endian::little) {
+            Elf::countSymbolKinds(image.symbols(*table), histogram);
+        }
+        return Elf::countOf(histogram, Elf::Binding::Global, Elf::Type::Function);
+    }, 2);
+    // a predicate scan returns bools, which the workers write side by side
+    auto hasMain = Elf::scanFiles(paths, [](const std::filesystem::path&, const Elf::Image& image) noexcept {
+        if (auto table = image.findSection(".symtab"); table) {
+            for (const auto& symbol : image.symbols(*table)) {
+                if (symbol.name == "main" && symbol.type() == Elf::Type::Function) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }, 4);
+    for (const auto& path : images) {
+        std::filesystem::remove(path);
+    }
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        auto expectedCount = i % 4 == 3 ? 0 : (i % 2 == 0 ? 2 : 5);
+        if (counts.size() != paths.size() || hasMain.size() != paths.size() || counts[i] != static_cast<std::size_t>(expectedCount) ||
+            hasMain[i] != (i % 4 == 0 || i % 4 == 2)) {
+            std::cout << "Bad scan of file " << i << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test19() {
+    namespace i960 = BinaryManipulation::i960;
+    std::cout << "Simple test 19: i960 decoding and disassembly" << std::endl;
+    const std::vector<i960::Ordinal> program {
+        0x8C80'3000, 0x0000'1234, // lda 0x1234, g0
+        0x5C88'0E10, // mov 16, g1
+        0x5994'4010, // addo g0, g1, g2
+        0x3290'DFF0, // cmpobe g2, r3, 0x1000
+        0x9291'3D05, 0x0000'0008, // st g2, 0x8(r4)[r5*4]
+        0x0A00'0000, // ret
+        0x0000'0000,
+    };
+    std::vector<i960::Instruction> decoded(program.size());
+    auto [words, count] = i960::decodeInstructions(program, decoded);
+    const auto& store = decoded[4];
+    if (words != program.size() || count != 7 || decoded[0].length != 2 || decoded[0].displacement != 0x1234 ||
+        decoded[3].format != i960::Format::COBR || decoded[3].displacement != -16 ||
+        store.opcode != 0x920 || store.mode != i960::AddressingMode::AbaseIndexDisplacement || store.scale() != 2 ||
+        store.src1() != 5 || store.src2() != 4 || store.srcDest() != 18 || store.displacement != 8) {
+        std::cout << "Bad decode of " << count << " instructions from " << words << " words" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::vector<char> storage(4096);
+    BinaryManipulation::FormatBuffer out(storage);
+    constexpr std::string_view expected =
+        "00001000: 8c803000 00001234  lda       0x1234, g0\n"
+        "00001008: 5c880e10           mov       16, g1\n"
+        "0000100c: 59944010           addo      g0, g1, g2\n"
+        "00001010: 3290dff0           cmpobe    g2, r3, 0x1000\n"
+        "00001014: 92913d05 00000008  st        g2, 0x8(r4)[r5*4]\n"
+        "0000101c: 0a000000           ret\n"
+        "00001020: 00000000           .word     0x00000000\n";
+    if (i960::disassembleWords(program, 0x1000, out) != program.size() || out.view() != expected) {
+        std::cout << "Bad disassembly:" << std::endl << out.view();
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // the parallel disassembler must resolve instructions straddling chunks
+    std::vector<i960::Ordinal> image(100'003);
+    uint32_t state = 12345;
+    for (auto& word : image) {
+        state = (state * 1103515245u) + 12345u;
+        word = state;
+    }
+    image.back() = 0x0A00'0000;
+    std::vector<char> serialStorage(image.size() * i960::DisassemblyLineLength);
+    BinaryManipulation::FormatBuffer serial(serialStorage);
+    i960::disassembleWords(image, 0, serial);
+    for (unsigned threads : { 1u, 4u }) {
+        std::string parallel;
+        if (!i960::disassembleImage(image, 0, [&parallel](std::string_view text) { parallel.append(text); return true; }, threads, 999) ||
+            parallel != serial.view()) {
+            std::cout << "Parallel disassembly differs from serial disassembly" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    // the sink stopping early stops the whole pipeline
+    std::size_t calls = 0;
+    if (i960::disassembleImage(image, 0, [&calls](std::string_view) { return ++calls < 3; }, 2, 999) || calls != 3) {
+        std::cout << "Disassembly did not stop with the sink" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test20() {
+    namespace i960 = BinaryManipulation::i960;
+    using i960::g0; using i960::g1; using i960::g2; using i960::r3; using i960::r4; using i960::r5;
+    using i960::MemoryOperand;
+    std::cout << "Simple test 20: i960 instruction encoding" << std::endl;
+    const std::vector<i960::InstructionFields> program {
+        i960::mem("lda", g0, MemoryOperand::absolute(0x1234)),
+        i960::reg("mov", 16, g1),
+        i960::reg("addo", g0, g1, g2),
+        i960::cobr("cmpobe", g2, r3, -16),
+        i960::mem("st", g2, MemoryOperand::indexed(r4, r5, i960::Scale::By4, 8)),
+        i960::ctrl("ret"),
+    };
+    const std::vector<i960::Ordinal> expected { 0x8C80'3000, 0x0000'1234, 0x5C88'0E10, 0x5994'4010, 0x3290'DFF0, 0x9291'3D05, 0x0000'0008, 0x0A00'0000 };
+    std::vector<i960::Ordinal> words(i960::encodedLength(program));
+    auto [emitted, length] = i960::emitInstructions(program, words);
+    if (emitted != program.size() || length != expected.size() || words != expected) {
+        std::cout << "Bad encoding of " << emitted << " instructions into " << length << " words" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // a buffer one word short stops in front of the two word store
+    std::vector<i960::Ordinal> shortBuffer(6);
+    auto partial = i960::emitInstructions(program, shortBuffer);
+    if (partial.instructions != 4 || partial.words != 5) {
+        std::cout << "Bad partial emit of " << partial.instructions << " instructions" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (i960::Literal::checked(32) || !i960::Literal::checked(31) || i960::CtrlTarget::checked(6) || i960::CobrTarget::checked(4096) ||
+        !i960::RegOpcode::checked(0x590) || i960::RegOpcode::checked(0x920) || i960::MemOpcode::checked(0x930)) {
+        std::cout << "Bad runtime operand checks" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // decoding and encoding again reproduces any instruction with its reserved bits clear
+    std::vector<i960::Ordinal> image(50'000);
+    uint32_t state = 987654321;
+    for (auto& word : image) {
+        state = (state * 1103515245u) + 12345u;
+        word = state;
+    }
+    for (std::size_t i = 0; i < image.size(); i += i960::instructionLength(image[i])) {
+        if (i960::formatOf(image[i]) == i960::Format::CTRL) {
+            image[i] &= ~0b1u;
+        } else if (i960::formatOf(image[i]) == i960::Format::MEM && i960::MemTypeB::decode(image[i])) {
+            image[i] &= ~0b110'0000u;
+        }
+    }
+    image.back() = 0x0A00'0000;
+    std::vector<i960::Instruction> decoded(image.size());
+    auto [consumed, count] = i960::decodeInstructions(image, decoded);
+    std::vector<i960::InstructionFields> fields;
+    for (std::size_t i = 0; i < count; ++i) {
+        fields.push_back(i960::fieldsOf(decoded[i]));
+    }
+    std::vector<i960::Ordinal> reencoded(consumed);
+    i960::emitInstructions(fields, reencoded);
+    if (consumed != image.size() || reencoded != image) {
+        auto mismatch = std::mismatch(image.begin(), image.end(), reencoded.begin());
+        std::cout << "Round trip differs at word " << std::hex << *mismatch.first << " != " << *mismatch.second << std::dec << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test21() {
+    namespace i960 = BinaryManipulation::i960;
+    using i960::g0; using i960::g1; using i960::g2; using i960::g3; using i960::g4;
+    using i960::MemoryOperand;
+    std::cout << "Simple test 21: i960 interpreter" << std::endl;
+    const std::vector<i960::InstructionFields> program {
+        i960::reg("mov", 0, g0),
+        i960::reg("mov", 10, g1),
+        i960::reg("addo", g1, g0, g0), // 0x8
+        i960::reg("subo", 1, g1, g1),
+        i960::cobr("cmpibl", 0, g1, -8),
+        i960::mem("st", g0, MemoryOperand::absolute(0x100)),
+        i960::mem("ld", g2, MemoryOperand::absolute(0x100)),
+        i960::mem("lda", g3, MemoryOperand::absolute(0x7FFF'FFFF)),
+        i960::reg("addi", 1, g3, g4), // 0x24
+        i960::reg("fmark"),
+    };
+    std::vector<i960::Ordinal> words(i960::encodedLength(program));
+    i960::emitInstructions(program, words);
+    i960::Interpreter interpreter(16);
+    interpreter.load(words, 0);
+    interpreter.arithmeticControls().write(i960::IntegerOverflowMask::encode(0, true));
+    auto stop = interpreter.run(1000);
+    if (stop != i960::StopReason::Breakpoint || interpreter.reg(g0) != 55 || interpreter.reg(g2) != 55 || interpreter.executed() != 37 ||
+        interpreter.ip() != 0x2C || !interpreter.arithmeticControls().field<i960::IntegerOverflowFlag>() ||
+        !interpreter.traceControls().field<i960::BreakpointTraceEvent>()) {
+        std::cout << "Bad run, stopped with " << static_cast<int>(stop) << " after " << interpreter.executed() << " instructions" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // unmasked integer overflow faults
+    interpreter.arithmeticControls().write(0);
+    interpreter.ip() = 0x24;
+    if (interpreter.run(1000) != i960::StopReason::ArithmeticFault) {
+        std::cout << "Overflow did not fault" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // branch tracing stops after the taken branch
+    interpreter.traceControls().write(i960::BranchTraceMode::encode(0, true));
+    interpreter.ip() = 0x8;
+    interpreter.reg(g1) = 2;
+    if (interpreter.run(1000) != i960::StopReason::TraceFault || interpreter.ip() != 0x8 ||
+        !interpreter.traceControls().field<i960::BranchTraceEvent>() || interpreter.conditionCode() != i960::ConditionLess) {
+        std::cout << "Bad branch trace" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test22() {
+    std::cout << "Simple test 22: register file with cached fields" << std::endl;
+    using namespace BinaryManipulation;
+    i960::ControlRegisters controls(0x1000, 0, 0);
+    auto& ac = controls.get<i960::ArithmeticControls>();
+    if (!ac.field<i960::IntegerOverflowMask>() || ac.field<i960::ConditionCode>() != 0 || ac.dirty() != 0) {
+        std::cout << "Bad initial decode" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    auto saved = controls.snapshot();
+    // ConditionCode and IntegerOverflowFlag are fields 0 and 2
+    ac.setField<i960::ConditionCode>(i960::ConditionEqual);
+    ac.setField<i960::IntegerOverflowFlag>(true);
+    ac.setField<i960::IntegerOverflowMask>(true);
+    if (ac.raw() != 0x1102 || ac.field<i960::ConditionCode>() != i960::ConditionEqual || !ac.field<i960::IntegerOverflowFlag>() ||
+        ac.dirty() != 0b101 || !ac.isDirty<i960::IntegerOverflowFlag>() || ac.isDirty<i960::IntegerOverflowMask>()) {
+        std::cout << "Bad field update, raw " << std::hex << ac.raw() << " dirty " << ac.dirty() << std::dec << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    controls.get<2>().write(i960::BranchTraceMode::encode(0, true));
+    controls.get<i960::ProcessControls>().write(i960::ProcessPriority::encode(0, 31));
+    if (controls.get<i960::ProcessControls>().field<i960::ProcessPriority>() != 31 || controls.get<1>().dirty() != 0b10000) {
+        std::cout << "Bad register write" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (auto dirty = controls.takeDirty(); dirty[0] != 0b101 || dirty[1] != 0b10000 || dirty[2] != 0b10 || ac.dirty() != 0) {
+        std::cout << "Bad dirty masks" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // restoring marks exactly what it changed back
+    controls.restore(saved);
+    if (controls.snapshot() != saved || ac.field<i960::ConditionCode>() != 0 || !ac.field<i960::IntegerOverflowMask>() ||
+        ac.dirty() != 0b101 || controls.get<2>().field<i960::BranchTraceMode>() || controls.get<2>().dirty() != 0b10) {
+        std::cout << "Bad restore" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    static_assert(CachedRegister<i960::ArithmeticControls>::changedFields(0, 0x8078) == 0b10010);
+    std::cout << "Passed!" << std::endl;
+}
+void test23() {
+    std::cout << "Simple test 23: streaming i960 decode" << std::endl;
+    using namespace BinaryManipulation;
+    std::vector<i960::Ordinal> words(10000);
+    uint32_t state = 0x1234'5678;
+    for (auto& word : words) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        word = state;
+    }
+    // the boundary pass against walking the lengths one at a time
+    uint64_t carry = 0;
+    std::size_t expectedStart = 0;
+    for (std::size_t base = 0; base + 64 <= words.size(); base += 64) {
+        std::span<const i960::Ordinal> block(words.data() + base, 64);
+        auto longMask = i960::longInstructionMask(block);
+        auto starts = i960::instructionStartMask(longMask, carry);
+        for (std::size_t i = 0; i < 64; ++i) {
+            auto isStart = (base + i) == expectedStart;
+            if (((longMask >> i) & 1) != (i960::instructionLength(block[i]) == 2) || ((starts >> i) & 1) != isStart) {
+                std::cout << "Bad boundary at word " << (base + i) << std::endl;
+                std::cout << "Failure!" << std::endl;
+                return;
+            }
+            if (isStart) {
+                expectedStart += i960::instructionLength(block[i]);
+            }
+        }
+    }
+    std::vector<i960::Instruction> expected(words.size());
+    auto [consumed, count] = i960::decodeInstructions(words, expected);
+    // uneven pieces so that two word instructions get split between calls
+    for (std::size_t piece : { std::size_t { 1 }, std::size_t { 3 }, std::size_t { 64 }, std::size_t { 77 }, words.size() }) {
+        i960::StreamDecoder decoder;
+        i960::InstructionBuffer buffer;
+        for (std::size_t position = 0; position < consumed; position += piece) {
+            decoder.decode(std::span<const i960::Ordinal>(words).subspan(position, std::min(piece, consumed - position)), buffer);
+        }
+        if (buffer.size() != count || decoder.pending() || decoder.position() != consumed) {
+            std::cout << "Pieces of " << piece << " decoded " << buffer.size() << " instructions instead of " << count << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+        i960::Ordinal position = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            auto decoded = buffer[i];
+            if (decoded.word != expected[i].word || decoded.displacement != expected[i].displacement || decoded.opcode != expected[i].opcode ||
+                decoded.mode != expected[i].mode || decoded.flags != expected[i].flags || decoded.length != expected[i].length ||
+                buffer.positions()[i] != position) {
+                std::cout << "Pieces of " << piece << " mismatch at instruction " << i << std::endl;
+                std::cout << "Failure!" << std::endl;
+                return;
+            }
+            position += decoded.length;
+        }
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test24() {
+    std::cout << "Simple test 24: software MMU" << std::endl;
+    using namespace BinaryManipulation;
+    using Pte = PageTableEntry32;
+    std::vector<uint8_t> memory(0x10000);
+    auto setEntry = [&memory](uint32_t address, uint32_t value) { std::memcpy(memory.data() + address, &value, sizeof(value)); };
+    auto entryAt = [&memory](uint32_t address) { return loadFromBytes<uint32_t>(memory.data() + address); };
+    // root table at 0x1000, directory slot 1 points at the table at 0x2000
+    setEntry(0x1000 + 1 * 4, Pte::Layout::encode(true, true, true, false, false, 0x2));
+    setEntry(0x2000 + 0 * 4, Pte::Layout::encode(true, true, true, false, false, 0x5));
+    setEntry(0x2000 + 1 * 4, Pte::Layout::encode(true, false, true, false, false, 0x6));
+    setEntry(0x2000 + 2 * 4, Pte::Layout::encode(true, true, false, false, false, 0x7));
+    Mmu<TwoLevel32, Pte> mmu(memory, 0x1000);
+    using namespace AccessFlags;
+    auto expect = [&mmu](uint32_t address, uint8_t access, uint32_t physical, TranslationFault fault) {
+        auto result = mmu.translate(address, access);
+        if (result.fault != fault || (fault == TranslationFault::None && result.address != physical)) {
+            std::cout << "Translating " << std::hex << address << " gave " << result.address << std::dec << " fault " << static_cast<int>(result.fault) << std::endl;
+            return false;
+        }
+        return true;
+    };
+    if (!expect(0x0040'0123, Read | User, 0x5123, TranslationFault::None) || !expect(0x0040'0FFF, Read | User, 0x5FFF, TranslationFault::None) ||
+        mmu.statistics().hits != 1 || mmu.statistics().misses != 1) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // the first write walks again to set the dirty bit
+    if (!expect(0x0040'0010, Write | User, 0x5010, TranslationFault::None) || mmu.statistics().misses != 2 ||
+        !Pte::Dirty::decode(entryAt(0x2000)) || !Pte::Accessed::decode(entryAt(0x2000)) || !Pte::Accessed::decode(entryAt(0x1004)) ||
+        !expect(0x0040'0020, Write | User, 0x5020, TranslationFault::None) || mmu.statistics().hits != 2) {
+        std::cout << "Bad accessed and dirty tracking" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    if (!expect(0x0040'1000, Write | User, 0, TranslationFault::Protection) || !expect(0x0040'1004, Read | User, 0x6004, TranslationFault::None) ||
+        !expect(0x0040'2000, Read | User, 0, TranslationFault::Protection) || !expect(0x0040'2008, Write, 0x7008, TranslationFault::None) ||
+        !expect(0x0080'0000, Read, 0, TranslationFault::NotPresent) || Pte::Dirty::decode(entryAt(0x2004))) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // remapping only shows up once the old translation is invalidated
+    setEntry(0x2000, Pte::Layout::encode(true, true, true, false, false, 0x8));
+    if (!expect(0x0040'0004, Read, 0x5004, TranslationFault::None)) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    mmu.invalidate(0x0040'0000);
+    if (!expect(0x0040'0004, Read, 0x8004, TranslationFault::None)) {
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::vector<uint32_t> trace { 0x0040'0000, 0x0040'0004, 0x0040'1008, 0x0040'2010, 0x0040'0FF0, 0x0080'0000, 0x0040'0000 };
+    std::vector<uint32_t> physical(trace.size());
+    auto fault = TranslationFault::None;
+    auto before = mmu.statistics();
+    auto translated = mmu.translate(trace, physical, Read, fault);
+    // the second address shares the first one's page and skips the TLB, the rest (fault included) are looked up
+    auto after = mmu.statistics();
+    if (translated != 5 || fault != TranslationFault::NotPresent || physical[1] != 0x8004 || physical[2] != 0x6008 ||
+        physical[3] != 0x7010 || physical[4] != 0x8FF0 || (after.runHits - before.runHits) != 1 ||
+        ((after.hits + after.misses) - (before.hits + before.misses)) != 5) {
+        std::cout << "Bad batch translation, " << translated << " translated" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // four levels over 64-bit addresses, tables at 0x1000 to 0x4000
+    using Pte64 = PageTableEntry64;
+    constexpr uint64_t Virtual = 0x0000'7F12'3456'7ABC;
+    std::vector<uint8_t> memory64(0x10000);
+    auto setEntry64 = [&memory64](uint64_t address, uint64_t value) { std::memcpy(memory64.data() + address, &value, sizeof(value)); };
+    setEntry64(0x1000 + FourLevel48::Index<0>::decode(Virtual) * 8, Pte64::Layout::encode(true, true, false, false, false, 0x2));
+    setEntry64(0x2000 + FourLevel48::Index<1>::decode(Virtual) * 8, Pte64::Layout::encode(true, true, false, false, false, 0x3));
+    setEntry64(0x3000 + FourLevel48::Index<2>::decode(Virtual) * 8, Pte64::Layout::encode(true, true, false, false, false, 0x4));
+    setEntry64(0x4000 + FourLevel48::Index<3>::decode(Virtual) * 8, Pte64::Layout::encode(true, true, false, false, false, 0xF));
+    Mmu<FourLevel48, Pte64> mmu64(memory64, 0x1000);
+    if (auto result = mmu64.translate(Virtual, Write); result.fault != TranslationFault::None || result.address != 0xFABC ||
+            mmu64.translate(Virtual + 0x1000, Read).fault != TranslationFault::NotPresent) {
+        std::cout << "Bad four level translation" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test25() {
+    std::cout << "Simple test 25: cache simulator" << std::endl;
+    using namespace BinaryManipulation;
+    // A through E all land in set 0 of a two set, four way cache
+    constexpr uint32_t A = 0x000, B = 0x020, C = 0x040, D = 0x060, E = 0x080;
+    auto replay = [](auto& hierarchy, std::initializer_list<uint32_t> addresses) {
+        for (auto address : addresses) {
+            hierarchy.access(address, false);
+        }
+        return hierarchy.statistics().levels[0].hits;
+    };
+    // LRU evicts B for E, the PLRU tree points at C instead
+    CacheHierarchy<Cache<uint32_t, 16, 2, 4, Replacement::LRU>> lru;
+    CacheHierarchy<Cache<uint32_t, 16, 2, 4, Replacement::PLRU>> plru;
+    if (replay(lru, { A, B, C, D, A, E, B }) != 1 || replay(plru, { A, B, C, D, A, E, B }) != 2 ||
+        replay(lru, { D }) != 2 || replay(plru, { D }) != 3) {
+        std::cout << "Bad replacement, LRU hits " << lru.statistics().levels[0].hits << " PLRU hits " << plru.statistics().levels[0].hits << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    lru.reset();
+    lru.access(A, true);
+    replay(lru, { B, C, D, E });
+    if (lru.statistics().levels[0].writebacks != 1 || lru.statistics().memoryWrites != 1 || lru.statistics().memoryReads != 5) {
+        std::cout << "Bad write back" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // a hot region and scattered accesses, sharded runs must match the serial one
+    std::vector<MemoryAccess<uint64_t>> trace(200000);
+    uint64_t state = 0x9E37'79B9'7F4A'7C15;
+    for (auto& entry : trace) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        entry.address = (state & 0x100) ? (state >> 20) & 0x7FFF : (state >> 16) & 0xFF'FFFF;
+        entry.write = (state & 0x7) == 0;
+    }
+    using Hierarchy = CacheHierarchy<Cache<uint64_t, 64, 64, 8>, Cache<uint64_t, 64, 512, 16, Replacement::PLRU>>;
+    auto serial = std::make_unique<Hierarchy>();
+    serial->run(trace);
+    auto& counts = serial->statistics();
+    if (counts.levels[0].accesses != trace.size() || (counts.levels[0].hits + counts.levels[0].misses) != trace.size() ||
+        counts.levels[1].accesses != (counts.levels[0].misses + counts.levels[0].writebacks) ||
+        counts.memoryReads != counts.levels[1].misses || counts.memoryWrites != counts.levels[1].writebacks || counts.levels[0].hits == 0) {
+        std::cout << "Inconsistent statistics" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    for (unsigned threads : { 2u, 4u, 64u }) {
+        auto sharded = std::make_unique<Hierarchy>();
+        sharded->run(trace, threads);
+        if (!(sharded->statistics() == counts)) {
+            std::cout << "Sharded over " << threads << " threads differs from the serial run" << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    std::vector<MemoryAccess<uint32_t>> narrow(trace.size());
+    std::transform(trace.begin(), trace.end(), narrow.begin(), [](auto entry) { return MemoryAccess<uint32_t> { static_cast<uint32_t>(entry.address), entry.write }; });
+    CacheHierarchy<Cache<uint32_t, 64, 64, 8>> narrowSerial, narrowSharded;
+    narrowSerial.run(narrow);
+    narrowSharded.run(narrow, 4);
+    if (!(narrowSerial.statistics() == narrowSharded.statistics()) || narrowSerial.statistics().levels[0].misses != counts.levels[0].misses) {
+        std::cout << "32-bit tags disagree" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test26() {
+    std::cout << "Simple test 26: guest memory" << std::endl;
+    using namespace BinaryManipulation;
+    GuestMemory<> memory;
+    constexpr uint32_t Page = GuestMemory<>::PageSize;
+    if (memory.load<uint32_t>(0x1234) != 0 || memory.load<uint64_t>(0xFFFF'FFFC) != 0 || memory.backedPages() != 0) {
+        std::cout << "Unwritten memory is not zero" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    memory.store<uint32_t>(0x1000, 0xDDCC'BBAA);
+    memory.store<uint32_t>((3 * Page) - 2, 0x4433'2211);
+    memory.store<uint64_t>(0xFFFF'FFFD, 0x8877'6655'4433'2211);
+    auto [a, b, c, d] = getQuarters<uint32_t>(0x4433'2211);
+    if (memory.load<uint8_t>((3 * Page) - 2) != a || memory.load<uint8_t>((3 * Page) - 1) != b || memory.load<uint8_t>(3 * Page) != c ||
+        memory.load<uint8_t>((3 * Page) + 1) != d || memory.load<uint16_t>(0x1001) != 0xCCBB || memory.load<uint8_t>(4) != 0x88 ||
+        memory.load<uint32_t>(0xFFFF'FFFF) != 0x6655'4433 || memory.backedPages() != 5) {
+        std::cout << "Bad split store" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // every width at every alignment around a page boundary against bytes assembled one lane at a time
+    for (uint32_t address = (2 * Page) - 12; address < (3 * Page) + 12; ++address) {
+        auto byte = [&memory](uint32_t at) { return memory.load<uint8_t>(at); };
+        auto half = fromHalves<uint16_t>(byte(address), byte(address + 1));
+        auto word = fromQuarters<uint32_t>(byte(address), byte(address + 1), byte(address + 2), byte(address + 3));
+        auto wide = fromHalves<uint64_t>(memory.load<uint32_t>(address), memory.load<uint32_t>(address + 4));
+        if (memory.load<uint16_t>(address) != half || memory.load<uint32_t>(address) != word || memory.load<uint64_t>(address) != wide) {
+            std::cout << "Lanes differ at " << std::hex << address << std::dec << std::endl;
+            std::cout << "Failure!" << std::endl;
+            return;
+        }
+    }
+    // block operations against a flat copy of the first eight pages
+    std::vector<uint8_t> reference(8 * Page);
+    GuestMemory<> blocks;
+    for (uint32_t i = 0; i < reference.size(); ++i) {
+        reference[i] = static_cast<uint8_t>((i * 7) ^ (i >> 8));
+    }
+    blocks.write(0, reference);
+    blocks.fill(Page - 100, 300, 0xEE);
+    std::memset(reference.data() + Page - 100, 0xEE, 300);
+    blocks.move((2 * Page) + 10, (2 * Page) - 50, (2 * Page) + 3);
+    std::memmove(reference.data() + (2 * Page) + 10, reference.data() + (2 * Page) - 50, (2 * Page) + 3);
+    blocks.move(Page + 7, (3 * Page) - 5, Page + 100);
+    std::memmove(reference.data() + Page + 7, reference.data() + (3 * Page) - 5, Page + 100);
+    std::vector<uint8_t> contents(reference.size());
+    blocks.read(0, contents);
+    if (contents != reference) {
+        std::cout << "Bad block move or fill" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // zeroing untouched pages does not back them
+    blocks.fill(0x10'0000, 4 * Page, 0);
+    if (blocks.backedPages() != 8 || blocks.load<uint32_t>(0x10'0000 + Page) != 0) {
+        std::cout << "Zero fill backed pages" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
+void test27() {
+    std::cout << "Simple test 27: field watchpoints" << std::endl;
+    using namespace BinaryManipulation;
+    std::vector<WatchHit<uint32_t>> hits;
+    std::size_t batches = 0;
+    WatchLog<uint32_t> log([&](std::span<const WatchHit<uint32_t>> batch) {
+        ++batches;
+        hits.insert(hits.end(), batch.begin(), batch.end());
+    }, 4);
+    Watch<uint32_t> watch;
+    watch.attach(log, 7);
+    watch.arm<i960::ConditionCode>();
+    watch.arm<i960::IntegerOverflowFlag>();
+    // only writes that change an armed field are recorded, and only handed over four at a time
+    uint32_t ac = 0;
+    for (uint8_t code : { 1, 1, 2, 4, 4, 1, 2 }) {
+        ac = watchedEncode<i960::ConditionCode>(ac, code, watch);
+    }
+    ac = watchedEncode<i960::ArithmeticStatus>(ac, 0xF, watch);
+    FieldProxy<i960::IntegerOverflowFlag, Watch<uint32_t>> overflow(ac, watch);
+    overflow = true;
+    overflow = true;
+    if (batches != 1 || hits.size() != 4 || log.pending() != 2 || hits[0].source != 7 || hits[0].before != 0 || hits[0].after != 1 || !bool(overflow)) {
+        std::cout << "Bad batching, " << batches << " batches of " << hits.size() << " hits" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    log.flush();
+    if (hits.size() != 6 || hits[5].after != ac || hits[5].before != (ac & ~i960::IntegerOverflowFlag::Mask)) {
+        std::cout << "Bad flush" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    watch.disarm<i960::ConditionCode>();
+    ac = watchedEncode<i960::ConditionCode>(ac, 4, watch);
+    FieldProxy<i960::ConditionCode> unwatched(ac);
+    unwatched = 2;
+    if (log.pending() != 0 || ac != 0x17A || unwatched != 2) {
+        std::cout << "Disarmed field was recorded" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // an armed watch without a log drops its hits, and a callback throwing from the log's destructor is contained
+    Watch<uint32_t> detached;
+    detached.arm<i960::ConditionCode>();
+    auto detachedValue = watchedEncode<i960::ConditionCode>(0, 3, detached);
+    auto escaped = false;
+    try {
+        WatchLog<uint32_t> throwing([](std::span<const WatchHit<uint32_t>>) { throw std::runtime_error("no room for hits"); });
+        Watch<uint32_t> attached;
+        attached.attach(throwing);
+        attached.arm<i960::ConditionCode>();
+        attached.check(0, 1);
+    } catch (...) {
+        escaped = true;
+    }
+    if (detachedValue != 3 || escaped) {
+        std::cout << "Bad detached watch or log destruction" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    // the interpreter's control registers, the source is the register's place in the file
+    using i960::g0; using i960::g1;
+    const std::vector<i960::InstructionFields> program {
+        i960::reg("mov", 10, g1),
+        i960::reg("addo", g1, g0, g0),
+        i960::reg("subo", 1, g1, g1),
+        i960::cobr("cmpibl", 0, g1, -8),
+        i960::reg("fmark"),
+    };
+    std::vector<i960::Ordinal> words(i960::encodedLength(program));
+    i960::emitInstructions(program, words);
+    i960::WatchedInterpreter interpreter(16);
+    interpreter.load(words, 0);
+    hits.clear();
+    interpreter.controls().attach(log);
+    interpreter.arithmeticControls().watch().arm<i960::ConditionCode>();
+    interpreter.traceControls().watch().arm<i960::BreakpointTraceEvent>();
+    auto stop = interpreter.run(1000);
+    log.flush();
+    // the condition code goes to less on the first compare and to equal on the last
+    if (stop != i960::StopReason::Breakpoint || interpreter.reg(g0) != 55 || hits.size() != 3 || hits[0].source != 0 ||
+        i960::ConditionCode::decode(hits[0].after) != i960::ConditionLess || i960::ConditionCode::decode(hits[1].after) != i960::ConditionEqual ||
+        hits[2].source != 2 || !i960::BreakpointTraceEvent::decode(hits[2].after)) {
+        std::cout << "Bad interpreter watch, " << hits.size() << " hits" << std::endl;
+        std::cout << "Failure!" << std::endl;
+        return;
+    }
+    std::cout << "Passed!" << std::endl;
+}
 int main() {
     test0();
     test1();
     test2();
     test3();
+    test4();
+    test5();
+    test6();
+    test7();
+    test8();
+    test9();
+    test10();
+    test11();
+    test12();
+    test13();
+    test14();
+    test15();
+    test16();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
     return 0;
 }
@@ -0,0 +1,505 @@
+/**
+ * @file
+ * Hex and base64 codecs built from nibble and sextet field splits
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_TextCodecs_h__
+#define BinaryManipulation_TextCodecs_h__
+#include "BinaryManipulation.h"
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <utility>
+#if defined(__SSSE3__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+/**
+ * The i-th nibble of a word, counted from the least significant end
+ */
+template<typename T, std::size_t index>
+using NibbleField = FieldVector<T, uint8_t, index * 4, 4>;
+template<typename T>
+constexpr std::size_t HexDigitsPerWord = sizeof(T) * 2;
+
+constexpr std::string_view LowerHexDigits = "0123456789abcdef";
+constexpr std::string_view UpperHexDigits = "0123456789ABCDEF";
+
+/**
+ * Value of a hex digit or 0xFF if the character is not one
+ */
+constexpr uint8_t hexDigitValue(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+        return static_cast<uint8_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+        return static_cast<uint8_t>(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+        return static_cast<uint8_t>(c - 'A' + 10);
+    } else {
+        return 0xFF;
+    }
+}
+
+namespace Codecs {
+template<typename T, std::size_t ... I>
+constexpr void hexEncodeWord(T value, char* output, std::string_view digits, std::index_sequence<I...>) noexcept {
+    static_assert(std::is_unsigned_v<T>, "A signed top nibble would index past the digits!");
+    // most significant nibble first
+    ((output[HexDigitsPerWord<T> - 1 - I] = digits[NibbleField<T, I>::decode(value)]), ...);
+}
+template<typename T, std::size_t ... I>
+constexpr bool hexDecodeWord(const char* input, T& value, std::index_sequence<I...>) noexcept {
+    static_assert(std::is_unsigned_v<T>, "Hex words must be unsigned!");
+    std::array<uint8_t, sizeof...(I)> nibbles { hexDigitValue(input[HexDigitsPerWord<T> - 1 - I])... };
+    for (auto nibble : nibbles) {
+        if (nibble > 0xF) {
+            return false;
+        }
+    }
+    value = (NibbleField<T, I>::encode(std::move(nibbles[I])) | ...);
+    return true;
+}
+#ifdef __SSSE3__
+template<typename T>
+constexpr bool HasVectorHexPath = (16 % sizeof(T)) == 0;
+/**
+ * pshufb control reversing the bytes of every T in a vector so that the most
+ * significant byte (and therefore digit) comes first
+ */
+template<typename T>
+constexpr auto WordReversal = [] {
+    std::array<char, 16> result { };
+    for (std::size_t j = 0; j < result.size(); ++j) {
+        result[j] = static_cast<char>(((j / sizeof(T)) * sizeof(T)) + (sizeof(T) - 1 - (j % sizeof(T))));
+    }
+    return result;
+}();
+#endif
+} // end namespace Codecs
+
+template<typename T>
+constexpr std::size_t hexEncodedLength(std::size_t count) noexcept {
+    return count * HexDigitsPerWord<T>;
+}
+
+/**
+ * Write every word as a fixed width, most significant digit first, hex
+ * string without separators; returns the number of words encoded
+ */
+template<typename T>
+std::size_t hexEncode(std::span<const T> words, std::span<char> output, bool uppercase = false) noexcept {
+    static_assert(std::is_unsigned_v<T>, "Hex words must be unsigned!");
+    auto count = std::min(words.size(), output.size() / HexDigitsPerWord<T>);
+    auto digits = uppercase ? UpperHexDigits : LowerHexDigits;
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    if constexpr (Codecs::HasVectorHexPath<T>) {
+        constexpr auto PerVector = 16 / sizeof(T);
+        auto reversal = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Codecs::WordReversal<T>.data()));
+        auto table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits.data()));
+        auto lowNibble = _mm_set1_epi8(0x0F);
+        for (; (i + PerVector) <= count; i += PerVector) {
+            auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words.data() + i)), reversal);
+            auto high = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), lowNibble));
+            auto low = _mm_shuffle_epi8(table, _mm_and_si128(v, lowNibble));
+            auto destination = reinterpret_cast<__m128i*>(output.data() + hexEncodedLength<T>(i));
+            _mm_storeu_si128(destination + 0, _mm_unpacklo_epi8(high, low));
+            _mm_storeu_si128(destination + 1, _mm_unpackhi_epi8(high, low));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        Codecs::hexEncodeWord<T>(words[i], output.data() + hexEncodedLength<T>(i), digits, std::make_index_sequence<HexDigitsPerWord<T>> {});
+    }
+    return count;
+}
+
+/**
+ * Parse fixed width hex words (either case), returns the number of words
+ * decoded or nothing if a character is not a hex digit
+ */
+template<typename T>
+std::optional<std::size_t> hexDecode(std::string_view text, std::span<T> words) noexcept {
+    static_assert(std::is_unsigned_v<T>, "Hex words must be unsigned!");
+    auto count = std::min(text.size() / HexDigitsPerWord<T>, words.size());
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    if constexpr (Codecs::HasVectorHexPath<T> && sizeof(T) <= 8) {
+        // 16 digits become 8 bytes; classify every character as a digit or a
+        // letter, turn it into its nibble, and merge adjacent nibbles with a
+        // multiply add before restoring the in memory byte order
+        constexpr auto PerVector = 8 / sizeof(T);
+        auto reversal = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Codecs::WordReversal<T>.data()));
+        auto pairWeights = _mm_set1_epi16(0x0110);
+        for (; (i + PerVector) <= count; i += PerVector) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + hexEncodedLength<T>(i)));
+            auto digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+            auto letter = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+            auto isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+            auto isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+            if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xFFFF) {
+                return std::nullopt;
+            }
+            auto nibbles = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_andnot_si128(isDigit, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+            auto merged = _mm_maddubs_epi16(nibbles, pairWeights);
+            auto bytes = _mm_shuffle_epi8(_mm_packus_epi16(merged, merged), reversal);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(words.data() + i), bytes);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (!Codecs::hexDecodeWord<T>(text.data() + hexEncodedLength<T>(i), words[i], std::make_index_sequence<HexDigitsPerWord<T>> {})) {
+            return std::nullopt;
+        }
+    }
+    return count;
+}
+
+/**
+ * A base64 group is three bytes read as a big endian 24-bit quantity and
+ * split into four sextets
+ */
+using Base64Group = Description<uint32_t,
+      FieldVector<uint32_t, uint8_t, 18, 6>,
+      FieldVector<uint32_t, uint8_t, 12, 6>,
+      FieldVector<uint32_t, uint8_t, 6, 6>,
+      FieldVector<uint32_t, uint8_t, 0, 6>>;
+constexpr std::string_view Base64Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char Base64Padding = '=';
+
+/**
+ * Value of a base64 character or 0xFF if it is not part of the alphabet
+ */
+constexpr uint8_t base64Value(char c) noexcept {
+    if (c >= 'A' && c <= 'Z') {
+        return static_cast<uint8_t>(c - 'A');
+    } else if (c >= 'a' && c <= 'z') {
+        return static_cast<uint8_t>(c - 'a' + 26);
+    } else if (c >= '0' && c <= '9') {
+        return static_cast<uint8_t>(c - '0' + 52);
+    } else if (c == '+') {
+        return 62;
+    } else if (c == '/') {
+        return 63;
+    } else {
+        return 0xFF;
+    }
+}
+constexpr std::size_t base64EncodedLength(std::size_t bytes) noexcept {
+    return ((bytes + 2) / 3) * 4;
+}
+/**
+ * Upper bound on the number of bytes the given amount of text decodes to
+ */
+constexpr std::size_t base64DecodedLength(std::size_t characters) noexcept {
+    return (characters / 4) * 3;
+}
+
+/**
+ * Encode bytes as padded base64, returns the number of characters written
+ * (zero if output is smaller than base64EncodedLength)
+ */
+inline std::size_t base64Encode(std::span<const uint8_t> input, std::span<char> output) noexcept {
+    if (output.size() < base64EncodedLength(input.size())) {
+        return 0;
+    }
+    std::size_t i = 0, o = 0;
+#ifdef __SSSE3__
+    // 12 bytes become 16 sextets; every 32-bit lane holds bytes [b1, b0, b2, b1]
+    // so that the sextets can be moved into place with two 16-bit multiplies,
+    // then the sextets are mapped to characters by adding a per range offset
+    auto spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    auto offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    for (; (i + 16) <= input.size(); i += 12, o += 16) {
+        auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input.data() + i)), spread);
+        auto upper = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0FC0'FC00)), _mm_set1_epi32(0x0400'0040));
+        auto lower = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003F'03F0)), _mm_set1_epi32(0x0100'0010));
+        auto sextets = _mm_or_si128(upper, lower);
+        auto range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), sextets), _mm_set1_epi8(13)));
+        auto characters = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), sextets);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output.data() + o), characters);
+    }
+#endif
+    for (; i < input.size(); i += 3, o += 4) {
+        auto remaining = std::min<std::size_t>(input.size() - i, 3);
+        uint32_t group = static_cast<uint32_t>(input[i]) << 16;
+        if (remaining > 1) {
+            group |= static_cast<uint32_t>(input[i + 1]) << 8;
+        }
+        if (remaining > 2) {
+            group |= static_cast<uint32_t>(input[i + 2]);
+        }
+        auto [a, b, c, d] = Base64Group::decode(group);
+        output[o + 0] = Base64Alphabet[a];
+        output[o + 1] = Base64Alphabet[b];
+        output[o + 2] = remaining > 1 ? Base64Alphabet[c] : Base64Padding;
+        output[o + 3] = remaining > 2 ? Base64Alphabet[d] : Base64Padding;
+    }
+    return o;
+}
+
+/**
+ * Decode padded base64, returns the number of bytes written or nothing if the
+ * text is malformed or output is too small
+ */
+inline std::optional<std::size_t> base64Decode(std::string_view text, std::span<uint8_t> output) noexcept {
+    if ((text.size() % 4) != 0) {
+        return std::nullopt;
+    }
+    std::size_t i = 0, o = 0;
+#ifdef __SSSE3__
+    // classify characters by nibble (any bit surviving the and of both lookups
+    // is an invalid character), translate them to sextets with a per range
+    // offset, and merge sextets with two multiply adds
+    auto lowLookup = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    auto highLookup = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    auto offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    auto gather = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    auto lowNibble = _mm_set1_epi8(0x0F);
+    // the last quartet may be padded so leave it to the scalar path
+    for (; (i + 20) <= text.size() && (o + 16) <= output.size(); i += 16, o += 12) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        auto high = _mm_and_si128(_mm_srli_epi16(v, 4), lowNibble);
+        auto invalid = _mm_and_si128(_mm_shuffle_epi8(lowLookup, _mm_and_si128(v, lowNibble)), _mm_shuffle_epi8(highLookup, high));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF) {
+            return std::nullopt;
+        }
+        auto slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+        auto sextets = _mm_add_epi8(v, _mm_shuffle_epi8(offsets, _mm_add_epi8(slash, high)));
+        auto pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x0140'0140));
+        auto groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x0001'1000));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output.data() + o), _mm_shuffle_epi8(groups, gather));
+    }
+#endif
+    for (; i < text.size(); i += 4) {
+        std::size_t padding = 0;
+        if ((i + 4) == text.size() && text[i + 3] == Base64Padding) {
+            padding = (text[i + 2] == Base64Padding) ? 2 : 1;
+        }
+        std::array<uint8_t, 4> sextets { };
+        for (std::size_t j = 0; j < 4 - padding; ++j) {
+            sextets[j] = base64Value(text[i + j]);
+            if (sextets[j] > 63) {
+                return std::nullopt;
+            }
+        }
+        auto bytes = 3 - padding;
+        if ((o + bytes) > output.size()) {
+            return std::nullopt;
+        }
+        auto group = Base64Group::encode(std::move(sextets[0]), std::move(sextets[1]), std::move(sextets[2]), std::move(sextets[3]));
+        for (std::size_t j = 0; j < bytes; ++j) {
+            output[o++] = static_cast<uint8_t>(group >> (16 - (j * 8)));
+        }
+    }
+    return o;
+}
+
+/**
+ * Base64 over the in memory bytes of a span of words
+ */
+template<typename T>
+std::size_t base64Encode(std::span<const T> words, std::span<char> output) noexcept {
+    return base64Encode(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(words.data()), words.size_bytes()), output);
+}
+
+/**
+ * Result of parsing hex tokens; valid is false when parsing stopped at a
+ * malformed token (consumed is the offset of that token)
+ */
+struct HexParseResult {
+    std::size_t consumed;
+    std::size_t produced;
+    bool valid;
+};
+
+constexpr bool isHexSeparator(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+}
+
+namespace Codecs {
+constexpr std::size_t HexChunkLength = 512;
+/**
+ * Per character classification of a chunk of text. Nibbles are stored after
+ * 16 bytes of slack so a token can always be loaded as two 8 byte words
+ * ending at its last digit.
+ */
+struct HexChunk {
+    static constexpr std::size_t Slack = 16;
+    std::array<uint8_t, Slack + HexChunkLength> nibbles;
+    std::array<uint64_t, HexChunkLength / 64> hexDigits;
+    std::array<uint64_t, HexChunkLength / 64> separators;
+};
+inline void classifyHexChunk(const char* text, std::size_t length, HexChunk& chunk) noexcept {
+    chunk.hexDigits.fill(0);
+    chunk.separators.fill(0);
+    auto mark = [&chunk](std::size_t position, uint64_t hexBits, uint64_t separatorBits) noexcept {
+        chunk.hexDigits[position / 64] |= hexBits << (position % 64);
+        chunk.separators[position / 64] |= separatorBits << (position % 64);
+    };
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    for (; (i + 16) <= length; i += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        auto digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        auto letter = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        auto isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+        auto isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+        auto nibbles = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_andnot_si128(isDigit, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+        // ' ', '\t', '\n', '\r', and ','
+        auto isSeparator = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))),
+                                        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(chunk.nibbles.data() + HexChunk::Slack + i), nibbles);
+        mark(i, static_cast<uint64_t>(_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter))), static_cast<uint64_t>(_mm_movemask_epi8(isSeparator)));
+    }
+#endif
+    for (; i < length; ++i) {
+        auto value = hexDigitValue(text[i]);
+        chunk.nibbles[HexChunk::Slack + i] = value;
+        mark(i, value <= 0xF, isHexSeparator(text[i]));
+    }
+}
+/**
+ * Position of the first bit at or after from with the given value, or length
+ */
+inline std::size_t findBit(const std::array<uint64_t, HexChunkLength / 64>& bits, std::size_t from, std::size_t length, bool value) noexcept {
+    while (from < length) {
+        auto word = value ? bits[from / 64] : ~bits[from / 64];
+        word >>= (from % 64);
+        if (word != 0) {
+            return std::min(length, from + std::countr_zero(word));
+        }
+        from = ((from / 64) + 1) * 64;
+    }
+    return length;
+}
+/**
+ * Pack the (at most 16) nibbles ending just before end, first nibble most significant
+ */
+inline uint64_t packNibbles(const uint8_t* end, std::size_t count) noexcept {
+    auto packEight = [](const uint8_t* first) noexcept {
+        uint64_t bytes = 0;
+        std::memcpy(&bytes, first, sizeof(bytes));
+        // last character in the lowest byte
+        bytes = reverseBytes<uint64_t>(bytes);
+#ifdef __BMI2__
+        return static_cast<uint64_t>(_pext_u64(bytes, 0x0F0F'0F0F'0F0F'0F0Full));
+#else
+        bytes &= 0x0F0F'0F0F'0F0F'0F0Full;
+        bytes = (bytes | (bytes >> 4)) & 0x00FF'00FF'00FF'00FFull;
+        bytes = (bytes | (bytes >> 8)) & 0x0000'FFFF'0000'FFFFull;
+        return (bytes | (bytes >> 16)) & 0x0000'0000'FFFF'FFFFull;
+#endif
+    };
+    auto value = packEight(end - 8);
+    if (count > 8) {
+        value |= packEight(end - 16) << 32;
+    }
+    return count < 16 ? (value & computeMaskFromLength<uint64_t>(count * 4)) : value;
+}
+} // end namespace Codecs
+
+/**
+ * Parse whitespace or comma separated hex tokens of one to
+ * HexDigitsPerWord<T> digits (an optional 0x prefix is allowed) into words.
+ * Characters are classified and turned into nibbles 16 at a time, token
+ * boundaries are found with bit scans over the resulting masks, and every
+ * token is packed with a single pext (or shift ladder) per 8 digits.
+ */
+template<typename T>
+HexParseResult parseHexTokens(std::string_view text, std::span<T> words) noexcept {
+    static_assert(std::is_unsigned_v<T> && sizeof(T) <= sizeof(uint64_t));
+    Codecs::HexChunk chunk { };
+    std::size_t produced = 0;
+    std::size_t base = 0;
+    while (base < text.size()) {
+        auto length = std::min(Codecs::HexChunkLength, text.size() - base);
+        auto last = (base + length) == text.size();
+        Codecs::classifyHexChunk(text.data() + base, length, chunk);
+        std::size_t position = Codecs::findBit(chunk.separators, 0, length, false);
+        while (position < length) {
+            auto end = Codecs::findBit(chunk.separators, position, length, true);
+            if (end == length && !last) {
+                // the token may continue in the next chunk
+                if (position == 0) {
+                    return { base, produced, false };
+                }
+                break;
+            }
+            if (produced == words.size()) {
+                return { base + position, produced, true };
+            }
+            auto start = position;
+            if ((end - start) > 2 && text[base + start] == '0' && (text[base + start + 1] | 0x20) == 'x') {
+                start += 2;
+            }
+            auto digits = end - start;
+            if (digits == 0 || digits > HexDigitsPerWord<T> || Codecs::findBit(chunk.hexDigits, start, end, false) != end) {
+                return { base + position, produced, false };
+            }
+            words[produced++] = static_cast<T>(Codecs::packNibbles(chunk.nibbles.data() + Codecs::HexChunk::Slack + end, digits));
+            position = Codecs::findBit(chunk.separators, end, length, false);
+        }
+        base += std::min(position, length);
+    }
+    return { text.size(), produced, true };
+}
+
+/**
+ * Parse hex tokens straight into the decoded fields of a Description; words
+ * are staged through a small buffer so the raw values never reach memory
+ */
+template<typename D>
+HexParseResult parseHexFields(std::string_view text, std::span<typename D::SliceType> fields) noexcept {
+    using DataType = typename D::DataType;
+    constexpr std::size_t StagingWords = 256;
+    std::array<DataType, StagingWords> staging;
+    HexParseResult total { 0, 0, true };
+    while (total.consumed < text.size() && total.produced < fields.size()) {
+        auto count = std::min(StagingWords, fields.size() - total.produced);
+        auto result = parseHexTokens<DataType>(text.substr(total.consumed), std::span<DataType>(staging.data(), count));
+        for (std::size_t i = 0; i < result.produced; ++i) {
+            fields[total.produced + i] = D::decode(staging[i]);
+        }
+        total.consumed += result.consumed;
+        total.produced += result.produced;
+        if (!result.valid) {
+            total.valid = false;
+            break;
+        }
+        if (result.produced == 0) {
+            break;
+        }
+    }
+    return total;
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_TextCodecs_h__
@@ -0,0 +1,377 @@
+/**
+ * @file
+ * UTF-8 validation and UTF-8/UTF-32 transcoding described with byte patterns
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Utf8_h__
+#define BinaryManipulation_Utf8_h__
+#include "BinaryManipulation.h"
+#ifdef __SSSE3__
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation {
+
+/// 10xxxxxx
+using Utf8ContinuationTag = FieldVector<uint8_t, uint8_t, 6, 2>;
+using Utf8ContinuationPayload = FieldVector<uint8_t, uint32_t, 0, 6>;
+using Utf8Continuation = Description<uint8_t, Utf8ContinuationTag, Utf8ContinuationPayload>;
+constexpr uint8_t Utf8ContinuationTagValue = 0b10;
+
+/**
+ * The payload of a lead byte, 0xxxxxxx, 110xxxxx, 1110xxxx, or 11110xxx
+ */
+template<std::size_t length>
+using Utf8LeadPayload = FieldVector<uint8_t, uint32_t, 0, (length == 1) ? 7 : (7 - length)>;
+/**
+ * The tag of a lead byte (the bits above the payload)
+ */
+template<std::size_t length>
+using Utf8LeadTag = FieldVector<uint8_t, uint8_t, Utf8LeadPayload<length>::FieldWidth, 8 - Utf8LeadPayload<length>::FieldWidth>;
+template<std::size_t length>
+constexpr uint8_t Utf8LeadTagValue = (length == 1) ? 0 : static_cast<uint8_t>(((0xFF00 >> length) & 0xFF) >> Utf8LeadPayload<length>::FieldWidth);
+/**
+ * The i-th group of six bits of a code point, counted from the least significant end
+ */
+template<std::size_t index>
+using CodePointSextet = FieldVector<uint32_t, uint32_t, index * 6, 6>;
+
+constexpr uint32_t MaximumCodePoint = 0x10'FFFF;
+constexpr uint32_t FirstSurrogate = 0xD800;
+constexpr uint32_t LastSurrogate = 0xDFFF;
+
+static_assert(Utf8LeadTagValue<1> == 0 && Utf8LeadTagValue<2> == 0b110 && Utf8LeadTagValue<3> == 0b1110 && Utf8LeadTagValue<4> == 0b11110);
+static_assert(Utf8Continuation::encode(uint8_t { Utf8ContinuationTagValue }, 0b10'1010) == 0b1010'1010);
+
+constexpr bool isUtf8Continuation(uint8_t value) noexcept {
+    return Utf8ContinuationTag::decode(value) == Utf8ContinuationTagValue;
+}
+/**
+ * Length of the sequence introduced by the given lead byte or zero if the byte
+ * cannot start a sequence
+ */
+constexpr std::size_t utf8SequenceLength(uint8_t lead) noexcept {
+    switch (std::countl_one(lead)) {
+        case 0: return 1;
+        case 2: return 2;
+        case 3: return 3;
+        case 4: return 4;
+        default: return 0;
+    }
+}
+constexpr bool isValidCodePoint(uint32_t codePoint) noexcept {
+    return codePoint <= MaximumCodePoint && (codePoint < FirstSurrogate || codePoint > LastSurrogate);
+}
+constexpr std::size_t utf8EncodedLength(uint32_t codePoint) noexcept {
+    return codePoint < 0x80 ? 1 : codePoint < 0x800 ? 2 : codePoint < 0x1'0000 ? 3 : 4;
+}
+
+/**
+ * Decode a single code point starting at input[0], returns the number of bytes
+ * consumed or zero if the sequence is malformed, overlong, a surrogate, or out of range
+ */
+constexpr std::size_t decodeUtf8(std::span<const uint8_t> input, uint32_t& codePoint) noexcept {
+    if (input.empty()) {
+        return 0;
+    }
+    auto length = utf8SequenceLength(input[0]);
+    if (length == 0 || length > input.size()) {
+        return 0;
+    }
+    uint32_t result = 0;
+    switch (length) {
+        case 1: result = Utf8LeadPayload<1>::decode(input[0]); break;
+        case 2: result = Utf8LeadPayload<2>::decode(input[0]); break;
+        case 3: result = Utf8LeadPayload<3>::decode(input[0]); break;
+        default: result = Utf8LeadPayload<4>::decode(input[0]); break;
+    }
+    for (std::size_t i = 1; i < length; ++i) {
+        if (!isUtf8Continuation(input[i])) {
+            return 0;
+        }
+        result = (result << 6) | Utf8ContinuationPayload::decode(input[i]);
+    }
+    if (utf8EncodedLength(result) != length || !isValidCodePoint(result)) {
+        return 0;
+    }
+    codePoint = result;
+    return length;
+}
+
+/**
+ * Encode a single code point into output, returns the number of bytes written
+ * or zero if the code point is invalid or output is too small
+ */
+constexpr std::size_t encodeUtf8(uint32_t codePoint, std::span<uint8_t> output) noexcept {
+    if (!isValidCodePoint(codePoint)) {
+        return 0;
+    }
+    auto length = utf8EncodedLength(codePoint);
+    if (length > output.size()) {
+        return 0;
+    }
+    auto continuation = [](uint32_t sextet) noexcept { return Utf8Continuation::encode(uint8_t { Utf8ContinuationTagValue }, std::move(sextet)); };
+    switch (length) {
+        case 1:
+            output[0] = Utf8LeadPayload<1>::encode(codePoint);
+            break;
+        case 2:
+            output[0] = Utf8LeadTag<2>::encode(Utf8LeadPayload<2>::encode(CodePointSextet<1>::decode(codePoint)), Utf8LeadTagValue<2>);
+            output[1] = continuation(CodePointSextet<0>::decode(codePoint));
+            break;
+        case 3:
+            output[0] = Utf8LeadTag<3>::encode(Utf8LeadPayload<3>::encode(CodePointSextet<2>::decode(codePoint)), Utf8LeadTagValue<3>);
+            output[1] = continuation(CodePointSextet<1>::decode(codePoint));
+            output[2] = continuation(CodePointSextet<0>::decode(codePoint));
+            break;
+        default:
+            output[0] = Utf8LeadTag<4>::encode(Utf8LeadPayload<4>::encode(CodePointSextet<3>::decode(codePoint)), Utf8LeadTagValue<4>);
+            output[1] = continuation(CodePointSextet<2>::decode(codePoint));
+            output[2] = continuation(CodePointSextet<1>::decode(codePoint));
+            output[3] = continuation(CodePointSextet<0>::decode(codePoint));
+            break;
+    }
+    return length;
+}
+
+namespace Utf8 {
+constexpr bool isValidScalar(std::span<const uint8_t> input) noexcept {
+    for (std::size_t i = 0; i < input.size();) {
+        uint32_t codePoint = 0;
+        auto length = decodeUtf8(input.subspan(i), codePoint);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+/**
+ * Find where the character that may straddle position begins (the lead byte
+ * at most three bytes back), otherwise position itself
+ */
+constexpr std::size_t characterStart(std::span<const uint8_t> input, std::size_t position) noexcept {
+    for (std::size_t back = 1; back <= 3 && back <= position; ++back) {
+        auto value = input[position - back];
+        if (!isUtf8Continuation(value)) {
+            return utf8SequenceLength(value) > 1 ? (position - back) : position;
+        }
+    }
+    return position;
+}
+#ifdef __SSSE3__
+// Lookup based validation (Keiser and Lemire), every pair of adjacent bytes is
+// classified through three 16 entry tables indexed by the high and low nibble
+// of the first byte and the high nibble of the second byte. Any bit that
+// survives the and of all three is an error, except that the second and third
+// continuation of a three or four byte sequence legitimately show up as two
+// continuations in a row.
+namespace Lookup {
+constexpr uint8_t TooShort = 1 << 0;
+constexpr uint8_t TooLong = 1 << 1;
+constexpr uint8_t Overlong3 = 1 << 2;
+constexpr uint8_t TooLarge = 1 << 3;
+constexpr uint8_t Surrogate = 1 << 4;
+constexpr uint8_t Overlong2 = 1 << 5;
+constexpr uint8_t TooLarge1000 = 1 << 6;
+constexpr uint8_t Overlong4 = 1 << 6;
+constexpr uint8_t TwoContinuations = 1 << 7;
+constexpr uint8_t Carry = TooShort | TooLong | TwoContinuations;
+inline __m128i highNibbles(__m128i v) noexcept {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+inline __m128i lookup(__m128i table, __m128i index) noexcept {
+    return _mm_shuffle_epi8(table, index);
+}
+inline __m128i checkSpecialCases(__m128i input, __m128i previous1) noexcept {
+    const auto byte1High = _mm_setr_epi8(
+            TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+            TwoContinuations, TwoContinuations, TwoContinuations, TwoContinuations,
+            TooShort | Overlong2,
+            TooShort,
+            TooShort | Overlong3 | Surrogate,
+            static_cast<char>(TooShort | TooLarge | TooLarge1000 | Overlong4));
+    const auto byte1Low = _mm_setr_epi8(
+            static_cast<char>(Carry | Overlong3 | Overlong2 | Overlong4),
+            static_cast<char>(Carry | Overlong2),
+            static_cast<char>(Carry),
+            static_cast<char>(Carry),
+            static_cast<char>(Carry | TooLarge),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000 | Surrogate),
+            static_cast<char>(Carry | TooLarge | TooLarge1000),
+            static_cast<char>(Carry | TooLarge | TooLarge1000));
+    const auto byte2High = _mm_setr_epi8(
+            TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+            static_cast<char>(TooLong | Overlong2 | TwoContinuations | Overlong3 | TooLarge1000 | Overlong4),
+            static_cast<char>(TooLong | Overlong2 | TwoContinuations | Overlong3 | TooLarge),
+            static_cast<char>(TooLong | Overlong2 | TwoContinuations | Surrogate | TooLarge),
+            static_cast<char>(TooLong | Overlong2 | TwoContinuations | Surrogate | TooLarge),
+            TooShort, TooShort, TooShort, TooShort);
+    return _mm_and_si128(_mm_and_si128(lookup(byte1High, highNibbles(previous1)),
+                                       lookup(byte1Low, _mm_and_si128(previous1, _mm_set1_epi8(0x0F)))),
+                         lookup(byte2High, highNibbles(input)));
+}
+inline __m128i checkBlock(__m128i input, __m128i previous) noexcept {
+    auto previous1 = _mm_alignr_epi8(input, previous, 15);
+    auto previous2 = _mm_alignr_epi8(input, previous, 14);
+    auto previous3 = _mm_alignr_epi8(input, previous, 13);
+    // the second and third byte after a three or four byte lead must be continuations
+    auto mustBeContinuation = _mm_or_si128(_mm_subs_epu8(previous2, _mm_set1_epi8(static_cast<char>(0b1110'0000 - 1))),
+                                           _mm_subs_epu8(previous3, _mm_set1_epi8(static_cast<char>(0b1111'0000 - 1))));
+    auto expected = _mm_and_si128(_mm_cmpgt_epi8(mustBeContinuation, _mm_setzero_si128()), _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(expected, checkSpecialCases(input, previous1));
+}
+/**
+ * Non zero where the block ends with a lead byte whose sequence is not complete
+ */
+inline __m128i incompleteTail(__m128i input) noexcept {
+    const auto maximum = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0b1111'0000 - 1), static_cast<char>(0b1110'0000 - 1), static_cast<char>(0b1100'0000 - 1));
+    return _mm_subs_epu8(input, maximum);
+}
+} // end namespace Lookup
+#endif
+} // end namespace Utf8
+
+/**
+ * Validate a UTF-8 buffer; blocks of pure ASCII are skipped with a single
+ * movemask and everything else goes through the SIMD lookup tables. The
+ * scalar pattern based decoder finishes off the tail.
+ */
+inline bool isValidUtf8(std::span<const uint8_t> input) noexcept {
+    std::size_t i = 0;
+#ifdef __SSSE3__
+    auto error = _mm_setzero_si128();
+    auto previous = _mm_setzero_si128();
+    auto incomplete = _mm_setzero_si128();
+    for (; (i + 16) <= input.size(); i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input.data() + i));
+        if (_mm_movemask_epi8(block) == 0) {
+            error = _mm_or_si128(error, incomplete);
+        } else {
+            error = _mm_or_si128(error, Utf8::Lookup::checkBlock(block, previous));
+            incomplete = Utf8::Lookup::incompleteTail(block);
+        }
+        previous = block;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+    // the vector loop never saw the bytes after its last block so restart at
+    // the character that straddles the boundary
+    i = Utf8::characterStart(input, i);
+#endif
+    return Utf8::isValidScalar(input.subspan(i));
+}
+inline bool isValidUtf8(std::string_view input) noexcept {
+    return isValidUtf8(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(input.data()), input.size()));
+}
+
+/**
+ * Result of a transcoding operation; valid is false if conversion stopped
+ * early because of malformed input (consumed points at the offending element)
+ * or because the output was too small
+ */
+struct TranscodeResult {
+    std::size_t consumed;
+    std::size_t produced;
+    bool valid;
+};
+
+inline TranscodeResult utf8ToUtf32(std::span<const uint8_t> input, std::span<char32_t> output) noexcept {
+    std::size_t i = 0, o = 0;
+    while (i < input.size()) {
+#ifdef __SSE2__
+        // ASCII fast path, widen 16 bytes at a time
+        if ((i + 16) <= input.size() && (o + 16) <= output.size()) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input.data() + i));
+            if (_mm_movemask_epi8(block) == 0) {
+                auto zero = _mm_setzero_si128();
+                auto low = _mm_unpacklo_epi8(block, zero);
+                auto high = _mm_unpackhi_epi8(block, zero);
+                auto destination = reinterpret_cast<__m128i*>(output.data() + o);
+                _mm_storeu_si128(destination + 0, _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128(destination + 1, _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128(destination + 2, _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128(destination + 3, _mm_unpackhi_epi16(high, zero));
+                i += 16;
+                o += 16;
+                continue;
+            }
+        }
+#endif
+        if (o == output.size()) {
+            return { i, o, false };
+        }
+        uint32_t codePoint = 0;
+        auto length = decodeUtf8(input.subspan(i), codePoint);
+        if (length == 0) {
+            return { i, o, false };
+        }
+        output[o++] = static_cast<char32_t>(codePoint);
+        i += length;
+    }
+    return { i, o, true };
+}
+
+inline TranscodeResult utf32ToUtf8(std::span<const char32_t> input, std::span<uint8_t> output) noexcept {
+    std::size_t i = 0, o = 0;
+    while (i < input.size()) {
+#ifdef __SSE2__
+        // ASCII fast path, narrow 8 code points at a time
+        if ((i + 8) <= input.size() && (o + 8) <= output.size()) {
+            auto source = reinterpret_cast<const __m128i*>(input.data() + i);
+            auto a = _mm_loadu_si128(source + 0);
+            auto b = _mm_loadu_si128(source + 1);
+            auto outside = _mm_or_si128(_mm_srli_epi32(a, 7), _mm_srli_epi32(b, 7));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(outside, _mm_setzero_si128())) == 0xFFFF) {
+                auto words = _mm_packs_epi32(a, b);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(output.data() + o), _mm_packus_epi16(words, words));
+                i += 8;
+                o += 8;
+                continue;
+            }
+        }
+#endif
+        auto length = encodeUtf8(static_cast<uint32_t>(input[i]), output.subspan(o));
+        if (length == 0) {
+            return { i, o, false };
+        }
+        o += length;
+        ++i;
+    }
+    return { i, o, true };
+}
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_Utf8_h__
@@ -0,0 +1,174 @@
+/**
+ * @file
+ * Field level watchpoints with batched hit delivery
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_Watchpoints_h__
+#define BinaryManipulation_Watchpoints_h__
+#include "BinaryManipulation.h"
+#include <functional>
+#include <span>
+#include <vector>
+namespace BinaryManipulation {
+
+/**
+ * A write that changed a watched field, source identifies what was written
+ */
+template<typename T>
+struct WatchHit {
+    std::size_t source;
+    T before;
+    T after;
+};
+
+/**
+ * Collects hits and hands them to the callback capacity at a time, or
+ * whatever is left on flush and destruction, so a watch that fires on
+ * every write costs a store instead of a call. The destructor swallows
+ * anything the callback throws; call flush first to see it.
+ */
+template<typename T>
+class WatchLog final {
+    public:
+        using Callback = std::function<void(std::span<const WatchHit<T>>)>;
+        static constexpr std::size_t DefaultCapacity = 256;
+    public:
+        explicit WatchLog(Callback callback, std::size_t capacity = DefaultCapacity) : _callback(std::move(callback)), _hits(capacity == 0 ? 1 : capacity) { }
+        WatchLog(const WatchLog&) = delete;
+        WatchLog& operator=(const WatchLog&) = delete;
+        ~WatchLog() {
+            try {
+                flush();
+            } catch (...) {
+                // nowhere to report it from a destructor
+            }
+        }
+        void record(const WatchHit<T>& hit) {
+            _hits[_count++] = hit;
+            if (_count == _hits.size()) [[unlikely]] {
+                flush();
+            }
+        }
+        void flush() {
+            if (_count != 0) {
+                _callback(std::span<const WatchHit<T>>(_hits.data(), _count));
+                _count = 0;
+            }
+        }
+        constexpr std::size_t pending() const noexcept { return _count; }
+        constexpr std::size_t capacity() const noexcept { return _hits.size(); }
+    private:
+        Callback _callback;
+        std::vector<WatchHit<T>> _hits;
+        std::size_t _count = 0;
+};
+
+/**
+ * Watches some of the fields of a value. The armed fields are kept as the
+ * union of their Pattern masks so checking a write is one masked compare
+ * of before ^ after whatever the number of fields watched. Hits are
+ * dropped until a log is attached.
+ */
+template<typename T>
+class Watch final {
+    public:
+        using Log = WatchLog<T>;
+    public:
+        constexpr void attach(Log& log, std::size_t source = 0) noexcept {
+            _log = &log;
+            _source = source;
+        }
+        template<typename P>
+        constexpr void arm() noexcept {
+            static_assert(std::is_same_v<typename P::DataType, T>);
+            _mask |= P::Mask;
+        }
+        template<typename P>
+        constexpr void disarm() noexcept { _mask &= ~P::Mask; }
+        constexpr void disarmAll() noexcept { _mask = 0; }
+        constexpr bool armed() const noexcept { return _mask != 0; }
+        constexpr T mask() const noexcept { return _mask; }
+        void check(T before, T after) {
+            if (((before ^ after) & _mask) != 0) [[unlikely]] {
+                if (_log != nullptr) {
+                    _log->record({ _source, before, after });
+                }
+            }
+        }
+    private:
+        T _mask = 0;
+        std::size_t _source = 0;
+        Log* _log = nullptr;
+};
+/**
+ * Stands in for Watch where watching is compiled out, it has no state and
+ * checking does nothing
+ */
+template<typename T>
+struct NoWatch final {
+    static constexpr void check(T, T) noexcept { }
+};
+template<bool watchable, typename T>
+using WatchFor = std::conditional_t<watchable, Watch<T>, NoWatch<T>>;
+
+/**
+ * Pattern::encode that reports the write to watch
+ */
+template<typename P, typename W>
+constexpr typename P::DataType watchedEncode(typename P::DataType value, typename P::SliceType input, W& watch) {
+    auto updated = static_cast<typename P::DataType>(P::encode(value, input));
+    watch.check(value, updated);
+    return updated;
+}
+
+/**
+ * A single field of a value held elsewhere, assigning to it writes only
+ * that field and goes through the watch if there is one
+ */
+template<typename P, typename W = NoWatch<typename P::DataType>>
+class FieldProxy final {
+    public:
+        using DataType = typename P::DataType;
+        using SliceType = typename P::SliceType;
+    public:
+        constexpr explicit FieldProxy(DataType& storage) noexcept requires std::is_same_v<W, NoWatch<DataType>> : _storage(storage), _watch(nullptr) { }
+        constexpr FieldProxy(DataType& storage, W& watch) noexcept : _storage(storage), _watch(&watch) { }
+        constexpr operator SliceType() const noexcept { return P::decode(_storage); }
+        constexpr FieldProxy& operator=(SliceType value) {
+            if constexpr (std::is_same_v<W, NoWatch<DataType>>) {
+                _storage = static_cast<DataType>(P::encode(_storage, value));
+            } else {
+                _storage = watchedEncode<P>(_storage, value, *_watch);
+            }
+            return *this;
+        }
+    private:
+        DataType& _storage;
+        W* _watch;
+};
+
+} // end namespace BinaryManipulation
+#endif // BinaryManipulation_Watchpoints_h__
@@ -0,0 +1,293 @@
+/**
+ * @file
+ * Layouts of the i960's instruction words and control registers
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_i960_h__
+#define BinaryManipulation_i960_h__
+#include "BinaryManipulation.h"
+#include <span>
+namespace BinaryManipulation::i960 {
+
+using Ordinal = uint32_t;
+using HalfOrdinal = uint16_t;
+using ByteOrdinal = uint8_t;
+
+/**
+ * The major opcode is the highest byte of every instruction
+ */
+using StandardOpcodePattern = HighestQuarterPattern<Ordinal>;
+/**
+ * REG format instructions extend the opcode with four more bits
+ */
+using ExtendedOpcodePattern = Pattern<Ordinal, HalfOrdinal, 0b111'1000'0000, 7>;
+using OpcodeExtraction = Description<Ordinal, StandardOpcodePattern, ExtendedOpcodePattern>;
+// we must construct a 16-bit opcode from the standard and extended pieces
+using ShiftStandardOpcodeIntoOpcode16 = NoCastPattern<HalfOrdinal, 0x0F'F0, 4>;
+using ShiftExtendedOpcodeIntoOpcode16 = NoCastPattern<HalfOrdinal, 0x00'0F>;
+using Opcode16Builder = Description<HalfOrdinal, ShiftStandardOpcodeIntoOpcode16, ShiftExtendedOpcodeIntoOpcode16>;
+static_assert(Opcode16Builder::encode(HalfOrdinal { 0x5C }, HalfOrdinal { 0xC }) == 0x5CC);
+
+template<Ordinal position>
+using ControlFlag = Flag<Ordinal, position>;
+
+// based off of the arithmetic controls register as described in the manual
+using ConditionCode = FieldVector<Ordinal, ByteOrdinal, 0, 3>;
+using ArithmeticStatus = FieldVector<Ordinal, ByteOrdinal, 3, 4>;
+using IntegerOverflowFlag = ControlFlag<8>;
+using IntegerOverflowMask = ControlFlag<12>;
+using NoImpreciseFaults = ControlFlag<15>;
+using ArithmeticControls = Description<Ordinal, ConditionCode, ArithmeticStatus, IntegerOverflowFlag, IntegerOverflowMask, NoImpreciseFaults>;
+
+// trace controls, the mode bits and their matching event flags
+using TraceControls = Description<Ordinal,
+      ControlFlag<1>, ControlFlag<2>, ControlFlag<3>, ControlFlag<4>, ControlFlag<5>,
+      ControlFlag<6>, ControlFlag<7>, ControlFlag<17>, ControlFlag<18>, ControlFlag<19>,
+      ControlFlag<20>, ControlFlag<21>, ControlFlag<22>, ControlFlag<23>>;
+using InstructionTraceMode = ControlFlag<1>;
+using BranchTraceMode = ControlFlag<2>;
+using BreakpointTraceMode = ControlFlag<7>;
+using InstructionTraceEvent = ControlFlag<17>;
+using BranchTraceEvent = ControlFlag<18>;
+using BreakpointTraceEvent = ControlFlag<23>;
+
+// process controls
+using TraceEnable = ControlFlag<0>;
+using ExecutionMode = ControlFlag<1>;
+using TraceFaultPending = ControlFlag<10>;
+using ProcessState = ControlFlag<13>;
+using ProcessPriority = FieldVector<Ordinal, ByteOrdinal, 16, 5>;
+using ProcessControls = Description<Ordinal, TraceEnable, ExecutionMode, TraceFaultPending, ProcessState, ProcessPriority>;
+
+/**
+ * Instruction formats, selected by the top two bits of the major opcode
+ */
+enum class Format : ByteOrdinal {
+    CTRL,
+    COBR,
+    REG,
+    MEM,
+};
+constexpr Format formatOf(Ordinal word) noexcept {
+    // 0x00-0x1F CTRL, 0x20-0x3F COBR, 0x40-0x7F REG, 0x80-0xFF MEM
+    auto group = StandardOpcodePattern::decode(word) >> 5;
+    return static_cast<Format>(std::min(group, 2) + (group >= 4));
+}
+
+// operand fields shared by the REG, COBR and MEM formats
+using SrcDestPattern = FieldVector<Ordinal, ByteOrdinal, 19, 5>;
+using Src2Pattern = FieldVector<Ordinal, ByteOrdinal, 14, 5>;
+using Src1Pattern = FieldVector<Ordinal, ByteOrdinal, 0, 5>;
+
+// REG: opcode | src/dst | src2 | M3 M2 M1 | opcode ext | S2 S1 | src1
+using RegM3 = ControlFlag<13>;
+using RegM2 = ControlFlag<12>;
+using RegM1 = ControlFlag<11>;
+using RegS2 = ControlFlag<6>;
+using RegS1 = ControlFlag<5>;
+using RegOperands = Description<Ordinal, SrcDestPattern, Src2Pattern, RegM3, RegM2, RegM1, RegS2, RegS1, Src1Pattern>;
+// the S and M bits as groups, already in InstructionFlags order
+using RegSpecialBits = Pattern<Ordinal, ByteOrdinal, 0b0110'0000, 5>;
+using RegModeBits = Pattern<Ordinal, ByteOrdinal, 0b0011'1000'0000'0000, 9>;
+
+// COBR: opcode | src1 | src2 | M1 | displacement | T S2
+using CobrM1 = ControlFlag<13>;
+using CobrDisplacement = FieldVector<Ordinal, Ordinal, 2, 11>;
+using BranchHint = ControlFlag<1>;
+using CobrS2 = ControlFlag<0>;
+using CobrOperands = Description<Ordinal, SrcDestPattern, Src2Pattern, CobrM1, CobrDisplacement, BranchHint, CobrS2>;
+using CobrModeBit = Pattern<Ordinal, ByteOrdinal, 0b0010'0000'0000'0000, 11>;
+
+// CTRL: opcode | displacement | T 0
+using CtrlDisplacement = FieldVector<Ordinal, Ordinal, 2, 22>;
+using CtrlOperands = Description<Ordinal, CtrlDisplacement, BranchHint>;
+
+// MEMA: opcode | src/dst | abase | mode 0 | offset
+// MEMB: opcode | src/dst | abase | mode 1 | scale 00 | index (+ displacement word)
+using MemTypeB = ControlFlag<12>;
+using MemaUsesAbase = ControlFlag<13>;
+using MemaOffset = FieldVector<Ordinal, Ordinal, 0, 12>;
+using MembMode = FieldVector<Ordinal, ByteOrdinal, 10, 4>;
+using MembScale = FieldVector<Ordinal, ByteOrdinal, 7, 3>;
+using MemaOperands = Description<Ordinal, SrcDestPattern, Src2Pattern, MemaUsesAbase, MemaOffset>;
+using MembOperands = Description<Ordinal, SrcDestPattern, Src2Pattern, MembMode, MembScale, Src1Pattern>;
+
+/**
+ * MEM addressing modes, the MEMB values are bits 13:10 of the instruction
+ * and the MEMA forms reuse the unassigned codes with the same top bit
+ */
+enum class AddressingMode : ByteOrdinal {
+    None = 0b0010, // not a MEM instruction
+    Offset = 0b0000,
+    AbaseOffset = 0b1000,
+    Abase = 0b0100,
+    IPDisplacement = 0b0101,
+    Reserved = 0b0110,
+    AbaseIndex = 0b0111,
+    Displacement = 0b1100,
+    AbaseDisplacement = 0b1101,
+    IndexDisplacement = 0b1110,
+    AbaseIndexDisplacement = 0b1111,
+};
+constexpr bool usesAbase(AddressingMode mode) noexcept {
+    return mode == AddressingMode::AbaseOffset || mode == AddressingMode::Abase || mode == AddressingMode::AbaseIndex ||
+        mode == AddressingMode::AbaseDisplacement || mode == AddressingMode::AbaseIndexDisplacement;
+}
+constexpr bool usesIndex(AddressingMode mode) noexcept {
+    return mode == AddressingMode::AbaseIndex || mode == AddressingMode::IndexDisplacement || mode == AddressingMode::AbaseIndexDisplacement;
+}
+
+/**
+ * Number of words taken by the instruction starting with this word, only
+ * MEMB forms with a displacement are two words long
+ */
+constexpr std::size_t instructionLength(Ordinal word) noexcept {
+    // evaluated without short circuits so that it stays branch free
+    auto mode = MembMode::decode(word);
+    auto displacement = ((mode & 0b1000) != 0) | (mode == 0b0101);
+    return 1 + static_cast<std::size_t>((StandardOpcodePattern::decode(word) >= 0x80) & MemTypeB::decode(word) & displacement);
+}
+static_assert(instructionLength(0x8C80'3000) == 2); // lda disp, g0
+static_assert(instructionLength(0x8C80'0010) == 1); // lda 0x10, g0
+static_assert(instructionLength(0x5C80'0E10) == 1); // mov 16, g0
+
+/**
+ * Instruction modifier bits, the M and S bits keep their meaning from the
+ * REG format, COBR only has M1, S2 and T, CTRL only has T
+ */
+namespace InstructionFlags {
+    constexpr ByteOrdinal S1 = 0b0000'0001;
+    constexpr ByteOrdinal S2 = 0b0000'0010;
+    constexpr ByteOrdinal M1 = 0b0000'0100;
+    constexpr ByteOrdinal M2 = 0b0000'1000;
+    constexpr ByteOrdinal M3 = 0b0001'0000;
+    constexpr ByteOrdinal T = 0b0010'0000;
+} // end namespace InstructionFlags
+
+/**
+ * A decoded instruction. The register fields sit at the same place in every
+ * format that has them so they are read straight out of the first word:
+ * srcDest is src1 for COBR, src2 is abase and src1 is index for MEM.
+ * displacement is the byte displacement for branches, the offset for MEMA and
+ * the displacement word for MEMB.
+ */
+struct Instruction {
+    Ordinal word;
+    int32_t displacement;
+    HalfOrdinal opcode;
+    Format format;
+    AddressingMode mode;
+    ByteOrdinal flags;
+    ByteOrdinal length;
+    constexpr ByteOrdinal srcDest() const noexcept { return SrcDestPattern::decode(word); }
+    constexpr ByteOrdinal src1() const noexcept { return Src1Pattern::decode(word); }
+    constexpr ByteOrdinal src2() const noexcept { return Src2Pattern::decode(word); }
+    constexpr ByteOrdinal scale() const noexcept { return MembScale::decode(word); }
+    constexpr bool has(ByteOrdinal flag) const noexcept { return (flags & flag) != 0; }
+    constexpr std::size_t size() const noexcept { return length * sizeof(Ordinal); }
+};
+static_assert(sizeof(Instruction) == 16);
+
+/**
+ * Decode a single instruction, next is only read by two word MEMB forms.
+ * The fields of every format are extracted and the right ones masked in
+ * so that a mix of formats does not mispredict on every instruction.
+ */
+constexpr Instruction decodeInstruction(Ordinal word, Ordinal next = 0) noexcept {
+    using namespace InstructionFlags;
+    auto format = formatOf(word);
+    auto length = static_cast<ByteOrdinal>(instructionLength(word));
+    auto isMemB = static_cast<Ordinal>(MemTypeB::decode(word));
+    auto branchHint = static_cast<ByteOrdinal>(BranchHint::decode(word) * T);
+    // all ones for the format being decoded
+    auto isCtrl = -static_cast<Ordinal>(format == Format::CTRL);
+    auto isCobr = -static_cast<Ordinal>(format == Format::COBR);
+    auto isReg = -static_cast<Ordinal>(format == Format::REG);
+    auto isMem = -static_cast<Ordinal>(format == Format::MEM);
+    auto flags = (isCtrl & branchHint) |
+        (isCobr & (CobrModeBit::decode(word) | (CobrS2::decode(word) * S2) | branchHint)) |
+        (isReg & (RegSpecialBits::decode(word) | RegModeBits::decode(word)));
+    // MEMB keeps its mode bits, MEMA is folded into the unused codes
+    auto memMode = (isMemB * MembMode::decode(word)) | (!isMemB * MemaUsesAbase::decode(word) * 0b1000);
+    auto mode = (isMem & memMode) | (~isMem & static_cast<Ordinal>(AddressingMode::None));
+    auto displacement = (isCtrl & static_cast<Ordinal>(signExtend<24>(CtrlDisplacement::encode(CtrlDisplacement::decode(word))))) |
+        (isCobr & static_cast<Ordinal>(signExtend<13>(CobrDisplacement::encode(CobrDisplacement::decode(word))))) |
+        (isMem & ((next & -static_cast<Ordinal>(length == 2)) | (MemaOffset::decode(word) & (isMemB - 1))));
+    Instruction result { };
+    result.word = word;
+    result.displacement = static_cast<int32_t>(displacement);
+    result.opcode = Opcode16Builder::encode(StandardOpcodePattern::decode(word), static_cast<HalfOrdinal>(ExtendedOpcodePattern::decode(word) & isReg));
+    result.format = format;
+    result.mode = static_cast<AddressingMode>(mode);
+    result.flags = static_cast<ByteOrdinal>(flags);
+    result.length = length;
+    return result;
+}
+static_assert(decodeInstruction(0x0800'0010).displacement == 16); // b .+16
+static_assert(decodeInstruction(0x08FF'FFFC).displacement == -4); // b .-4
+static_assert(decodeInstruction(0x5C80'0E10).opcode == 0x5CC);
+static_assert(decodeInstruction(0x5C80'0E10).has(InstructionFlags::M1));
+static_assert(decodeInstruction(0x3A84'7FF8).displacement == -8);
+static_assert(decodeInstruction(0x8C80'3000, 0x1234).displacement == 0x1234);
+static_assert(decodeInstruction(0x8C80'3000).mode == AddressingMode::Displacement);
+
+/**
+ * The address a MEM instruction refers to, IP relative forms are relative to
+ * the end of the two word instruction
+ */
+constexpr Ordinal effectiveAddress(const Instruction& instruction, Ordinal ip, std::span<const Ordinal, 32> registers) noexcept {
+    auto base = usesAbase(instruction.mode) ? registers[instruction.src2()] : 0;
+    auto index = usesIndex(instruction.mode) ? (registers[instruction.src1()] << instruction.scale()) : 0;
+    auto relative = instruction.mode == AddressingMode::IPDisplacement ? (ip + 8) : 0;
+    return base + index + relative + static_cast<Ordinal>(instruction.displacement);
+}
+
+struct DecodeProgress {
+    std::size_t words;
+    std::size_t instructions;
+};
+/**
+ * Decode as many instructions as fit in output. A MEMB instruction whose
+ * displacement word is past the end of words is left for the next call.
+ */
+inline DecodeProgress decodeInstructions(std::span<const Ordinal> words, std::span<Instruction> output) noexcept {
+    std::size_t position = 0;
+    std::size_t count = 0;
+    // every instruction in the bulk loop is guaranteed its second word
+    while (count < output.size() && (position + 1) < words.size()) {
+        auto decoded = decodeInstruction(words[position], words[position + 1]);
+        output[count++] = decoded;
+        position += decoded.length;
+    }
+    if (count < output.size() && position < words.size() && instructionLength(words[position]) == 1) {
+        output[count++] = decodeInstruction(words[position]);
+        ++position;
+    }
+    return { position, count };
+}
+
+} // end namespace BinaryManipulation::i960
+#endif // BinaryManipulation_i960_h__
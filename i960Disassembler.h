@@ -0,0 +1,320 @@
+/**
+ * @file
+ * Text disassembly of i960 instructions, single word and whole image
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_i960Disassembler_h__
+#define BinaryManipulation_i960Disassembler_h__
+#include "BinaryManipulation.h"
+#include "ChunkPipeline.h"
+#include "Formatting.h"
+#include "i960.h"
+#include <array>
+#include <span>
+#include <string_view>
+#include <vector>
+namespace BinaryManipulation::i960 {
+
+/**
+ * How the operands of an instruction are printed
+ */
+enum class OperandKind : ByteOrdinal {
+    Invalid,
+    None,
+    Target, // CTRL branch target
+    Dest, // COBR test, the condition is written into src1
+    CompareBranch, // src1, src2, target
+    Reg3, // src1, src2, dst
+    RegSources, // src1, src2
+    RegMove, // src1, dst
+    RegSource, // src1
+    Load, // mem, dst
+    Store, // src, mem
+    Memory, // mem
+};
+struct OpcodeInfo {
+    std::string_view mnemonic;
+    OperandKind operands = OperandKind::Invalid;
+};
+/**
+ * Indexed by the 12-bit opcode, only REG opcodes use the low nibble
+ */
+constexpr auto OpcodeTable = [] {
+    std::array<OpcodeInfo, 0x1000> table { };
+    auto set = [&table](HalfOrdinal opcode, std::string_view mnemonic, OperandKind kind) { table[opcode] = { mnemonic, kind }; };
+    using enum OperandKind;
+    set(0x080, "b", Target); set(0x090, "call", Target); set(0x0A0, "ret", None); set(0x0B0, "bal", Target);
+    constexpr std::string_view Branches[] { "bno", "bg", "be", "bge", "bl", "bne", "ble", "bo" };
+    constexpr std::string_view Faults[] { "faultno", "faultg", "faulte", "faultge", "faultl", "faultne", "faultle", "faulto" };
+    constexpr std::string_view Tests[] { "testno", "testg", "teste", "testge", "testl", "testne", "testle", "testo" };
+    constexpr std::string_view CompareOrdinal[] { "", "cmpobg", "cmpobe", "cmpobge", "cmpobl", "cmpobne", "cmpoble", "" };
+    constexpr std::string_view CompareInteger[] { "cmpibno", "cmpibg", "cmpibe", "cmpibge", "cmpibl", "cmpibne", "cmpible", "cmpibo" };
+    for (HalfOrdinal i = 0; i < 8; ++i) {
+        set(0x100 + (i << 4), Branches[i], Target);
+        set(0x180 + (i << 4), Faults[i], None);
+        set(0x200 + (i << 4), Tests[i], Dest);
+        set(0x380 + (i << 4), CompareInteger[i], CompareBranch);
+        if (!CompareOrdinal[i].empty()) {
+            set(0x300 + (i << 4), CompareOrdinal[i], CompareBranch);
+        }
+    }
+    set(0x300, "bbc", CompareBranch); set(0x370, "bbs", CompareBranch);
+    // REG
+    set(0x580, "notbit", Reg3); set(0x581, "and", Reg3); set(0x582, "andnot", Reg3); set(0x583, "setbit", Reg3);
+    set(0x584, "notand", Reg3); set(0x586, "xor", Reg3); set(0x587, "or", Reg3); set(0x588, "nor", Reg3);
+    set(0x589, "xnor", Reg3); set(0x58A, "not", RegMove); set(0x58B, "ornot", Reg3); set(0x58C, "clrbit", Reg3);
+    set(0x58D, "notor", Reg3); set(0x58E, "nand", Reg3); set(0x58F, "alterbit", Reg3);
+    set(0x590, "addo", Reg3); set(0x591, "addi", Reg3); set(0x592, "subo", Reg3); set(0x593, "subi", Reg3);
+    set(0x598, "shro", Reg3); set(0x59A, "shrdi", Reg3); set(0x59B, "shri", Reg3); set(0x59C, "shlo", Reg3);
+    set(0x59D, "rotate", Reg3); set(0x59E, "shli", Reg3);
+    set(0x5A0, "cmpo", RegSources); set(0x5A1, "cmpi", RegSources); set(0x5A2, "concmpo", RegSources); set(0x5A3, "concmpi", RegSources);
+    set(0x5A4, "cmpinco", Reg3); set(0x5A5, "cmpinci", Reg3); set(0x5A6, "cmpdeco", Reg3); set(0x5A7, "cmpdeci", Reg3);
+    set(0x5AC, "scanbyte", RegSources); set(0x5AE, "chkbit", RegSources);
+    set(0x5B0, "addc", Reg3); set(0x5B2, "subc", Reg3);
+    set(0x5CC, "mov", RegMove); set(0x5DC, "movl", RegMove); set(0x5EC, "movt", RegMove); set(0x5FC, "movq", RegMove);
+    set(0x610, "atmod", Reg3); set(0x612, "atadd", Reg3);
+    set(0x640, "spanbit", RegMove); set(0x641, "scanbit", RegMove); set(0x642, "daddc", Reg3); set(0x643, "dsubc", Reg3);
+    set(0x644, "dmovt", RegMove); set(0x645, "modac", Reg3);
+    set(0x650, "modify", Reg3); set(0x651, "extract", Reg3); set(0x654, "modtc", Reg3); set(0x655, "modpc", Reg3);
+    set(0x660, "calls", RegSource); set(0x66B, "mark", None); set(0x66C, "fmark", None); set(0x66D, "flushreg", None);
+    set(0x66F, "syncf", None);
+    set(0x670, "emul", Reg3); set(0x671, "ediv", Reg3);
+    set(0x701, "mulo", Reg3); set(0x708, "remo", Reg3); set(0x70B, "divo", Reg3);
+    set(0x741, "muli", Reg3); set(0x748, "remi", Reg3); set(0x749, "modi", Reg3); set(0x74B, "divi", Reg3);
+    // MEM
+    set(0x800, "ldob", Load); set(0x820, "stob", Store); set(0x840, "bx", Memory); set(0x850, "balx", Load);
+    set(0x860, "callx", Memory); set(0x880, "ldos", Load); set(0x8A0, "stos", Store); set(0x8C0, "lda", Load);
+    set(0x900, "ld", Load); set(0x920, "st", Store); set(0x980, "ldl", Load); set(0x9A0, "stl", Store);
+    set(0xA00, "ldt", Load); set(0xA20, "stt", Store); set(0xB00, "ldq", Load); set(0xB20, "stq", Store);
+    set(0xC00, "ldib", Load); set(0xC20, "stib", Store); set(0xC80, "ldis", Load); set(0xCA0, "stis", Store);
+    return table;
+}();
+static_assert(OpcodeTable[0x5CC].mnemonic == "mov");
+static_assert(OpcodeTable[0x3A0].mnemonic == "cmpibe");
+static_assert(OpcodeTable[0x5CD].operands == OperandKind::Invalid);
+
+constexpr std::array<std::string_view, 32> RegisterNames {
+    "pfp", "sp", "rip", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+    "g0", "g1", "g2", "g3", "g4", "g5", "g6", "g7", "g8", "g9", "g10", "g11", "g12", "g13", "g14", "fp",
+};
+/**
+ * The longest line disassembleWords will write: address, two words, the
+ * mnemonic and three operands of which the memory operand is the widest
+ */
+constexpr std::size_t DisassemblyLineLength = 128;
+constexpr std::size_t MnemonicColumnWidth = 10;
+
+namespace Disassembly {
+    inline bool writeRegister(FormatBuffer& out, ByteOrdinal index, bool literal, bool special) noexcept {
+        if (literal) {
+            return out.writeDecimal(index);
+        } else if (special) {
+            return out.write("sf") && out.writeDecimal(index);
+        } else {
+            return out.write(RegisterNames[index & 0x1F]);
+        }
+    }
+    inline bool writeAddress(FormatBuffer& out, Ordinal address) noexcept {
+        return out.write("0x") && out.writeHex(address);
+    }
+    inline bool writeMemory(FormatBuffer& out, const Instruction& instruction, Ordinal address) noexcept {
+        auto displacement = static_cast<Ordinal>(instruction.displacement);
+        auto abase = [&] { return out.write('(') && out.write(RegisterNames[instruction.src2()]) && out.write(')'); };
+        auto index = [&] {
+            return out.write('[') && out.write(RegisterNames[instruction.src1()]) && out.write('*') &&
+                out.writeDecimal(1 << instruction.scale()) && out.write(']');
+        };
+        switch (instruction.mode) {
+            case AddressingMode::Offset:
+            case AddressingMode::Displacement:
+                return writeAddress(out, displacement);
+            case AddressingMode::AbaseOffset:
+            case AddressingMode::AbaseDisplacement:
+                return writeAddress(out, displacement) && abase();
+            case AddressingMode::Abase:
+                return abase();
+            case AddressingMode::IPDisplacement:
+                // relative to the address of the next instruction
+                return writeAddress(out, address + 8 + displacement);
+            case AddressingMode::AbaseIndex:
+                return abase() && index();
+            case AddressingMode::IndexDisplacement:
+                return writeAddress(out, displacement) && index();
+            case AddressingMode::AbaseIndexDisplacement:
+                return writeAddress(out, displacement) && abase() && index();
+            default:
+                return false;
+        }
+    }
+} // end namespace Disassembly
+
+/**
+ * Write the assembly text of an already decoded instruction at the given
+ * address (branch targets are absolute). Returns false if the instruction
+ * is not recognized or the buffer is full; the buffer is left untouched.
+ */
+inline bool disassemble(const Instruction& instruction, Ordinal address, FormatBuffer& out) noexcept {
+    using namespace InstructionFlags;
+    using Disassembly::writeRegister;
+    const auto& info = OpcodeTable[instruction.opcode & 0xFFF];
+    if (info.operands == OperandKind::Invalid || instruction.mode == AddressingMode::Reserved) {
+        return false;
+    }
+    auto mark = out.size();
+    auto src1 = [&] { return writeRegister(out, instruction.src1(), instruction.has(M1), instruction.has(S1)); };
+    auto src2 = [&] { return writeRegister(out, instruction.src2(), instruction.has(M2), instruction.has(S2)); };
+    auto dst = [&] { return writeRegister(out, instruction.srcDest(), instruction.has(M3), false); };
+    auto memory = [&] { return Disassembly::writeMemory(out, instruction, address); };
+    auto target = [&] { return Disassembly::writeAddress(out, address + static_cast<Ordinal>(instruction.displacement)); };
+    auto comma = [&] { return out.write(", "); };
+    bool ok = out.write(info.mnemonic);
+    if (info.operands != OperandKind::None) {
+        for (auto i = info.mnemonic.size(); i < MnemonicColumnWidth; ++i) {
+            ok = ok && out.write(' ');
+        }
+    }
+    switch (info.operands) {
+        case OperandKind::Target: ok = ok && target(); break;
+        case OperandKind::Dest: ok = ok && writeRegister(out, instruction.srcDest(), false, false); break;
+        case OperandKind::CompareBranch:
+            // COBR keeps src1 in the src/dst field and its literal bit is M1
+            ok = ok && writeRegister(out, instruction.srcDest(), instruction.has(M1), false) && comma() &&
+                writeRegister(out, instruction.src2(), false, instruction.has(S2)) && comma() && target();
+            break;
+        case OperandKind::Reg3: ok = ok && src1() && comma() && src2() && comma() && dst(); break;
+        case OperandKind::RegSources: ok = ok && src1() && comma() && src2(); break;
+        case OperandKind::RegMove: ok = ok && src1() && comma() && dst(); break;
+        case OperandKind::RegSource: ok = ok && src1(); break;
+        case OperandKind::Load: ok = ok && memory() && comma() && dst(); break;
+        case OperandKind::Store: ok = ok && dst() && comma() && memory(); break;
+        case OperandKind::Memory: ok = ok && memory(); break;
+        default: break;
+    }
+    if (!ok) {
+        out.truncate(mark);
+    }
+    return ok;
+}
+
+/**
+ * Disassemble words as one line per instruction: address, the instruction
+ * words and the text, unknown words are written as .word directives.
+ * Stops when out cannot hold another line or at a MEMB instruction that
+ * is missing its displacement word. Returns the number of words consumed.
+ */
+inline std::size_t disassembleWords(std::span<const Ordinal> words, Ordinal address, FormatBuffer& out) noexcept {
+    constexpr std::size_t BlockSize = 256;
+    std::array<Instruction, BlockSize> block;
+    std::size_t position = 0;
+    while (position < words.size()) {
+        auto progress = decodeInstructions(words.subspan(position), block);
+        if (progress.instructions == 0) {
+            break;
+        }
+        for (std::size_t i = 0; i < progress.instructions; ++i) {
+            const auto& instruction = block[i];
+            if (out.full(DisassemblyLineLength)) {
+                return position;
+            }
+            out.writeHex(address, 8);
+            out.write(": ");
+            out.writeHex(words[position], 8);
+            out.write(' ');
+            if (instruction.length == 2) {
+                out.writeHex(words[position + 1], 8);
+            } else {
+                out.write("        ");
+            }
+            out.write("  ");
+            if (!disassemble(instruction, address, out)) {
+                out.write(".word     0x");
+                out.writeHex(words[position], 8);
+                if (instruction.length == 2) {
+                    out.write(", 0x");
+                    out.writeHex(words[position + 1], 8);
+                }
+            }
+            out.write('\n');
+            position += instruction.length;
+            address += static_cast<Ordinal>(instruction.size());
+        }
+    }
+    return position;
+}
+
+/**
+ * Disassemble a whole image on several threads, calling sink(std::string_view)
+ * with the text in image order until it returns false. Instructions may
+ * straddle chunks so the chunk starting points are resolved first with a
+ * cheap length only pass, then the chunks are formatted on the same threads
+ * while the calling thread hands the finished ones to sink.
+ */
+template<typename Sink>
+bool disassembleImage(std::span<const Ordinal> words, Ordinal baseAddress, Sink&& sink, unsigned threads = 0, std::size_t wordsPerChunk = 1 << 16) {
+    auto chunks = (words.size() + wordsPerChunk - 1) / wordsPerChunk;
+    WorkerPool pool(threads);
+    // overrun[c][s]: how far the last instruction of chunk c runs into the
+    // next chunk when decoding starts s words into chunk c
+    std::vector<std::array<ByteOrdinal, 2>> overrun(chunks);
+    pool.forEach(chunks, [&](std::size_t c) {
+        auto first = c * wordsPerChunk;
+        auto last = std::min(first + wordsPerChunk, words.size());
+        for (std::size_t start = 0; start < 2; ++start) {
+            auto position = first + start;
+            while (position < last) {
+                position += instructionLength(words[position]);
+            }
+            overrun[c][start] = static_cast<ByteOrdinal>(position - last);
+        }
+    });
+    std::vector<std::size_t> starts(chunks + 1, 0);
+    for (std::size_t c = 0; c < chunks; ++c) {
+        starts[c + 1] = ((c + 1) * wordsPerChunk) + overrun[c][starts[c] - (c * wordsPerChunk)];
+    }
+    starts[chunks] = words.size();
+    return pool.formatInOrder(chunks, [&](std::size_t c, std::vector<char>& buffer) {
+        auto first = std::min(starts[c], words.size());
+        auto last = std::max(first, std::min(starts[c + 1], words.size()));
+        buffer.resize((last - first + 1) * DisassemblyLineLength);
+        FormatBuffer out(buffer);
+        auto done = disassembleWords(words.subspan(first, last - first), baseAddress + static_cast<Ordinal>(first * sizeof(Ordinal)), out);
+        auto fits = true;
+        if (first + done < last) {
+            // a trailing MEMB without its displacement
+            fits = out.writeHex(baseAddress + static_cast<Ordinal>((first + done) * sizeof(Ordinal)), 8) &&
+                   out.write(": ") &&
+                   out.writeHex(words[first + done], 8) &&
+                   out.write("           .word     0x") &&
+                   out.writeHex(words[first + done], 8) &&
+                   out.write('\n');
+        }
+        buffer.resize(out.size());
+        return fits;
+    }, sink);
+}
+
+} // end namespace BinaryManipulation::i960
+#endif // BinaryManipulation_i960Disassembler_h__
@@ -0,0 +1,335 @@
+/**
+ * @file
+ * Building i960 instructions from typed operands, singly or in bulk
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_i960Encoder_h__
+#define BinaryManipulation_i960Encoder_h__
+#include "BinaryManipulation.h"
+#include "i960.h"
+#include "i960Disassembler.h"
+#include <array>
+#include <optional>
+#include <span>
+#include <string_view>
+namespace BinaryManipulation::i960 {
+
+/**
+ * An unsigned operand that must fit in the given number of bits. Constants
+ * are checked when the program is compiled, values only known at runtime
+ * go through checked() or wrap().
+ */
+template<std::size_t bits>
+class OperandValue final {
+    public:
+        static constexpr std::size_t Bits = bits;
+        static constexpr Ordinal Limit = computeMaskFromLength<Ordinal>(bits);
+        consteval OperandValue(Ordinal value) : _value(value) {
+            if (value > Limit) {
+                // not a constant expression so it becomes a compile error
+                throw "operand does not fit in its field";
+            }
+        }
+        static constexpr std::optional<OperandValue> checked(Ordinal value) noexcept {
+            if (value > Limit) {
+                return std::nullopt;
+            }
+            return OperandValue(value, Unchecked { });
+        }
+        static constexpr OperandValue wrap(Ordinal value) noexcept { return OperandValue(value & Limit, Unchecked { }); }
+        constexpr Ordinal value() const noexcept { return _value; }
+    private:
+        struct Unchecked { };
+        constexpr OperandValue(Ordinal value, Unchecked) noexcept : _value(value) { }
+    private:
+        Ordinal _value;
+};
+/**
+ * A signed, word aligned branch displacement in bytes
+ */
+template<std::size_t bits>
+class BranchDisplacement final {
+    public:
+        static constexpr std::size_t Bits = bits;
+        static constexpr int32_t Minimum = -(1 << (bits - 1));
+        static constexpr int32_t Maximum = (1 << (bits - 1)) - 4;
+        static constexpr bool fits(int32_t value) noexcept { return value >= Minimum && value <= Maximum && (value & 0b11) == 0; }
+        consteval BranchDisplacement(int32_t value) : _value(value) {
+            if (!fits(value)) {
+                throw "branch displacement out of range or not word aligned";
+            }
+        }
+        static constexpr std::optional<BranchDisplacement> checked(int32_t value) noexcept {
+            if (!fits(value)) {
+                return std::nullopt;
+            }
+            return BranchDisplacement(value, Unchecked { });
+        }
+        constexpr int32_t value() const noexcept { return _value; }
+    private:
+        struct Unchecked { };
+        constexpr BranchDisplacement(int32_t value, Unchecked) noexcept : _value(value) { }
+    private:
+        int32_t _value;
+};
+// the operand types can never be wider than the fields they are written into
+static_assert(OperandValue<5>::Bits == FieldBits<Src1Pattern> && OperandValue<5>::Bits == FieldBits<SrcDestPattern>);
+static_assert(OperandValue<12>::Bits == FieldBits<MemaOffset>);
+static_assert(BranchDisplacement<24>::Bits == FieldBits<CtrlDisplacement> + 2);
+static_assert(BranchDisplacement<13>::Bits == FieldBits<CobrDisplacement> + 2);
+
+using Literal = OperandValue<5>;
+using CtrlTarget = BranchDisplacement<24>;
+using CobrTarget = BranchDisplacement<13>;
+
+struct Register {
+    OperandValue<5> index;
+};
+constexpr Register r0 { 0 }, r1 { 1 }, r2 { 2 }, r3 { 3 }, r4 { 4 }, r5 { 5 }, r6 { 6 }, r7 { 7 },
+          r8 { 8 }, r9 { 9 }, r10 { 10 }, r11 { 11 }, r12 { 12 }, r13 { 13 }, r14 { 14 }, r15 { 15 },
+          g0 { 16 }, g1 { 17 }, g2 { 18 }, g3 { 19 }, g4 { 20 }, g5 { 21 }, g6 { 22 }, g7 { 23 },
+          g8 { 24 }, g9 { 25 }, g10 { 26 }, g11 { 27 }, g12 { 28 }, g13 { 29 }, g14 { 30 }, g15 { 31 };
+constexpr Register pfp = r0, sp = r1, rip = r2, fp = g15;
+
+/**
+ * A register or a literal, constant integers are taken as literals
+ */
+struct Source {
+    ByteOrdinal field;
+    bool literal;
+    constexpr Source(Register value) noexcept : field(static_cast<ByteOrdinal>(value.index.value())), literal(false) { }
+    constexpr Source(Literal value) noexcept : field(static_cast<ByteOrdinal>(value.value())), literal(true) { }
+    consteval Source(Ordinal value) : Source(Literal { value }) { }
+};
+
+/**
+ * An opcode that is known to exist and to belong to the given format,
+ * a mnemonic is looked up when the program is compiled
+ */
+template<Format format>
+class OpcodeOf final {
+    public:
+        consteval OpcodeOf(const char* mnemonic) : _value(find(mnemonic)) { }
+        static constexpr std::optional<OpcodeOf> checked(HalfOrdinal opcode) noexcept {
+            if (opcode >= OpcodeTable.size() || OpcodeTable[opcode].operands == OperandKind::Invalid || formatOfOpcode(opcode) != format) {
+                return std::nullopt;
+            }
+            return OpcodeOf(opcode, Unchecked { });
+        }
+        constexpr HalfOrdinal value() const noexcept { return _value; }
+    private:
+        static constexpr Format formatOfOpcode(HalfOrdinal opcode) noexcept {
+            return formatOf(static_cast<Ordinal>(ShiftStandardOpcodeIntoOpcode16::decode(opcode)) << 24);
+        }
+        static consteval HalfOrdinal find(std::string_view mnemonic) {
+            for (HalfOrdinal opcode = 0; opcode < OpcodeTable.size(); ++opcode) {
+                if (OpcodeTable[opcode].mnemonic == mnemonic && formatOfOpcode(opcode) == format) {
+                    return opcode;
+                }
+            }
+            throw "no instruction with this mnemonic in this format";
+        }
+        struct Unchecked { };
+        constexpr OpcodeOf(HalfOrdinal value, Unchecked) noexcept : _value(value) { }
+    private:
+        HalfOrdinal _value;
+};
+using CtrlOpcode = OpcodeOf<Format::CTRL>;
+using CobrOpcode = OpcodeOf<Format::COBR>;
+using RegOpcode = OpcodeOf<Format::REG>;
+using MemOpcode = OpcodeOf<Format::MEM>;
+
+/**
+ * Everything needed to encode an instruction of any format, laid out like
+ * the decoded Instruction so the two convert without looking at the format
+ */
+struct InstructionFields {
+    int32_t displacement;
+    HalfOrdinal opcode;
+    AddressingMode mode;
+    ByteOrdinal flags;
+    ByteOrdinal srcDest;
+    ByteOrdinal src1;
+    ByteOrdinal src2;
+    ByteOrdinal scale;
+};
+static_assert(sizeof(InstructionFields) == 12);
+
+constexpr InstructionFields fieldsOf(const Instruction& instruction) noexcept {
+    return { instruction.displacement, instruction.opcode, instruction.mode, instruction.flags,
+        instruction.srcDest(), instruction.src1(), instruction.src2(), instruction.scale() };
+}
+
+enum class Scale : ByteOrdinal {
+    By1,
+    By2,
+    By4,
+    By8,
+    By16,
+};
+/**
+ * A memory operand, the shortest encoding is picked for the address given
+ */
+struct MemoryOperand {
+    AddressingMode mode;
+    ByteOrdinal abase = 0;
+    ByteOrdinal index = 0;
+    Scale scale = Scale::By1;
+    Ordinal displacement = 0;
+    static constexpr bool fitsOffset(Ordinal value) noexcept { return value <= MemaOffset::Mask; }
+    static constexpr MemoryOperand absolute(Ordinal address) noexcept {
+        return { fitsOffset(address) ? AddressingMode::Offset : AddressingMode::Displacement, 0, 0, Scale::By1, address };
+    }
+    static constexpr MemoryOperand based(Register abase, Ordinal offset = 0) noexcept {
+        return { fitsOffset(offset) ? AddressingMode::AbaseOffset : AddressingMode::AbaseDisplacement,
+            static_cast<ByteOrdinal>(abase.index.value()), 0, Scale::By1, offset };
+    }
+    static constexpr MemoryOperand indexed(Register abase, Register index, Scale scale, Ordinal displacement = 0) noexcept {
+        return { displacement == 0 ? AddressingMode::AbaseIndex : AddressingMode::AbaseIndexDisplacement,
+            static_cast<ByteOrdinal>(abase.index.value()), static_cast<ByteOrdinal>(index.index.value()), scale, displacement };
+    }
+    static constexpr MemoryOperand indexed(Register index, Scale scale, Ordinal displacement) noexcept {
+        return { AddressingMode::IndexDisplacement, 0, static_cast<ByteOrdinal>(index.index.value()), scale, displacement };
+    }
+    /// relative to the address of the instruction following this one
+    static constexpr MemoryOperand relative(int32_t displacement) noexcept {
+        return { AddressingMode::IPDisplacement, 0, 0, Scale::By1, static_cast<Ordinal>(displacement) };
+    }
+};
+
+// typed builders, the operand kinds are checked by the compiler
+constexpr InstructionFields ctrl(CtrlOpcode opcode, CtrlTarget target = 0, bool hint = false) noexcept {
+    return { target.value(), opcode.value(), AddressingMode::None, static_cast<ByteOrdinal>(hint * InstructionFlags::T), 0, 0, 0, 0 };
+}
+constexpr InstructionFields cobr(CobrOpcode opcode, Source src1, Register src2, CobrTarget target, bool hint = false) noexcept {
+    auto flags = (src1.literal * InstructionFlags::M1) | (hint * InstructionFlags::T);
+    return { target.value(), opcode.value(), AddressingMode::None, static_cast<ByteOrdinal>(flags),
+        src1.field, 0, static_cast<ByteOrdinal>(src2.index.value()), 0 };
+}
+constexpr InstructionFields reg(RegOpcode opcode, Source src1, Source src2, Register dst) noexcept {
+    auto flags = (src1.literal * InstructionFlags::M1) | (src2.literal * InstructionFlags::M2);
+    return { 0, opcode.value(), AddressingMode::None, static_cast<ByteOrdinal>(flags),
+        static_cast<ByteOrdinal>(dst.index.value()), src1.field, src2.field, 0 };
+}
+/// two operand REG instructions (mov, not, scanbit...) leave src2 clear
+constexpr InstructionFields reg(RegOpcode opcode, Source src, Register dst) noexcept {
+    return reg(opcode, src, r0, dst);
+}
+/// mark, fmark, flushreg and syncf have no operands
+constexpr InstructionFields reg(RegOpcode opcode) noexcept {
+    return reg(opcode, r0, r0, r0);
+}
+constexpr InstructionFields mem(MemOpcode opcode, Register srcDest, MemoryOperand address) noexcept {
+    return { static_cast<int32_t>(address.displacement), opcode.value(), address.mode, 0,
+        static_cast<ByteOrdinal>(srcDest.index.value()), address.index, address.abase, static_cast<ByteOrdinal>(address.scale) };
+}
+
+struct EncodedInstruction {
+    std::array<Ordinal, 2> words;
+    std::size_t length;
+    constexpr std::span<const Ordinal> view() const noexcept { return { words.data(), length }; }
+};
+/**
+ * Encode any instruction. Every format's encoding is built and the right
+ * one masked in so that a stream of mixed formats never branches; the
+ * second word is only meaningful when length is two.
+ */
+constexpr EncodedInstruction encodeInstruction(const InstructionFields& fields) noexcept {
+    using namespace InstructionFlags;
+    auto [major, extended] = Opcode16Builder::decode(fields.opcode);
+    auto head = OpcodeExtraction::encode(static_cast<ByteOrdinal>(major), HalfOrdinal { 0 });
+    auto format = formatOf(head);
+    auto isCtrl = -static_cast<Ordinal>(format == Format::CTRL);
+    auto isCobr = -static_cast<Ordinal>(format == Format::COBR);
+    auto isReg = -static_cast<Ordinal>(format == Format::REG);
+    auto isMem = -static_cast<Ordinal>(format == Format::MEM);
+    auto flags = static_cast<Ordinal>(fields.flags);
+    auto mode = static_cast<Ordinal>(fields.mode);
+    auto displacement = static_cast<Ordinal>(fields.displacement);
+    auto hint = (flags & T) != 0;
+    // src/dst and src2 are in the same place for everything but CTRL
+    auto operands = SrcDestPattern::encode(Ordinal { fields.srcDest }) | Src2Pattern::encode(Ordinal { fields.src2 });
+    auto ctrl = CtrlOperands::encode(displacement >> 2, bool { hint });
+    auto cobr = operands | CobrOperands::encode(0, 0, false, displacement >> 2, bool { hint }, (flags & S2) != 0) | CobrModeBit::encode(flags);
+    auto reg = operands | ExtendedOpcodePattern::encode(Ordinal { extended }) | RegSpecialBits::encode(flags) | RegModeBits::encode(flags) |
+        Src1Pattern::encode(Ordinal { fields.src1 });
+    // MEMB modes all have bit 2 set, MEMA only keeps its abase bit
+    auto isMemB = (mode & 0b0100) != 0;
+    auto memA = MemaUsesAbase::encode((mode & 0b1000) != 0) | MemaOffset::encode(displacement);
+    auto memB = MemTypeB::encode(true) | MembMode::encode(mode) | MembScale::encode(Ordinal { fields.scale }) | Src1Pattern::encode(Ordinal { fields.src1 });
+    auto mem = operands | (memB & -static_cast<Ordinal>(isMemB)) | (memA & (static_cast<Ordinal>(isMemB) - 1));
+    auto word = head | (isCtrl & ctrl) | (isCobr & cobr) | (isReg & reg) | (isMem & mem);
+    return { { word, displacement }, instructionLength(word) };
+}
+static_assert(encodeInstruction(reg("addo", g0, g1, g2)).words[0] == 0x5994'4010);
+static_assert(encodeInstruction(reg("mov", 16, g1)).words[0] == 0x5C88'0E10);
+static_assert(encodeInstruction(cobr("cmpobe", g2, r3, -16)).words[0] == 0x3290'DFF0);
+static_assert(encodeInstruction(mem("lda", g0, MemoryOperand::absolute(0x1234))).words[0] == 0x8C80'3000);
+static_assert(encodeInstruction(mem("lda", g0, MemoryOperand::absolute(0x10))).length == 1);
+static_assert(encodeInstruction(ctrl("b", -4)).words[0] == 0x08FF'FFFC);
+
+struct EmitProgress {
+    std::size_t instructions;
+    std::size_t words;
+};
+/**
+ * Encode instructions back to back into output until either runs out.
+ * Both words of every instruction are stored and the output only advanced
+ * by its length, so the loop body is the same for every format.
+ */
+inline EmitProgress emitInstructions(std::span<const InstructionFields> input, std::span<Ordinal> output) noexcept {
+    std::size_t count = 0;
+    std::size_t position = 0;
+    auto* out = output.data();
+    // every store in the bulk loop has room for a second word
+    while (count < input.size() && (position + 2) <= output.size()) {
+        auto encoded = encodeInstruction(input[count]);
+        out[position] = encoded.words[0];
+        out[position + 1] = encoded.words[1];
+        position += encoded.length;
+        ++count;
+    }
+    if (count < input.size() && position < output.size()) {
+        if (auto encoded = encodeInstruction(input[count]); encoded.length == 1) {
+            out[position++] = encoded.words[0];
+            ++count;
+        }
+    }
+    return { count, position };
+}
+/**
+ * The number of words emitInstructions needs for all of input
+ */
+inline std::size_t encodedLength(std::span<const InstructionFields> input) noexcept {
+    std::size_t words = 0;
+    for (const auto& fields : input) {
+        words += encodeInstruction(fields).length;
+    }
+    return words;
+}
+
+} // end namespace BinaryManipulation::i960
+#endif // BinaryManipulation_i960Encoder_h__
@@ -0,0 +1,356 @@
+/**
+ * @file
+ * A minimal i960 interpreter used to measure decode and flag handling end to end
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_i960Interpreter_h__
+#define BinaryManipulation_i960Interpreter_h__
+#include "BinaryManipulation.h"
+#include "i960.h"
+#include "i960Encoder.h"
+#include "RegisterFile.h"
+#include <array>
+#include <cstring>
+#include <span>
+#include <vector>
+namespace BinaryManipulation::i960 {
+
+/**
+ * Everything the interpreter knows how to execute, REG/COBR/CTRL/MEM
+ * opcodes are mapped onto these through OperationTable
+ */
+#define BinaryManipulation_i960_Operations(X) \
+    X(Unimplemented) X(Branch) X(BranchAndLink) X(BranchIf) X(BranchIfBit) X(CompareOrdinalAndBranch) \
+    X(CompareIntegerAndBranch) X(AddOrdinal) X(AddInteger) X(SubtractOrdinal) X(SubtractInteger) \
+    X(MultiplyOrdinal) X(And) X(Or) X(Xor) X(Not) X(ShiftLeft) X(ShiftRight) X(Move) X(CompareOrdinal) \
+    X(CompareInteger) X(Mark) X(ForceMark) X(LoadAddress) X(Load) X(Store) X(LoadByte) X(StoreByte) \
+    X(BranchExtended)
+
+enum class Operation : ByteOrdinal {
+#define X(name) name,
+    BinaryManipulation_i960_Operations(X)
+#undef X
+};
+constexpr auto OperationTable = [] {
+    std::array<Operation, 0x1000> table { };
+    using enum Operation;
+    table[0x080] = Branch;
+    table[0x0B0] = BranchAndLink;
+    for (HalfOrdinal mask = 0; mask < 8; ++mask) {
+        table[0x100 | (mask << 4)] = BranchIf;
+        table[0x300 | (mask << 4)] = CompareOrdinalAndBranch;
+        table[0x380 | (mask << 4)] = CompareIntegerAndBranch;
+    }
+    table[0x300] = BranchIfBit;
+    table[0x370] = BranchIfBit;
+    table[0x590] = AddOrdinal; table[0x591] = AddInteger; table[0x592] = SubtractOrdinal; table[0x593] = SubtractInteger;
+    table[0x701] = MultiplyOrdinal; table[0x581] = And; table[0x587] = Or; table[0x586] = Xor; table[0x58A] = Not;
+    table[0x59C] = ShiftLeft; table[0x598] = ShiftRight; table[0x5CC] = Move;
+    table[0x5A0] = CompareOrdinal; table[0x5A1] = CompareInteger; table[0x66B] = Mark; table[0x66C] = ForceMark;
+    table[0x8C0] = LoadAddress; table[0x900] = Load; table[0x920] = Store; table[0x800] = LoadByte; table[0x820] = StoreByte;
+    table[0x840] = BranchExtended;
+    return table;
+}();
+
+// condition codes written by the compare instructions
+constexpr ByteOrdinal ConditionLess = 0b100;
+constexpr ByteOrdinal ConditionEqual = 0b010;
+constexpr ByteOrdinal ConditionGreater = 0b001;
+/**
+ * Branch on condition: the low three bits of the major opcode are the mask
+ * of condition codes taken, an empty mask means "no condition"
+ */
+constexpr bool conditionHolds(HalfOrdinal opcode, ByteOrdinal conditionCode) noexcept {
+    auto mask = (opcode >> 4) & 0b111;
+    return mask == 0 ? conditionCode == 0 : (conditionCode & mask) != 0;
+}
+template<typename T>
+constexpr ByteOrdinal compare(T a, T b) noexcept {
+    return a < b ? ConditionLess : (a == b ? ConditionEqual : ConditionGreater);
+}
+
+enum class StopReason {
+    Limit,
+    Breakpoint,
+    TraceFault,
+    ArithmeticFault,
+    Unimplemented,
+};
+
+/**
+ * The control registers, reading a decoded flag out of them is a plain load
+ */
+template<bool watchable>
+using BasicControlRegisters = BasicRegisterFile<watchable, ArithmeticControls, ProcessControls, TraceControls>;
+using ControlRegisters = BasicControlRegisters<false>;
+
+/**
+ * Runs a flat register file over a power of two sized memory, there are no
+ * frames, faults just stop execution. Each instruction is fetched, decoded
+ * with decodeInstruction and dispatched through a computed goto so the
+ * cost of the decode shows up directly in the instruction rate. The
+ * watchable variant reports writes to armed control register fields.
+ */
+template<bool watchable>
+class BasicInterpreter final {
+    public:
+        using Controls = BasicControlRegisters<watchable>;
+    public:
+        explicit BasicInterpreter(std::size_t memoryBits) : _memory((std::size_t { 1 } << memoryBits) + Slack), _addressMask((std::size_t { 1 } << memoryBits) - 1) { }
+        void load(std::span<const Ordinal> program, Ordinal address) noexcept {
+            for (auto word : program) {
+                store(address, word);
+                address += sizeof(Ordinal);
+            }
+        }
+        constexpr Ordinal& reg(Register which) noexcept { return _registers[which.index.value()]; }
+        constexpr Ordinal& ip() noexcept { return _ip; }
+        constexpr Controls& controls() noexcept { return _controls; }
+        constexpr CachedRegister<ArithmeticControls, watchable>& arithmeticControls() noexcept { return _controls.template get<ArithmeticControls>(); }
+        constexpr CachedRegister<TraceControls, watchable>& traceControls() noexcept { return _controls.template get<TraceControls>(); }
+        constexpr ByteOrdinal conditionCode() const noexcept { return _controls.template get<ArithmeticControls>().template field<ConditionCode>(); }
+        constexpr std::size_t executed() const noexcept { return _executed; }
+        Ordinal loadWord(Ordinal address) const noexcept { return loadFromBytes<Ordinal>(_memory.data() + (address & _addressMask)); }
+        ByteOrdinal loadByte(Ordinal address) const noexcept { return _memory[address & _addressMask]; }
+        void storeByte(Ordinal address, ByteOrdinal value) noexcept { _memory[address & _addressMask] = value; }
+        void store(Ordinal address, Ordinal value) noexcept {
+            auto bytes = std::endian::native == std::endian::little ? value : reverseBytes(value);
+            std::memcpy(_memory.data() + (address & _addressMask), &bytes, sizeof(bytes));
+        }
+        /**
+         * Execute until a stop condition or until limit more instructions ran
+         */
+        StopReason run(std::size_t limit) noexcept(!watchable);
+    private:
+        // room for a word access at the last address
+        static constexpr std::size_t Slack = 8;
+        std::array<Ordinal, 32> _registers { };
+        Ordinal _ip = 0;
+        Controls _controls;
+        std::size_t _executed = 0;
+        std::vector<uint8_t> _memory;
+        std::size_t _addressMask;
+};
+
+using Interpreter = BasicInterpreter<false>;
+using WatchedInterpreter = BasicInterpreter<true>;
+
+template<bool watchable>
+StopReason BasicInterpreter<watchable>::run(std::size_t limit) noexcept(!watchable) {
+    using namespace InstructionFlags;
+#ifdef __GNUC__
+    // labels as values, every handler jumps straight to the next one
+    static const void* const targets[] {
+#define X(name) &&name,
+        BinaryManipulation_i960_Operations(X)
+#undef X
+    };
+#define BinaryManipulation_i960_Dispatch(operation) goto *targets[static_cast<std::size_t>(operation)]
+#else
+#define BinaryManipulation_i960_Dispatch(operation) \
+    switch (operation) { \
+        BinaryManipulation_i960_Operations(BinaryManipulation_i960_Case) \
+    }
+#define BinaryManipulation_i960_Case(name) case Operation::name: goto name;
+#endif
+    auto& r = _registers;
+    Instruction instruction { };
+    Ordinal next = 0;
+    Ordinal src1 = 0;
+    Ordinal src2 = 0;
+    auto end = _executed + limit;
+    auto& ac = arithmeticControls();
+    auto& tc = traceControls();
+    auto setCondition = [&ac](ByteOrdinal code) { ac.template setField<ConditionCode>(code); };
+    auto dst = [&]() -> Ordinal& { return r[instruction.srcDest()]; };
+    // a taken branch may raise a branch trace fault
+    auto branchTo = [&](Ordinal target) {
+        next = target;
+        if (tc.template field<BranchTraceMode>()) {
+            tc.template setField<BranchTraceEvent>(true);
+            return false;
+        }
+        return true;
+    };
+    // overflow is recorded when masked and faults otherwise
+    auto overflow = [&ac]() {
+        if (ac.template field<IntegerOverflowMask>()) {
+            ac.template setField<IntegerOverflowFlag>(true);
+            return true;
+        }
+        return false;
+    };
+Fetch:
+    if (_executed == end) {
+        return StopReason::Limit;
+    }
+    instruction = decodeInstruction(loadWord(_ip), loadWord(_ip + sizeof(Ordinal)));
+    next = _ip + static_cast<Ordinal>(instruction.size());
+    src1 = instruction.has(M1) ? instruction.src1() : r[instruction.src1()];
+    src2 = instruction.has(M2) ? instruction.src2() : r[instruction.src2()];
+    ++_executed;
+    BinaryManipulation_i960_Dispatch(OperationTable[instruction.opcode]);
+Retire:
+    _ip = next;
+    if (tc.template field<InstructionTraceMode>()) {
+        tc.template setField<InstructionTraceEvent>(true);
+        return StopReason::TraceFault;
+    }
+    goto Fetch;
+Unimplemented:
+    return StopReason::Unimplemented;
+Branch:
+    if (!branchTo(_ip + instruction.displacement)) {
+        goto TraceFault;
+    }
+    goto Retire;
+BranchAndLink:
+    r[30] = next; // g14
+    if (!branchTo(_ip + instruction.displacement)) {
+        goto TraceFault;
+    }
+    goto Retire;
+BranchIf:
+    if (conditionHolds(instruction.opcode, conditionCode()) && !branchTo(_ip + instruction.displacement)) {
+        goto TraceFault;
+    }
+    goto Retire;
+BranchIfBit: {
+    // COBR keeps src1 in the src/dst field and its literal bit is M1
+    auto position = instruction.has(M1) ? instruction.srcDest() : r[instruction.srcDest()];
+    auto set = ((r[instruction.src2()] >> (position & 31)) & 1) != 0;
+    setCondition(set ? ConditionEqual : 0);
+    if (set == (instruction.opcode == 0x370) && !branchTo(_ip + instruction.displacement)) {
+        goto TraceFault;
+    }
+    goto Retire;
+}
+CompareOrdinalAndBranch:
+    setCondition(compare(instruction.has(M1) ? Ordinal { instruction.srcDest() } : r[instruction.srcDest()], r[instruction.src2()]));
+    if (conditionHolds(instruction.opcode, conditionCode()) && !branchTo(_ip + instruction.displacement)) {
+        goto TraceFault;
+    }
+    goto Retire;
+CompareIntegerAndBranch:
+    setCondition(compare(static_cast<int32_t>(instruction.has(M1) ? Ordinal { instruction.srcDest() } : r[instruction.srcDest()]),
+                static_cast<int32_t>(r[instruction.src2()])));
+    if (conditionHolds(instruction.opcode, conditionCode()) && !branchTo(_ip + instruction.displacement)) {
+        goto TraceFault;
+    }
+    goto Retire;
+AddOrdinal:
+    dst() = src2 + src1;
+    goto Retire;
+AddInteger: {
+    auto result = static_cast<int64_t>(static_cast<int32_t>(src2)) + static_cast<int32_t>(src1);
+    if (result != static_cast<int32_t>(result) && !overflow()) {
+        return StopReason::ArithmeticFault;
+    }
+    dst() = static_cast<Ordinal>(result);
+    goto Retire;
+}
+SubtractOrdinal:
+    dst() = src2 - src1;
+    goto Retire;
+SubtractInteger: {
+    auto result = static_cast<int64_t>(static_cast<int32_t>(src2)) - static_cast<int32_t>(src1);
+    if (result != static_cast<int32_t>(result) && !overflow()) {
+        return StopReason::ArithmeticFault;
+    }
+    dst() = static_cast<Ordinal>(result);
+    goto Retire;
+}
+MultiplyOrdinal:
+    dst() = src2 * src1;
+    goto Retire;
+And:
+    dst() = src2 & src1;
+    goto Retire;
+Or:
+    dst() = src2 | src1;
+    goto Retire;
+Xor:
+    dst() = src2 ^ src1;
+    goto Retire;
+Not:
+    dst() = ~src1;
+    goto Retire;
+ShiftLeft:
+    dst() = src1 < 32 ? (src2 << src1) : 0;
+    goto Retire;
+ShiftRight:
+    dst() = src1 < 32 ? (src2 >> src1) : 0;
+    goto Retire;
+Move:
+    dst() = src1;
+    goto Retire;
+CompareOrdinal:
+    setCondition(compare(src1, src2));
+    goto Retire;
+CompareInteger:
+    setCondition(compare(static_cast<int32_t>(src1), static_cast<int32_t>(src2)));
+    goto Retire;
+Mark:
+    if (!tc.template field<BreakpointTraceMode>()) {
+        goto Retire;
+    }
+    // otherwise the same as fmark
+ForceMark:
+    tc.template setField<BreakpointTraceEvent>(true);
+    _ip = next;
+    return StopReason::Breakpoint;
+LoadAddress:
+    dst() = effectiveAddress(instruction, _ip, r);
+    goto Retire;
+Load:
+    dst() = loadWord(effectiveAddress(instruction, _ip, r));
+    goto Retire;
+Store:
+    store(effectiveAddress(instruction, _ip, r), dst());
+    goto Retire;
+LoadByte:
+    dst() = loadByte(effectiveAddress(instruction, _ip, r));
+    goto Retire;
+StoreByte:
+    storeByte(effectiveAddress(instruction, _ip, r), static_cast<ByteOrdinal>(dst()));
+    goto Retire;
+BranchExtended:
+    if (!branchTo(effectiveAddress(instruction, _ip, r))) {
+        goto TraceFault;
+    }
+    goto Retire;
+TraceFault:
+    // the branch completes before the fault is taken
+    _ip = next;
+    return StopReason::TraceFault;
+#undef BinaryManipulation_i960_Dispatch
+#ifndef __GNUC__
+#undef BinaryManipulation_i960_Case
+#endif
+}
+
+} // end namespace BinaryManipulation::i960
+#endif // BinaryManipulation_i960Interpreter_h__
@@ -0,0 +1,218 @@
+/**
+ * @file
+ * Streaming i960 decode into a structure of arrays instruction buffer
+ * @copyright
+ * BinaryManipulator
+ * Copyright (c) 2020, Joshua Scoggins
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BinaryManipulation_i960Stream_h__
+#define BinaryManipulation_i960Stream_h__
+#include "BinaryManipulation.h"
+#include "i960.h"
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <vector>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+namespace BinaryManipulation::i960 {
+
+/**
+ * Bit i is set when words[i] would be a two word instruction if one started
+ * there, at most 64 words
+ */
+inline uint64_t longInstructionMask(std::span<const Ordinal> words) noexcept {
+    uint64_t mask = 0;
+    std::size_t i = 0;
+    // a MEM opcode sets bit 31, MEMB bit 12 and the displacement modes are 1xxx and 0101 in bits 13:10,
+    // each condition is moved into the sign bit of its lane
+#ifdef __AVX2__
+    for (; (i + 8) <= words.size(); i += 8) {
+        auto word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words.data() + i));
+        auto ipRelative = _mm256_cmpeq_epi32(_mm256_and_si256(word, _mm256_set1_epi32(0x3C00)), _mm256_set1_epi32(0x1400));
+        auto displacement = _mm256_or_si256(_mm256_slli_epi32(word, 18), ipRelative);
+        auto isLong = _mm256_and_si256(_mm256_and_si256(word, _mm256_slli_epi32(word, 19)), displacement);
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(isLong)))) << i;
+    }
+#elif defined(__SSE2__)
+    for (; (i + 4) <= words.size(); i += 4) {
+        auto word = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words.data() + i));
+        auto ipRelative = _mm_cmpeq_epi32(_mm_and_si128(word, _mm_set1_epi32(0x3C00)), _mm_set1_epi32(0x1400));
+        auto displacement = _mm_or_si128(_mm_slli_epi32(word, 18), ipRelative);
+        auto isLong = _mm_and_si128(_mm_and_si128(word, _mm_slli_epi32(word, 19)), displacement);
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(isLong)))) << i;
+    }
+#endif
+    for (; i < words.size(); ++i) {
+        mask |= static_cast<uint64_t>(instructionLength(words[i]) == 2) << i;
+    }
+    return mask;
+}
+
+/**
+ * The instruction boundaries in a block of 64 words. A word is a
+ * displacement word when it follows an odd length run of would be long
+ * words, the same recurrence as a character escaped by a run of
+ * backslashes, so it is resolved with a carrying add instead of a loop.
+ * carry is set when the first word of the block belongs to the last
+ * instruction of the previous block and is updated for the next block.
+ */
+constexpr uint64_t instructionStartMask(uint64_t longMask, uint64_t& carry) noexcept {
+    constexpr uint64_t EvenBits = 0x5555'5555'5555'5555;
+    longMask &= ~carry;
+    auto followsLong = (longMask << 1) | carry;
+    auto oddStarts = longMask & ~EvenBits & ~followsLong;
+    auto sum = oddStarts + longMask;
+    carry = sum < oddStarts;
+    return ~((EvenBits ^ (sum << 1)) & followsLong);
+}
+static_assert([] { uint64_t carry = 0; return instructionStartMask(0b0110, carry) == ~uint64_t { 0b0100 } && carry == 0; }());
+static_assert([] { uint64_t carry = 0; return instructionStartMask(uint64_t { 1 } << 63, carry) == ~uint64_t { 0 } && carry == 1; }());
+static_assert([] { uint64_t carry = 1; return instructionStartMask(0b0011, carry) == ~uint64_t { 0b0101 } && carry == 0; }());
+
+/**
+ * Decoded instructions stored a field per array so that a pass over one
+ * field only touches that field. position is the word index of the
+ * instruction within its stream.
+ */
+class InstructionBuffer final {
+    public:
+        constexpr std::size_t size() const noexcept { return _size; }
+        constexpr bool empty() const noexcept { return _size == 0; }
+        constexpr void clear() noexcept { _size = 0; }
+        void reserve(std::size_t count) {
+            if (count > _words.size()) {
+                auto capacity = std::max(count, _words.size() * 2);
+                _words.resize(capacity);
+                _displacements.resize(capacity);
+                _positions.resize(capacity);
+                _opcodes.resize(capacity);
+                _formats.resize(capacity);
+                _modes.resize(capacity);
+                _flags.resize(capacity);
+            }
+        }
+        /**
+         * Store an instruction, room must have been reserved for it
+         */
+        void append(const Instruction& instruction, Ordinal position) noexcept {
+            _words[_size] = instruction.word;
+            _displacements[_size] = instruction.displacement;
+            _positions[_size] = position;
+            _opcodes[_size] = instruction.opcode;
+            _formats[_size] = instruction.format;
+            _modes[_size] = instruction.mode;
+            _flags[_size] = instruction.flags;
+            ++_size;
+        }
+        Instruction operator[](std::size_t index) const noexcept {
+            Instruction result { };
+            result.word = _words[index];
+            result.displacement = _displacements[index];
+            result.opcode = _opcodes[index];
+            result.format = _formats[index];
+            result.mode = _modes[index];
+            result.flags = _flags[index];
+            result.length = static_cast<ByteOrdinal>(instructionLength(result.word));
+            return result;
+        }
+        std::span<const Ordinal> words() const noexcept { return { _words.data(), _size }; }
+        std::span<const int32_t> displacements() const noexcept { return { _displacements.data(), _size }; }
+        std::span<const Ordinal> positions() const noexcept { return { _positions.data(), _size }; }
+        std::span<const HalfOrdinal> opcodes() const noexcept { return { _opcodes.data(), _size }; }
+        std::span<const Format> formats() const noexcept { return { _formats.data(), _size }; }
+        std::span<const AddressingMode> modes() const noexcept { return { _modes.data(), _size }; }
+        std::span<const ByteOrdinal> flags() const noexcept { return { _flags.data(), _size }; }
+    private:
+        std::size_t _size = 0;
+        std::vector<Ordinal> _words;
+        std::vector<int32_t> _displacements;
+        std::vector<Ordinal> _positions;
+        std::vector<HalfOrdinal> _opcodes;
+        std::vector<Format> _formats;
+        std::vector<AddressingMode> _modes;
+        std::vector<ByteOrdinal> _flags;
+};
+
+/**
+ * Decodes a code image handed over in pieces of any size. Each block of
+ * 64 words first has its instruction boundaries computed, then only the
+ * words that start an instruction are decoded, so the length of one
+ * instruction never decides a branch. A two word instruction split across
+ * calls is emitted by the call that supplies its displacement.
+ */
+class StreamDecoder final {
+    public:
+        static constexpr std::size_t BlockWords = 64;
+        static constexpr std::size_t PrefetchDistance = 8 * BlockWords;
+    public:
+        void decode(std::span<const Ordinal> words, InstructionBuffer& output);
+        /**
+         * Whether the last word seen started an instruction still waiting on its displacement
+         */
+        constexpr bool pending() const noexcept { return _carry != 0; }
+        /**
+         * Number of words seen so far
+         */
+        constexpr Ordinal position() const noexcept { return _position; }
+        constexpr void reset() noexcept { *this = StreamDecoder { }; }
+    private:
+        Ordinal _position = 0;
+        Ordinal _pendingWord = 0;
+        uint64_t _carry = 0;
+};
+
+inline void StreamDecoder::decode(std::span<const Ordinal> words, InstructionBuffer& output) {
+    if (words.empty()) {
+        return;
+    }
+    output.reserve(output.size() + words.size() + 1);
+    if (_carry) {
+        output.append(decodeInstruction(_pendingWord, words[0]), _position - 1);
+    }
+    auto last = words.size() - 1;
+    for (std::size_t base = 0; base < words.size(); base += BlockWords) {
+        auto count = std::min(BlockWords, words.size() - base);
+#ifdef __GNUC__
+        __builtin_prefetch(words.data() + std::min(base + PrefetchDistance, last));
+#endif
+        auto longMask = longInstructionMask(words.subspan(base, count));
+        auto starts = instructionStartMask(longMask, _carry) & (~uint64_t { 0 } >> (BlockWords - count));
+        if (base + count == words.size()) {
+            // a long instruction in the last word waits for the next call
+            _carry = ((starts & longMask) >> (count - 1)) & 1;
+            starts &= ~(_carry << (count - 1));
+        }
+        for (; starts != 0; starts &= starts - 1) {
+            auto i = base + static_cast<std::size_t>(std::countr_zero(starts));
+            output.append(decodeInstruction(words[i], words[std::min(i + 1, last)]), _position + static_cast<Ordinal>(i));
+        }
+    }
+    _pendingWord = words[last];
+    _position += static_cast<Ordinal>(words.size());
+}
+
+} // end namespace BinaryManipulation::i960
+#endif // BinaryManipulation_i960Stream_h__